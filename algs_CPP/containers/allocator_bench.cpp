@@ -0,0 +1,74 @@
+#include "m_allocator.h"
+#include "m_vector.hpp"
+#include "Timer.h"
+
+#include <cstdio>
+
+using namespace m_std;
+
+// request-scoped workload: every "request" builds a few thousand short-lived
+// vectors of small, varying length, then drops all of them
+constexpr int kRequests          = 200;
+constexpr int kVectorsPerRequest = 2000;
+
+template <typename Vec, typename MakeVec>
+long long run_requests(MakeVec make_vec, void (*end_of_request)(void*), void* ctx)
+{
+    long long checksum = 0;
+    for (int r = 0; r < kRequests; r++)
+    {
+        for (int v = 0; v < kVectorsPerRequest; v++)
+        {
+            Vec vec = make_vec();
+            int len = 1 + (v * 7 + r) % 48;
+            for (int i = 0; i < len; i++)
+            {
+                vec.push_back(i);
+            }
+            checksum += vec[len - 1];
+        }
+        end_of_request(ctx);
+    }
+    return checksum;
+}
+
+void no_op(void*) { }
+void reset_arena(void* a) { static_cast<arena*>(a)->reset(); }
+
+int main()
+{
+    double heap_ms, arena_ms, pool_ms;
+    {
+        Timer t;
+        run_requests<vector<int>>([] { return vector<int>(); }, no_op, nullptr);
+        t.stop();
+        heap_ms = t.getElapsedTime<microseconds>() / 1000.0;
+    }
+    {
+        arena a;
+        Timer t;
+        run_requests<vector<int, arena_allocator<int>>>(
+            [&a] { return vector<int, arena_allocator<int>>(arena_allocator<int>(a)); },
+            reset_arena,
+            &a);
+        t.stop();
+        arena_ms = t.getElapsedTime<microseconds>() / 1000.0;
+    }
+    {
+        fixed_pool p(256);
+        Timer      t;
+        run_requests<vector<int, pool_allocator<int>>>(
+            [&p] { return vector<int, pool_allocator<int>>(pool_allocator<int>(p)); },
+            no_op,
+            nullptr);
+        t.stop();
+        pool_ms = t.getElapsedTime<microseconds>() / 1000.0;
+    }
+
+    std::printf("%d requests x %d vectors\n", kRequests, kVectorsPerRequest);
+    std::printf("global heap : %8.2f ms\n", heap_ms);
+    std::printf("arena       : %8.2f ms  (x%.2f)\n", arena_ms, heap_ms / arena_ms);
+    std::printf("fixed pool  : %8.2f ms  (x%.2f)\n", pool_ms, heap_ms / pool_ms);
+
+    return 0;
+}
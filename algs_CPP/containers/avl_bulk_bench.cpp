@@ -0,0 +1,72 @@
+#include "m_AVLTree.h"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace m_std;
+
+int main(int argc, char** argv)
+{
+    int n = argc > 1 ? std::atoi(argv[1]) : 5000000;
+
+    std::vector<std::pair<int, int>> sorted;
+    sorted.reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        sorted.emplace_back(i * 2, i);
+    }
+
+    // the nightly reload: a sorted dump into an empty tree
+    double insert_ms = time_ms([&] {
+        AVLTree<int, int> tree;
+        for (const auto& kv : sorted)
+        {
+            tree.insert(kv.first, kv.second);
+        }
+    });
+    double hinted_ms = time_ms([&] {
+        AVLTree<int, int> tree;
+        for (const auto& kv : sorted)
+        {
+            tree.insert(tree.end(), kv.first, kv.second);
+        }
+    });
+    double bulk_ms = time_ms([&] {
+        AVLTree<int, int> tree;
+        tree.bulk_load(sorted.begin(), sorted.end());
+    });
+
+    std::printf("AVLTree<int, int>, load %d sorted keys\n", n);
+    std::printf("insert one by one      %9.1f ms\n", insert_ms);
+    std::printf("insert(end(), ...)     %9.1f ms\n", hinted_ms);
+    std::printf("bulk_load              %9.1f ms\n", bulk_ms);
+
+    // an unsorted batch of n / 4 keys, half of them new, into the loaded tree
+    std::mt19937                     rng(1);
+    std::vector<std::pair<int, int>> batch;
+    for (int i = 0; i < n / 4; i++)
+    {
+        batch.emplace_back(int(rng() % unsigned(2 * n)), i);
+    }
+
+    AVLTree<int, int> by_key, merged;
+    by_key.bulk_load(sorted.begin(), sorted.end());
+    merged.bulk_load(sorted.begin(), sorted.end());
+
+    double by_key_ms = time_ms([&] {
+        for (const auto& kv : batch)
+        {
+            by_key.insert(kv.first, kv.second);
+        }
+    });
+    double batch_ms = time_ms([&] { merged.insert_batch(batch.begin(), batch.end()); });
+
+    std::printf("insert %d unsorted keys\n", n / 4);
+    std::printf("insert one by one      %9.1f ms\n", by_key_ms);
+    std::printf("insert_batch           %9.1f ms\n", batch_ms);
+    return by_key.size() == merged.size() ? 0 : 1;
+}
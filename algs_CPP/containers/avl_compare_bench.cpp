@@ -0,0 +1,65 @@
+#include "m_AVLTree.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace m_std;
+
+// keys past the small-string buffer, so a temporary std::string allocates. lookups come
+// as string_views, the way a parser hands them out
+template <typename Tree, typename Lookup>
+double lookups(const std::vector<std::string>& keys, int rounds, Lookup lookup)
+{
+    Tree tree;
+    for (std::size_t i = 0; i < keys.size(); i++)
+    {
+        tree.insert(keys[i], int(i));
+    }
+
+    volatile long long sink = 0;
+    return time_ms([&] {
+        for (int r = 0; r < rounds; r++)
+        {
+            for (std::size_t i = 0; i < keys.size(); i += 7)
+            {
+                std::string_view key = keys[(i * 2654435761ull) % keys.size()];
+                sink                 = sink + lookup(tree, key)->value();
+            }
+        }
+    });
+}
+
+int main(int argc, char** argv)
+{
+    int n      = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < n; i++)
+    {
+        keys.push_back("session/user-" + std::to_string(i * 2654435761ull % unsigned(n)) + "/token");
+    }
+
+    double plain_ms       = 1e30;
+    double transparent_ms = 1e30;
+    for (int i = 0; i < 3; i++)
+    {
+        plain_ms = std::min(plain_ms, lookups<AVLTree<std::string, int>>(keys, rounds, [](auto& tree, std::string_view key) {
+            return tree.find(std::string(key));
+        }));
+        transparent_ms = std::min(transparent_ms, lookups<AVLTree<std::string, int, std::less<>>>(keys, rounds, [](auto& tree, std::string_view key) {
+            return tree.find(key);
+        }));
+    }
+
+    std::printf("AVLTree<std::string, int>, %d keys, find by string_view, best of 3\n", n);
+    std::printf("std::less<std::string> %9.1f ms\n", plain_ms);
+    std::printf("std::less<>            %9.1f ms\n", transparent_ms);
+    return 0;
+}
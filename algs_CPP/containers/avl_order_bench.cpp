@@ -0,0 +1,74 @@
+#include "m_AVLTree.h"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace m_std;
+
+int main(int argc, char** argv)
+{
+    int n       = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int queries = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    AVLTree<int, long long, std::less<int>, aggregate_of<sum_monoid<long long>>> tree;
+    tree.assign_sorted(std::size_t(n), [k = 0]() mutable {
+        k++;
+        return pair<int, long long>(k, k % 100);
+    });
+
+    std::mt19937       rng(3);
+    volatile long long sink = 0;
+
+    // what it took before: walk the iterator to the k-th key, sum a range by walking it
+    double walk_select_ms = time_ms([&] {
+        for (int q = 0; q < queries; q++)
+        {
+            int  k  = int(rng() % unsigned(n));
+            auto it = tree.begin();
+            for (int i = 0; i < k; i++)
+            {
+                ++it;
+            }
+            sink = sink + it->first;
+        }
+    });
+    double walk_sum_ms = time_ms([&] {
+        for (int q = 0; q < queries; q++)
+        {
+            int       lo  = int(rng() % unsigned(n));
+            int       hi  = lo + n / 10;
+            long long sum = 0;
+            for (auto it = tree.begin(); it != tree.end() && it->first <= hi; ++it)
+            {
+                if (it->first >= lo)
+                {
+                    sum += it->second;
+                }
+            }
+            sink = sink + sum;
+        }
+    });
+
+    double select_ms = time_ms([&] {
+        for (int q = 0; q < queries; q++)
+        {
+            sink = sink + tree.select(rng() % unsigned(n))->key();
+        }
+    });
+    double sum_ms = time_ms([&] {
+        for (int q = 0; q < queries; q++)
+        {
+            int lo = int(rng() % unsigned(n));
+            sink   = sink + tree.aggregate_range(lo, lo + n / 10);
+        }
+    });
+
+    std::printf("AVLTree<int, long long> with sums, %d keys, %d queries\n", n, queries);
+    std::printf("k-th key by iterator     %9.2f ms\n", walk_select_ms);
+    std::printf("select(k)                %9.2f ms\n", select_ms);
+    std::printf("range sum by iterator    %9.2f ms\n", walk_sum_ms);
+    std::printf("aggregate_range          %9.2f ms\n", sum_ms);
+    return 0;
+}
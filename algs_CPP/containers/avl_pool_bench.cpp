@@ -0,0 +1,91 @@
+#include "m_AVLTree.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace m_std;
+
+struct result
+{
+    double insert_ms   = 1e300;
+    double erase_ms    = 1e300;
+    double reinsert_ms = 1e300;
+    double find_ms     = 1e300;
+    double teardown_ms = 1e300;
+    double mb          = 0;
+};
+
+// insert n scattered keys, erase every other one, insert them again, look all up, destroy
+template <typename Storage>
+void run(result& best, int n)
+{
+    // a permutation of [0, n): the multiplier is prime
+    auto key = [n](int i) { return int(i * 2654435761ull % unsigned(n)); };
+
+    auto*  tree      = new AVLTree<int, int, std::less<int>, no_augment, Storage>();
+    double insert_ms = time_ms([&] {
+        for (int i = 0; i < n; i++)
+        {
+            tree->insert(key(i), i);
+        }
+    });
+    double erase_ms = time_ms([&] {
+        for (int i = 0; i < n; i += 2)
+        {
+            tree->erase(tree->find(key(i)));
+        }
+    });
+    double reinsert_ms = time_ms([&] {
+        for (int i = 0; i < n; i += 2)
+        {
+            tree->insert(key(i), i);
+        }
+    });
+
+    volatile long long sum     = 0;
+    double             find_ms = time_ms([&] {
+        for (int i = 0; i < n; i++)
+        {
+            sum = sum + tree->find(i)->value();
+        }
+    });
+
+    best.mb            = tree->memory_usage() / 1048576.0;
+    double teardown_ms = time_ms([&] { delete tree; });
+
+    best.insert_ms   = std::min(best.insert_ms, insert_ms);
+    best.erase_ms    = std::min(best.erase_ms, erase_ms);
+    best.reinsert_ms = std::min(best.reinsert_ms, reinsert_ms);
+    best.find_ms     = std::min(best.find_ms, find_ms);
+    best.teardown_ms = std::min(best.teardown_ms, teardown_ms);
+}
+
+void print(const char* name, const result& r)
+{
+    std::printf("%-13s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, r.insert_ms, r.erase_ms, r.reinsert_ms, r.find_ms,
+                r.teardown_ms, r.mb);
+}
+
+int main(int argc, char** argv)
+{
+    int n      = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    // alternate them so none always runs on a heap another left behind
+    result heap, pooled, compact;
+    for (int r = 0; r < rounds; r++)
+    {
+        run<heap_nodes>(heap, n);
+        run<pooled_nodes>(pooled, n);
+        run<compact_nodes>(compact, n);
+    }
+
+    std::printf("AVLTree<int, int>, %d keys, best of %d, times in ms\n", n, rounds);
+    std::printf("%-13s %9s %9s %9s %9s %9s %9s\n", "", "insert", "erase/2", "reinsert", "find", "teardown", "MB");
+    print("heap_nodes", heap);
+    print("pooled_nodes", pooled);
+    print("compact_nodes", compact);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "m_AVLTree.h"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace m_std;
+
+// a sliding time window: keys are timestamps, each step scans the oldest window of k
+// keys and evicts it
+template <typename Evict>
+double run(int n, int k, Evict evict)
+{
+    AVLTree<long long, int> tree;
+    tree.assign_sorted(std::size_t(n), [t = 0ll]() mutable {
+        t += 3;
+        return pair<long long, int>(t, int(t % 1000));
+    });
+
+    volatile long long sink = 0;
+    return time_ms([&] {
+        long long from = 0;
+        while (tree.size() >= std::size_t(k))
+        {
+            long long to    = from + 3ll * k;
+            long long sum   = 0;
+            auto      first = tree.lower_bound(from);
+            auto      last  = tree.lower_bound(to);
+            for (auto it = first; it != last; ++it)
+            {
+                sum += it->second;
+            }
+            sink = sink + sum;
+            evict(tree, first, last);
+            from = to;
+        }
+    });
+}
+
+int main(int argc, char** argv)
+{
+    int n = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    int k = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    using tree_type = AVLTree<long long, int>;
+    using iterator  = tree_type::iterator;
+
+    double by_key_ms = run(n, k, [](tree_type& tree, iterator first, iterator last) {
+        while (first != last)
+        {
+            auto node = first.node();
+            ++first;
+            tree.erase(node);
+        }
+    });
+    double range_ms = run(n, k, [](tree_type& tree, iterator first, iterator last) { tree.erase(first, last); });
+
+    std::printf("AVLTree<long long, int>, %d keys, scan and evict windows of %d\n", n, k);
+    std::printf("erase one by one       %9.1f ms\n", by_key_ms);
+    std::printf("erase(first, last)     %9.1f ms\n", range_ms);
+    return 0;
+}
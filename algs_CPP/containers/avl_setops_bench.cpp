@@ -0,0 +1,93 @@
+#include "m_AVLTree.h"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace m_std;
+
+using tree_type = AVLTree<int, int>;
+
+// n random keys out of [0, 4n), so two trees share about a quarter of them
+tree_type random_tree(std::size_t n, unsigned seed)
+{
+    std::mt19937                     rng(seed);
+    std::vector<std::pair<int, int>> keys(n);
+    for (auto& kv : keys)
+    {
+        kv.first  = int(rng() % (4 * n));
+        kv.second = kv.first;
+    }
+    tree_type tree;
+    tree.insert_batch(keys.begin(), keys.end());
+    return tree;
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t n = argc > 1 ? std::size_t(std::atoll(argv[1])) : 10000000;
+
+    tree_type a = random_tree(n, 1), b = random_tree(n, 2);
+    std::printf("two trees of %zu and %zu int keys, %u hardware threads\n", a.size(), b.size(), std::thread::hardware_concurrency());
+
+    // what it takes without set operations: a lookup and an insert or erase per key
+    double per_key_union_ms = time_ms([&] {
+        tree_type u(a);
+        for (const auto& kv : b)
+        {
+            u.insert(kv.first, kv.second);
+        }
+    });
+    double per_key_diff_ms  = time_ms([&] {
+        tree_type d(a);
+        for (const auto& kv : b)
+        {
+            if (auto node = d.find(kv.first))
+            {
+                d.erase(node);
+            }
+        }
+    });
+    double copy_ms          = time_ms([&] { tree_type c(a); });
+    std::printf("  per key            union %8.1f ms   difference %8.1f ms   (copy of a: %.1f ms, included)\n", per_key_union_ms,
+                per_key_diff_ms, copy_ms);
+
+    // one thread takes the merge, more fork the join recursion
+    for (std::size_t threads : { 1, 2, 4, 8, 16 })
+    {
+        ThreadPool pool(threads);
+        double     union_ms = time_ms([&] {
+            tree_type u(a);
+            u.union_with(b, pool);
+        });
+        double     inter_ms = time_ms([&] {
+            tree_type i(a);
+            i.intersect_with(b, pool);
+        });
+        double     diff_ms  = time_ms([&] {
+            tree_type d(a);
+            d.difference(b, pool);
+        });
+        std::printf("  %2zu threads         union %8.1f ms   intersect %8.1f ms   difference %8.1f ms\n", threads, union_ms, inter_ms,
+                    diff_ms);
+    }
+
+    // a small tree against a big one recurses on one thread, O(m log(n/m + 1))
+    tree_type small    = random_tree(n / 1000, 3);
+    double    small_ms = time_ms([&] {
+        tree_type u(a);
+        u.union_with(small);
+    });
+    std::printf("  union of %zu keys  %8.1f ms (copy included)\n", small.size(), small_ms);
+
+    double split_ms = time_ms([&] {
+        tree_type rest = a.split(int(2 * n));
+        a.join(std::move(rest));
+    });
+    std::printf("  split + join      %8.1f ms (the moved half is copied between pools)\n", split_ms);
+    return 0;
+}
@@ -0,0 +1,905 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_AVLTree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace m_std;
+
+// returns the height, checks links, heights and balance on the way
+template <typename Node, typename Compare>
+int check_subtree(const Node* node, const Compare& comp)
+{
+    if (node == nullptr)
+    {
+        return -1;
+    }
+    int left  = check_subtree(node->left(), comp);
+    int right = check_subtree(node->right(), comp);
+    assert(node->height == 1 + (left > right ? left : right));
+    assert(left - right <= 1 && right - left <= 1);
+    assert(!node->left() || (node->left()->parent() == node && comp(node->left()->key(), node->key())));
+    assert(!node->right() || (node->right()->parent() == node && comp(node->key(), node->right()->key())));
+    return node->height;
+}
+
+template <typename Tree>
+void check_tree(const Tree& tree)
+{
+    auto root = tree.begin().node();
+    while (root && root->parent())
+    {
+        root = root->parent();
+    }
+    check_subtree(root, tree.key_comp());
+    assert(tree.height() == (root ? root->height : -1));
+}
+
+template <typename Tree, typename Reference>
+void check_same(const Tree& tree, const Reference& reference)
+{
+    assert(tree.size() == reference.size());
+    auto it = reference.begin();
+    for (const auto& kv : tree)
+    {
+        assert(it != reference.end() && kv.first == it->first && kv.second == it->second);
+        ++it;
+    }
+    check_tree(tree);
+}
+
+// random inserts and erases against std::map, then copies, moves and clear
+template <typename Storage>
+void random_ops()
+{
+    using tree_type = AVLTree<int, std::string, std::less<int>, no_augment, Storage>;
+
+    std::mt19937               rng(7);
+    tree_type                  tree;
+    std::map<int, std::string> reference;
+    for (int round = 0; round < 20000; round++)
+    {
+        int key = int(rng() % 2000);
+        if (rng() % 3 != 0)
+        {
+            std::string value = "v" + std::to_string(key);
+            tree.insert(key, value);
+            reference.emplace(key, value);
+        }
+        else if (auto node = tree.find(key))
+        {
+            tree.erase(node);
+            reference.erase(key);
+        }
+        else
+        {
+            assert(reference.count(key) == 0);
+        }
+    }
+    check_same(tree, reference);
+
+    tree_type copy(tree);
+    check_same(copy, reference);
+
+    tree_type moved(std::move(copy));
+    check_same(moved, reference);
+    assert(copy.empty());
+
+    copy = moved;
+    check_same(copy, reference);
+
+    moved.clear();
+    assert(moved.empty() && moved.begin() == moved.end() && moved.height() == -1);
+    moved.insert(1, "one");
+    assert(moved.size() == 1 && moved.find(1)->value() == "one");
+}
+
+// bulk_load from a sorted range, insert_batch through both the merge and the per-key path
+template <typename Storage>
+void bulk_ops()
+{
+    using tree_type = AVLTree<int, int, std::less<int>, no_augment, Storage>;
+
+    std::vector<std::pair<int, int>> sorted;
+    for (int i = 0; i < 10000; i++)
+    {
+        sorted.emplace_back(i / 2 * 3, i); // every key twice, the first must win
+    }
+
+    tree_type          tree;
+    std::map<int, int> reference;
+    tree.insert(-5, -5);
+    tree.bulk_load(sorted.begin(), sorted.end());
+    for (const auto& kv : sorted)
+    {
+        reference.emplace(kv.first, kv.second);
+    }
+    check_same(tree, reference);
+    assert(tree.height() == 12); // 5000 keys, perfectly balanced
+
+    std::vector<std::pair<int, int>> unsorted = { { 1, 1 }, { 3, 3 }, { 2, 2 } };
+    bool                             threw    = false;
+    try
+    {
+        tree.bulk_load(unsorted.begin(), unsorted.end());
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    assert(threw);
+    check_same(tree, reference);
+
+    // a big batch merges: existing keys keep their value, the first duplicate wins
+    std::mt19937                     rng(11);
+    std::vector<std::pair<int, int>> batch;
+    for (int i = 0; i < 20000; i++)
+    {
+        batch.emplace_back(int(rng() % 40000), -i);
+    }
+    tree.insert_batch(batch.begin(), batch.end());
+    for (const auto& kv : batch)
+    {
+        reference.emplace(kv.first, kv.second);
+    }
+    check_same(tree, reference);
+
+    // a tiny one goes through insert
+    std::pair<int, int> few[] = { { 40001, 1 }, { -7, 2 }, { 40001, 3 } };
+    tree.insert_batch(few, few + 3);
+    reference.emplace(40001, 1);
+    reference.emplace(-7, 2);
+    check_same(tree, reference);
+
+    tree_type empty;
+    empty.insert_batch(few, few + 3);
+    assert(empty.size() == 2 && empty.find(40001)->value() == 1);
+    empty.bulk_load(few, few); // empty range
+    assert(empty.empty());
+}
+
+// select / rank / count_range / aggregate_range against brute force over std::map, through
+// inserts, erases, batches, set_value and a copy. concatenation checks the key order of a
+// monoid that doesn't commute
+template <typename Storage>
+void augmented_ops()
+{
+    using tree_type = AVLTree<int, std::string, std::less<int>, aggregate_of<sum_monoid<std::string>>, Storage>;
+
+    auto concat = [](const std::map<int, std::string>& m, int lo, int hi) {
+        std::string out;
+        for (auto it = m.lower_bound(lo); it != m.end() && it->first <= hi; ++it)
+        {
+            out += it->second;
+        }
+        return out;
+    };
+
+    auto check = [&](tree_type& tree, const std::map<int, std::string>& reference, std::mt19937& rng) {
+        check_same(tree, reference);
+        std::size_t k = 0;
+        for (const auto& kv : reference)
+        {
+            assert(tree.select(k)->key() == kv.first);
+            assert(tree.rank(kv.first) == k);
+            k++;
+        }
+        assert(tree.select(k) == nullptr);
+        for (int i = 0; i < 200; i++)
+        {
+            int lo = int(rng() % 600) - 50;
+            int hi = int(rng() % 600) - 50;
+            std::size_t count = hi < lo ? 0 : std::distance(reference.lower_bound(lo), reference.upper_bound(hi));
+            assert(tree.count_range(lo, hi) == count);
+            assert(tree.aggregate_range(lo, hi) == concat(reference, lo, hi));
+        }
+    };
+
+    std::mt19937               rng(5);
+    tree_type                  tree;
+    std::map<int, std::string> reference;
+    for (int round = 0; round < 3000; round++)
+    {
+        int key = int(rng() % 500);
+        if (rng() % 4 != 0)
+        {
+            std::string value(1, char('a' + key % 26));
+            tree.insert(key, value);
+            reference.emplace(key, value);
+        }
+        else if (auto node = tree.find(key))
+        {
+            tree.erase(node);
+            reference.erase(key);
+        }
+    }
+    check(tree, reference, rng);
+
+    std::vector<std::pair<int, std::string>> batch;
+    for (int i = 0; i < 400; i++)
+    {
+        batch.emplace_back(int(rng() % 1000) - 250, std::string(1, char('A' + i % 26)));
+    }
+    tree.insert_batch(batch.begin(), batch.end());
+    for (const auto& kv : batch)
+    {
+        reference.emplace(kv.first, kv.second);
+    }
+    check(tree, reference, rng);
+
+    for (int key = 0; key < 500; key += 7)
+    {
+        if (auto node = tree.find(key))
+        {
+            tree.set_value(node, "#");
+            reference[key] = "#";
+        }
+    }
+    tree_type copy(tree);
+    check(copy, reference, rng);
+
+    // a plain size augmentation and a min over numbers
+    AVLTree<int, int, std::less<int>, order_statistics, Storage>              ranks;
+    AVLTree<int, int, std::less<int>, aggregate_of<min_monoid<int>>, Storage> mins;
+    for (int i = 0; i < 1000; i++)
+    {
+        ranks.insert(i * 2, i);
+        mins.insert(i, (i * 37) % 1000);
+    }
+    assert(ranks.select(10)->key() == 20 && ranks.rank(21) == 11 && ranks.count_range(5, 15) == 5);
+    assert(mins.aggregate_range(1, 999) == 1 && mins.aggregate_range(2, 26) == 74);
+    assert(mins.aggregate_range(30, 20) == std::numeric_limits<int>::max());
+}
+
+// bounds, both iteration directions and range erase against std::map; subtree sizes
+// must survive the splits and joins
+template <typename Storage>
+void range_ops()
+{
+    using tree_type = AVLTree<int, int, std::less<int>, order_statistics, Storage>;
+
+    std::mt19937       rng(13);
+    tree_type          tree;
+    std::map<int, int> reference;
+    for (int i = 0; i < 5000; i++)
+    {
+        int key = int(rng() % 20000);
+        tree.insert(key, i);
+        reference.emplace(key, i);
+    }
+
+    for (int i = 0; i < 500; i++)
+    {
+        int  key   = int(rng() % 20100) - 50;
+        auto lower = tree.lower_bound(key);
+        auto upper = tree.upper_bound(key);
+        assert(lower == tree.end() ? reference.lower_bound(key) == reference.end() : lower->first == reference.lower_bound(key)->first);
+        assert(upper == tree.end() ? reference.upper_bound(key) == reference.end() : upper->first == reference.upper_bound(key)->first);
+        auto range = tree.equal_range(key);
+        assert(range.first == lower && range.second == upper);
+        assert((lower != upper) == (reference.count(key) == 1));
+    }
+
+    // backwards from end() and through reverse iterators
+    auto rit = reference.rbegin();
+    for (auto it = tree.end(); it != tree.begin();)
+    {
+        --it;
+        assert(it->first == rit->first);
+        ++rit;
+    }
+    assert(rit == reference.rend());
+    assert(std::equal(tree.rbegin(), tree.rend(), reference.rbegin(), [](const auto& a, const auto& b) { return a.first == b.first; }));
+    const tree_type& const_tree = tree;
+    assert((--const_tree.end())->first == reference.rbegin()->first);
+
+    // windows of every size, including the ends and the whole tree
+    while (!reference.empty())
+    {
+        int lo = int(rng() % 20000);
+        int hi = lo + int(rng() % 2000);
+        if (rng() % 8 == 0)
+        {
+            hi = 30000;
+        }
+        auto last = tree.erase(tree.lower_bound(lo), tree.lower_bound(hi));
+        reference.erase(reference.lower_bound(lo), reference.lower_bound(hi));
+        assert(last == tree.end() ? reference.lower_bound(hi) == reference.end() : last->first == reference.lower_bound(hi)->first);
+        check_same(tree, reference);
+        if (!reference.empty())
+        {
+            assert(tree.select(tree.size() / 2)->key() == std::next(reference.begin(), reference.size() / 2)->first);
+            assert(tree.count_range(lo - 5000, lo + 5000) ==
+                   std::size_t(std::distance(reference.lower_bound(lo - 5000), reference.upper_bound(lo + 5000))));
+        }
+        if (rng() % 4 == 0)
+        {
+            int key = int(rng() % 20000);
+            tree.insert(key, 0);
+            reference.emplace(key, 0);
+        }
+        if (reference.size() < 100)
+        {
+            tree.erase(tree.begin(), tree.end());
+            reference.clear();
+        }
+    }
+    assert(tree.empty() && tree.height() == -1 && tree.begin() == tree.end());
+
+    for (int i = 0; i < 3000; i++)
+    {
+        tree.insert(i, i % 7);
+        reference.emplace(i, i % 7);
+    }
+    assert(tree.erase_if([](const pair<int, int>& kv) { return kv.second == 3; }) == 429);
+    for (auto it = reference.begin(); it != reference.end();)
+    {
+        it = it->second == 3 ? reference.erase(it) : std::next(it);
+    }
+    check_same(tree, reference);
+    assert(tree.erase_if([](const pair<int, int>&) { return false; }) == 0);
+    assert(tree.select(100)->key() == std::next(reference.begin(), 100)->first);
+}
+
+// ordered by a runtime flag, so the comparator is stateful and stored in the tree
+struct ordered_by
+{
+    bool descending = false;
+
+    bool operator()(int a, int b) const { return descending ? b < a : a < b; }
+};
+
+template <typename Storage>
+void compare_ops()
+{
+    {
+        // std::less<> finds, inserts and bounds by string_view and const char* without
+        // building a std::string
+        AVLTree<std::string, int, std::less<>, no_augment, Storage> tree;
+        std::map<std::string, int, std::less<>>                       reference;
+        const char*                                                   words[] = { "pear", "apple", "fig", "kiwi", "plum", "date", "lime" };
+        for (int i = 0; i < 7; i++)
+        {
+            tree.insert(words[i], i);
+            reference.emplace(words[i], i);
+        }
+        assert(tree.insert(std::string_view("fig"), 100)->value() == 2);
+        assert(tree.insert(std::string("fig"), 100)->value() == 2);
+        check_same(tree, reference);
+
+        std::string_view kiwi = std::string_view("a kiwi").substr(2);
+        assert(tree.find(kiwi) && tree.find(kiwi)->value() == 3);
+        assert(tree.find("plum")->value() == 4);
+        assert(tree.find(std::string_view("plu")) == nullptr);
+        assert(tree.lower_bound(std::string_view("g"))->first == "kiwi");
+        assert(tree.upper_bound("lime")->first == "pear");
+        auto range = tree.equal_range(std::string_view("date"));
+        assert(range.first->first == "date" && range.second->first == "fig");
+
+        const auto& const_tree = tree;
+        assert(const_tree.lower_bound("zzz") == const_tree.end());
+        assert(const_tree.equal_range("b").first == const_tree.equal_range("b").second);
+        assert(const_tree.find(kiwi)->value() == 3 && const_tree.find(std::string("date"))->value() == 5);
+        assert(const_tree.find("plu") == nullptr);
+    }
+
+    {
+        // order statistics and aggregates look up by string_view as well
+        AVLTree<std::string, int, std::less<>, aggregate_of<sum_monoid<int>>, Storage> tree;
+        const char*                                                                    words[] = { "pear", "apple", "fig", "kiwi", "plum", "date", "lime" };
+        for (int i = 0; i < 7; i++)
+        {
+            tree.insert(words[i], i);
+        }
+        assert(tree.rank(std::string_view("fig")) == 2 && tree.rank("g") == 3);
+        assert(tree.count_range(std::string_view("b"), std::string_view("kiwi")) == 3);
+        assert(tree.aggregate_range(std::string_view("date"), std::string_view("lime")) == 5 + 2 + 3 + 6);
+        assert(tree.aggregate_range("q", "z") == 0);
+    }
+
+    {
+        // a reversed order runs every operation backwards
+        using tree_type = AVLTree<int, int, std::greater<int>, order_statistics, Storage>;
+
+        std::mt19937                          rng(17);
+        tree_type                             tree;
+        std::map<int, int, std::greater<int>> reference;
+        for (int i = 0; i < 3000; i++)
+        {
+            int key = int(rng() % 5000);
+            if (rng() % 3 == 0)
+            {
+                auto node = tree.find(key);
+                assert((node != nullptr) == (reference.erase(key) == 1));
+                if (node)
+                {
+                    tree.erase(node);
+                }
+            }
+            else
+            {
+                tree.insert(key, i);
+                reference.emplace(key, i);
+            }
+        }
+        check_same(tree, reference);
+        assert(tree.lower_bound(2500)->first == reference.lower_bound(2500)->first);
+        assert(tree.select(0)->key() == reference.begin()->first);
+        assert(tree.rank(2500) == std::size_t(std::distance(reference.begin(), reference.lower_bound(2500))));
+        assert(tree.count_range(4000, 1000) == std::size_t(std::distance(reference.lower_bound(4000), reference.upper_bound(1000))));
+        assert(tree.count_range(1000, 4000) == 0);
+
+        std::vector<std::pair<int, int>> batch;
+        for (int i = 0; i < 2000; i++)
+        {
+            batch.emplace_back(int(rng() % 6000), -i);
+        }
+        tree.insert_batch(batch.begin(), batch.end());
+        reference.insert(batch.begin(), batch.end());
+        check_same(tree, reference);
+
+        tree.erase(tree.lower_bound(3000), tree.lower_bound(2000));
+        reference.erase(reference.lower_bound(3000), reference.lower_bound(2000));
+        check_same(tree, reference);
+
+        std::vector<std::pair<int, int>> descending(reference.begin(), reference.end());
+        tree_type                        loaded;
+        loaded.bulk_load(descending.begin(), descending.end());
+        check_same(loaded, reference);
+        std::reverse(descending.begin(), descending.end());
+        bool thrown = false;
+        try
+        {
+            loaded.bulk_load(descending.begin(), descending.end());
+        }
+        catch (const std::invalid_argument&)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    {
+        // the comparator travels with copies, moves and swaps
+        using tree_type = AVLTree<int, int, ordered_by, no_augment, Storage>;
+
+        tree_type up, down(ordered_by{ true });
+        for (int i = 0; i < 100; i++)
+        {
+            up.insert(i, i);
+            down.insert(i, i);
+        }
+        assert(up.begin()->first == 0 && down.begin()->first == 99);
+        tree_type copy(down);
+        assert(copy.begin()->first == 99 && copy.key_comp().descending);
+        copy = up;
+        assert(copy.begin()->first == 0 && !copy.key_comp().descending);
+        up.swap(down);
+        assert(up.begin()->first == 99 && down.begin()->first == 0);
+        up.insert(150, 0);
+        assert(up.begin()->first == 150);
+        tree_type moved(std::move(up));
+        assert(moved.find(150) && moved.lower_bound(120)->first == 99);
+        check_tree(moved);
+        check_tree(down);
+    }
+}
+
+// counts how many were built, to catch values made for nothing
+struct counted
+{
+    static int built;
+
+    explicit counted(int n) :
+        payload(std::size_t(n), n) { built++; }
+
+    std::vector<int> payload;
+};
+
+int counted::built = 0;
+
+// moving may throw, so a growing compact array copies; copies throw on the countdown
+struct fragile
+{
+    static int copies_left;
+
+    explicit fragile(int v) :
+        value(v) { }
+    fragile(const fragile& other) :
+        value(other.value)
+    {
+        if (copies_left-- == 0)
+        {
+            throw std::runtime_error("fragile copy");
+        }
+    }
+    fragile(fragile&& other) noexcept(false) :
+        value(other.value) { }
+
+    int              value;
+    std::vector<int> heap{ 1, 2, 3 }; // something to leak
+};
+
+int fragile::copies_left = -1;
+
+template <typename Storage>
+void emplace_ops()
+{
+    {
+        AVLTree<int, counted, std::less<int>, no_augment, Storage> tree;
+        for (int i = 0; i < 100; i++)
+        {
+            assert(tree.try_emplace(i, i).second);
+        }
+        counted::built = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            auto result = tree.try_emplace(i, 1000);
+            assert(!result.second && result.first->value().payload.size() == std::size_t(i));
+            assert(tree.try_emplace(tree.end(), i, 1000)->key() == i);
+        }
+        assert(counted::built == 0);
+        assert(tree.try_emplace(-1, 3).second && counted::built == 1);
+    }
+
+    {
+        // move-only values go in by move
+        AVLTree<std::string, std::unique_ptr<int>, std::less<>, no_augment, Storage> tree;
+        std::string key = "a key long enough to live on the heap";
+        auto        ptr = std::make_unique<int>(7);
+        tree.insert(std::move(key), std::move(ptr));
+        assert(!ptr && *tree.find("a key long enough to live on the heap")->value() == 7);
+        assert(tree.try_emplace(std::string("b"), new int(8)).second);
+        assert(tree.try_emplace("c", nullptr).second && tree.size() == 3);
+        assert(tree.insert(tree.end(), std::string("d"), std::make_unique<int>(9))->key() == "d");
+    }
+
+    {
+        // ascending appends at end(), then hints right, wrong and on equal keys
+        using tree_type = AVLTree<int, int, std::less<int>, no_augment, Storage>;
+
+        tree_type          tree;
+        std::map<int, int> reference;
+        for (int i = 0; i < 20000; i += 2)
+        {
+            tree.insert(tree.end(), i, i);
+            reference.emplace(i, i);
+        }
+        check_same(tree, reference);
+
+        std::mt19937 rng(19);
+        for (int i = 0; i < 5000; i++)
+        {
+            int  key  = int(rng() % 24000) - 2000;
+            auto hint = rng() % 2 ? tree.lower_bound(key) : (rng() % 2 ? tree.begin() : tree.end());
+            auto node = tree.insert(hint, key, -key);
+            reference.emplace(key, -key);
+            assert(node->key() == key && node->value() == reference[key]);
+        }
+        check_same(tree, reference);
+
+        // the last node is tracked through erases, range erases, copies and swaps
+        tree.erase(tree.find(reference.rbegin()->first));
+        reference.erase(std::prev(reference.end()));
+        tree.erase(tree.lower_bound(15000), tree.end());
+        reference.erase(reference.lower_bound(15000), reference.end());
+        for (int i = 0; i < 3; i++)
+        {
+            tree.insert(tree.end(), 16000 + i, i);
+            reference.emplace(16000 + i, i);
+        }
+        check_same(tree, reference);
+        tree.erase_if([](const pair<int, int>& kv) { return kv.first >= 16000; });
+        for (auto it = reference.lower_bound(16000); it != reference.end();)
+        {
+            it = reference.erase(it);
+        }
+        tree_type copy(tree), other;
+        other.swap(tree);
+        copy.insert(copy.end(), 17000, 0);
+        other.insert(other.end(), 17000, 0);
+        tree.insert(tree.end(), 1, 1);
+        reference.emplace(17000, 0);
+        check_same(copy, reference);
+        check_same(other, reference);
+        assert(tree.size() == 1 && tree.begin()->first == 1);
+        tree.clear();
+        tree.insert(tree.end(), 5, 5);
+        assert(tree.size() == 1 && tree.find(5));
+    }
+
+    {
+        // an augmented tree still sees every ancestor updated
+        AVLTree<int, int, std::less<int>, order_statistics, Storage> tree;
+        for (int i = 0; i < 5000; i++)
+        {
+            tree.insert(tree.end(), i, i);
+        }
+        check_tree(tree);
+        assert(tree.select(4321)->key() == 4321 && tree.rank(2500) == 2500);
+    }
+}
+
+// split and join, then union, intersection and difference against std::map, through the
+// merge, the join recursion on one thread and the join recursion forked over a pool
+template <typename Storage>
+void set_ops(ThreadPool& pool)
+{
+    using tree_type = AVLTree<int, int, std::less<int>, no_augment, Storage>;
+    using map_type  = std::map<int, int>;
+
+    auto load = [](std::mt19937& rng, int count, int range, int value) {
+        std::pair<tree_type, map_type> result;
+        while (int(result.second.size()) < count)
+        {
+            int key = int(rng() % unsigned(range));
+            result.first.insert(key, value);
+            result.second.emplace(key, value);
+        }
+        return result;
+    };
+
+    std::mt19937 rng(25);
+    {
+        auto [tree, reference] = load(rng, 5000, 20000, 1);
+        for (int key : { -1, 0, 777, 10000, 19999, 30000 })
+        {
+            tree_type rest = tree.split(key);
+            map_type  low(reference.begin(), reference.lower_bound(key));
+            map_type  high(reference.lower_bound(key), reference.end());
+            check_same(tree, low);
+            check_same(rest, high);
+
+            // appends at end() go after the new last node on both sides
+            if (low.count(key - 1) == 0)
+            {
+                tree.insert(tree.end(), key - 1, 0);
+                tree.erase(tree.find(key - 1));
+            }
+            rest.insert(rest.end(), 40000, 0);
+            rest.erase(rest.find(40000));
+
+            bool thrown = false;
+            try
+            {
+                rest.join(tree_type(rest));
+            }
+            catch (const std::invalid_argument&)
+            {
+                thrown = true;
+            }
+            assert(thrown == !rest.empty());
+
+            tree.join(std::move(rest));
+            assert(rest.empty() && rest.begin() == rest.end());
+            check_same(tree, reference);
+        }
+    }
+
+    ThreadPool* pools[] = { nullptr, &pool };
+    struct sizes
+    {
+        int mine, theirs, range;
+    };
+    // comparable sizes merge, a lopsided pair recurses, big ones fork when given a pool
+    for (sizes s : { sizes{ 3000, 3000, 8000 }, sizes{ 20000, 200, 40000 }, sizes{ 100, 20000, 40000 },
+                     sizes{ 0, 500, 1000 }, sizes{ 90000, 80000, 200000 } })
+    {
+        for (ThreadPool* with : pools)
+        {
+            auto [mine, mine_ref]     = load(rng, s.mine, s.range, 1);
+            auto [theirs, theirs_ref] = load(rng, s.theirs, s.range, 2);
+
+            map_type united = mine_ref, shared, only_mine;
+            united.insert(theirs_ref.begin(), theirs_ref.end());
+            for (const auto& kv : mine_ref)
+            {
+                (theirs_ref.count(kv.first) ? shared : only_mine).insert(kv);
+            }
+
+            tree_type a(mine), b(mine), c(mine);
+            assert((with ? a.union_with(theirs, *with) : a.union_with(theirs)) == united.size() - mine_ref.size());
+            assert((with ? b.intersect_with(theirs, *with) : b.intersect_with(theirs)) == only_mine.size());
+            assert((with ? c.difference(theirs, *with) : c.difference(theirs)) == shared.size());
+            check_same(a, united);
+            check_same(b, shared);
+            check_same(c, only_mine);
+            check_same(theirs, theirs_ref);
+
+            // the last node is right after each
+            a.insert(a.end(), s.range, 0);
+            c.insert(c.end(), s.range, 0);
+            assert(std::prev(a.end())->first == s.range && std::prev(c.end())->first == s.range);
+        }
+    }
+
+    {
+        // with itself
+        auto [tree, reference] = load(rng, 1000, 5000, 3);
+        assert(tree.union_with(tree) == 0 && tree.intersect_with(tree) == 0);
+        check_same(tree, reference);
+        assert(tree.difference(tree) == 1000 && tree.empty());
+    }
+
+    {
+        // subtree sizes stay right through the cuts and joins
+        using ranked_type = AVLTree<int, int, std::less<int>, order_statistics, Storage>;
+
+        ranked_type evens, thirds;
+        for (int i = 0; i < 100000; i++)
+        {
+            evens.insert(2 * i, i);
+            thirds.insert(3 * i, i);
+        }
+        ranked_type both(evens);
+        both.intersect_with(thirds, pool);
+        evens.union_with(thirds, pool);
+        check_tree(both);
+        check_tree(evens);
+        assert(both.size() == 33334 && both.select(100)->key() == 600 && both.rank(6000) == 1000);
+        assert(evens.size() == 166666 && evens.rank(12) == 8);
+        ranked_type high = evens.split(150000);
+        assert(evens.rank(149999) == evens.size() && high.select(0)->key() == 150000);
+    }
+}
+
+int main()
+{
+    // accessors instead of reference members, an 8-bit height, 32-bit offsets
+    static_assert(sizeof(void*) != 8 || sizeof(pooled_nodes::node<int, int>) == 40, "pointer layout");
+    static_assert(sizeof(compact_nodes::node<int, int>) == 24, "compact layout");
+
+    random_ops<heap_nodes>();
+    random_ops<pooled_nodes>();
+    random_ops<compact_nodes>();
+
+    bulk_ops<heap_nodes>();
+    bulk_ops<pooled_nodes>();
+    bulk_ops<compact_nodes>();
+
+    augmented_ops<heap_nodes>();
+    augmented_ops<pooled_nodes>();
+    augmented_ops<compact_nodes>();
+
+    range_ops<heap_nodes>();
+    range_ops<pooled_nodes>();
+    range_ops<compact_nodes>();
+
+    compare_ops<heap_nodes>();
+    compare_ops<pooled_nodes>();
+    compare_ops<compact_nodes>();
+
+    emplace_ops<heap_nodes>();
+    emplace_ops<pooled_nodes>();
+    emplace_ops<compact_nodes>();
+
+    ThreadPool pool(4);
+    set_ops<heap_nodes>(pool);
+    set_ops<pooled_nodes>(pool);
+    set_ops<compact_nodes>(pool);
+
+    {
+        // ascending keys grow the array many times; offsets must survive every move
+        AVLTree<int, int, std::less<int>, no_augment, compact_nodes> tree;
+        for (int i = 0; i < 100000; i++)
+        {
+            tree.insert(i, -i);
+        }
+        check_tree(tree);
+        assert(tree.height() <= 17);
+        assert(tree.memory_usage() >= sizeof(tree) + 100000 * 24);
+
+        // erased slots are reused before the array grows again
+        std::size_t reserved = tree.memory_usage();
+        for (int i = 0; i < 100000; i += 2)
+        {
+            tree.erase(tree.find(i));
+        }
+        for (int i = 0; i < 100000; i += 2)
+        {
+            tree.insert(i, -i);
+        }
+        assert(tree.memory_usage() == reserved);
+        check_tree(tree);
+
+        int expected = 0;
+        for (const auto& kv : tree)
+        {
+            assert(kv.first == expected && kv.second == -expected);
+            expected++;
+        }
+        assert(expected == 100000);
+
+        // an existing key needs no room, so it never moves the nodes
+        for (int i = 100000; i < 140000; i++)
+        {
+            std::size_t before = tree.memory_usage();
+            auto        node   = tree.find(7);
+            assert(tree.insert(7, 0) == node && tree.memory_usage() == before);
+            tree.insert(i, -i);
+        }
+
+        // a copy that throws halfway through a grow leaves the old array as it was
+        AVLTree<int, fragile, std::less<int>, no_augment, compact_nodes> frail;
+        std::map<int, int>                                               frail_reference;
+        // the array doubles from one slot, so 128 nodes fill it
+        for (int i = 0; i < 128; i++)
+        {
+            frail.insert(i, fragile(i));
+            frail_reference.emplace(i, i);
+        }
+        std::size_t full = frail.memory_usage();
+        fragile::copies_left = 30;
+        bool thrown          = false;
+        try
+        {
+            frail.insert(-1, fragile(-1));
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        fragile::copies_left = -1;
+        assert(thrown && frail.size() == frail_reference.size() && frail.memory_usage() == full);
+        auto expected_it = frail_reference.begin();
+        for (const auto& kv : frail)
+        {
+            assert(kv.first == expected_it->first && kv.second.value == expected_it->second);
+            ++expected_it;
+        }
+        check_tree(frail);
+        frail.insert(-1, fragile(-1));
+        assert(frail.memory_usage() > full && frail.find(-1)->value().value == -1);
+
+        tree.assign_sorted(5, [k = 0]() mutable {
+            k++;
+            return pair<int, int>(k, k * k);
+        });
+        assert(tree.size() == 5 && tree.find(4)->value() == 16);
+        check_tree(tree);
+    }
+
+    {
+        // keys and values read out of the tree itself, while inserting them grows the
+        // array out from under them
+        using tree_type = AVLTree<std::string, std::string, std::less<std::string>, no_augment, compact_nodes>;
+
+        auto key = [](int i) { return "a key long enough to live on the heap " + std::to_string(i); };
+
+        tree_type                          tree;
+        std::map<std::string, std::string> reference;
+        for (int i = 0; i < 1000; i++)
+        {
+            tree.insert(key(i), key(i + 1000));
+            reference.emplace(key(i), key(i + 1000));
+        }
+        for (int i = 0; i < 1000; i++)
+        {
+            auto node = tree.find(key(i));
+            if (i % 2 == 0)
+            {
+                tree.insert(node->value(), node->key());
+            }
+            else
+            {
+                tree.try_emplace(tree_type::const_iterator(tree.lower_bound(node->key())), node->value(), node->key());
+            }
+            reference.emplace(key(i + 1000), key(i));
+        }
+        check_same(tree, reference);
+    }
+
+    return 0;
+}
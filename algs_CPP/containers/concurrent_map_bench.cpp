@@ -0,0 +1,130 @@
+#include "m_AVLTree.h"
+#include "m_concurrent_map.h"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using namespace m_std;
+
+// what a shared tree needs without this: AVLTree behind a reader-writer lock
+struct locked_tree
+{
+    std::shared_mutex lock;
+    AVLTree<int, int> tree;
+
+    bool find(int key, int& value)
+    {
+        std::shared_lock<std::shared_mutex> guard(lock);
+        auto                                node = tree.find(key);
+        if (node == nullptr)
+        {
+            return false;
+        }
+        value = node->value();
+        return true;
+    }
+
+    void insert_or_assign(int key, int value)
+    {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        auto                                node = tree.find(key);
+        if (node != nullptr)
+        {
+            node->value() = value;
+        }
+        else
+        {
+            tree.insert(key, value);
+        }
+    }
+
+    void erase(int key)
+    {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        auto                                node = tree.find(key);
+        if (node != nullptr)
+        {
+            tree.erase(node);
+        }
+    }
+};
+
+// total operations are fixed and split over the threads; write_percent of them are
+// an assign or an erase of a random key, the rest are lookups
+template <typename Map>
+double run(Map& map, int threads, std::size_t total, int keys, unsigned write_percent)
+{
+    Timer t;
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; w++)
+    {
+        workers.emplace_back([&map, w, threads, total, keys, write_percent] {
+            std::mt19937 rng(unsigned(w) * 7 + 1);
+            long long    sink = 0;
+            for (std::size_t i = w; i < total; i += threads)
+            {
+                int      key = int(rng() % unsigned(2 * keys));
+                unsigned op  = rng() % 100;
+                if (op < write_percent / 2)
+                {
+                    map.erase(key);
+                }
+                else if (op < write_percent)
+                {
+                    map.insert_or_assign(key, int(i));
+                }
+                else
+                {
+                    int value = 0;
+                    sink += map.find(key, value) ? value : 0;
+                }
+            }
+            if (sink == 42)
+            {
+                std::printf(" ");
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    t.stop();
+    return t.getElapsedTime<microseconds>() / 1000.0;
+}
+
+int main(int argc, char** argv)
+{
+    int         keys  = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    std::size_t total = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4000000;
+
+    // half of the key range present
+    concurrent_map<int, int> concurrent;
+    locked_tree              locked;
+    for (int key = 0; key < 2 * keys; key += 2)
+    {
+        concurrent.insert(key, key);
+        locked.tree.insert(key, key);
+    }
+
+    int hardware = int(std::thread::hardware_concurrency());
+    std::printf("%d keys, %zu ops per run, %d hardware threads (Mops/s)\n", keys, total, hardware);
+    for (unsigned write_percent : { 0u, 10u })
+    {
+        std::printf("%u%% writes\n", write_percent);
+        for (int threads : { 1, 2, 4, 8, 16, 32 })
+        {
+            double concurrent_ms = run(concurrent, threads, total, keys, write_percent);
+            double locked_ms     = run(locked, threads, total, keys, write_percent);
+            std::printf("  %2d threads: concurrent_map %7.2f   AVLTree + shared_mutex %7.2f\n", threads, total / concurrent_ms / 1e3,
+                        total / locked_ms / 1e3);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,212 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_concurrent_map.h"
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace m_std;
+
+// counts the copies the map makes of a value
+struct counted
+{
+    static int copies;
+
+    int value = 0;
+
+    counted(int v) :
+        value(v)
+    {
+    }
+
+    counted(const counted& other) :
+        value(other.value)
+    {
+        copies++;
+    }
+
+    counted& operator=(const counted&) = default;
+};
+
+int counted::copies = 0;
+
+// in key order, the same contents as the reference, and balanced once the writers are done
+template <typename Map, typename Reference>
+void check_same(const Map& m, const Reference& reference)
+{
+    assert(m.size() == reference.size());
+    auto it = reference.begin();
+    m.for_each([&](const typename Map::key_type& key, const typename Map::mapped_type& value) {
+        assert(it != reference.end() && key == it->first && value == it->second);
+        ++it;
+    });
+    assert(it == reference.end());
+    assert(m.height() <= int(1.45 * std::log2(double(reference.size()) + 2)) + 1);
+}
+
+int main()
+{
+    // single thread against std::map, routing nodes included
+    {
+        std::mt19937                      rng(23);
+        concurrent_map<int, std::string>  m;
+        std::map<int, std::string>        reference;
+        for (int round = 0; round < 4; round++)
+        {
+            for (int i = 0; i < 30000; i++)
+            {
+                int         key   = int(rng() % 20000);
+                std::string value = std::to_string(i);
+                switch (rng() % 4)
+                {
+                case 0:
+                    assert(m.erase(key) == (reference.erase(key) == 1));
+                    break;
+                case 1:
+                    assert(m.insert_or_assign(key, value) == (reference.count(key) == 0));
+                    reference[key] = value;
+                    break;
+                default:
+                    assert(m.insert(key, value) == reference.emplace(key, value).second);
+                }
+            }
+            check_same(m, reference);
+
+            for (int key = -10; key < 20010; key++)
+            {
+                std::string value;
+                bool        found = m.find(key, value);
+                assert(found == (reference.count(key) == 1) && m.contains(key) == found);
+                assert(!found || value == reference[key]);
+            }
+        }
+        while (!reference.empty())
+        {
+            assert(m.erase(reference.begin()->first));
+            reference.erase(reference.begin());
+        }
+        assert(m.empty() && m.height() == 0 && !m.contains(5));
+    }
+
+    // an insert that finds its key copies nothing; the root alone is one level
+    {
+        concurrent_map<int, counted> m;
+        assert(m.insert(1, counted(10)) && m.height() == 1 && counted::copies == 1);
+        assert(!m.insert(1, counted(11)) && counted::copies == 1);
+        assert(!m.insert_or_assign(1, counted(12)) && counted::copies == 2);
+        counted out(0);
+        assert(m.find(1, out) && out.value == 12);
+    }
+
+    // writers churn their own keys while readers check a set of keys nobody touches
+    {
+        constexpr int kWriters = 3, kReaders = 3, kStable = 2000, kRange = 20000;
+
+        concurrent_map<int, int, std::greater<int>> m;
+        for (int key = 0; key < kStable; key++)
+        {
+            assert(m.insert(key * 10, key));
+        }
+
+        std::atomic<bool>        done{ false };
+        std::vector<std::thread> threads;
+        std::vector<std::map<int, int, std::greater<int>>> written(kWriters);
+        for (int w = 0; w < kWriters; w++)
+        {
+            threads.emplace_back([&m, &written, w] {
+                std::mt19937 rng(100 + w);
+                auto&        mine = written[w];
+                for (int i = 0; i < 60000; i++)
+                {
+                    // keys k with k % 10 == w + 1 belong to writer w
+                    int key = int(rng() % kRange) * 10 + w + 1;
+                    if (rng() % 3 == 0)
+                    {
+                        assert(m.erase(key) == (mine.erase(key) == 1));
+                    }
+                    else
+                    {
+                        assert(m.insert_or_assign(key, i) == (mine.count(key) == 0));
+                        mine[key] = i;
+                    }
+                }
+            });
+        }
+        for (int r = 0; r < kReaders; r++)
+        {
+            threads.emplace_back([&m, &done, r] {
+                std::mt19937 rng(200 + r);
+                while (!done.load())
+                {
+                    for (int i = 0; i < 1000; i++)
+                    {
+                        int key   = int(rng() % kStable);
+                        int value = -1;
+                        assert(m.find(key * 10, value) && value == key);
+                        assert(!m.contains(key * 10 + 5));
+                    }
+                }
+            });
+        }
+        for (int w = 0; w < kWriters; w++)
+        {
+            threads[w].join();
+        }
+        done = true;
+        for (int r = 0; r < kReaders; r++)
+        {
+            threads[kWriters + r].join();
+        }
+
+        std::map<int, int, std::greater<int>> reference;
+        for (int key = 0; key < kStable; key++)
+        {
+            reference[key * 10] = key;
+        }
+        for (const auto& mine : written)
+        {
+            reference.insert(mine.begin(), mine.end());
+        }
+        check_same(m, reference);
+    }
+
+    // inserts racing for the same keys: each key is added exactly once
+    {
+        constexpr int kThreads = 4, kKeys = 20000;
+
+        concurrent_map<int, int> m;
+        std::atomic<int>         added{ 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; t++)
+        {
+            threads.emplace_back([&m, &added, t] {
+                for (int i = 0; i < kKeys; i++)
+                {
+                    int key = (i * 7919 + t * 31) % kKeys;
+                    added += m.insert(key, key);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        assert(added == kKeys && m.size() == std::size_t(kKeys));
+
+        std::map<int, int> reference;
+        for (int key = 0; key < kKeys; key++)
+        {
+            reference[key] = key;
+        }
+        check_same(m, reference);
+    }
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "m_concurrent_vector.h"
+#include "m_vector.hpp"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace m_std;
+
+// what producers did before: one shared vector behind a mutex
+struct locked_vector
+{
+    std::mutex  lock;
+    vector<int> data;
+
+    void push_back(int value)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        data.push_back(value);
+    }
+};
+
+// total appends are fixed, split evenly over the producers
+template <typename Sink>
+double run(int producers, std::size_t total)
+{
+    Sink sink;
+
+    Timer t;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&sink, p, producers, total] {
+            for (std::size_t i = p; i < total; i += producers)
+            {
+                sink.push_back(int(i));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    t.stop();
+
+    return t.getElapsedTime<microseconds>() / 1000.0;
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+
+    int hardware = int(std::thread::hardware_concurrency());
+    std::vector<int> producer_counts = { 1, 2, 4 };
+    if (hardware > 4)
+    {
+        producer_counts.push_back(hardware);
+    }
+
+    std::printf("%zu appends, %d hardware threads\n", total, hardware);
+    for (int producers : producer_counts)
+    {
+        double locked_ms     = run<locked_vector>(producers, total);
+        double concurrent_ms = run<concurrent_vector<int>>(producers, total);
+        std::printf("%2d producers: mutex + vector %8.1f ms (%6.1f M/s), concurrent_vector %8.1f ms (%6.1f M/s)\n", producers,
+                    locked_ms, total / locked_ms / 1e3, concurrent_ms, total / concurrent_ms / 1e3);
+    }
+    return 0;
+}
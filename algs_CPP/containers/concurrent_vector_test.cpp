@@ -0,0 +1,207 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_concurrent_vector.h"
+
+#include <cassert>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace m_std;
+
+// throws when built from a negative number; live counts the objects around
+struct Picky
+{
+    static int live;
+
+    explicit Picky(int v) :
+        value(v)
+    {
+        if (v < 0)
+        {
+            throw v;
+        }
+        live++;
+    }
+    Picky(const Picky& other) :
+        Picky(other.value) { }
+    ~Picky() { live--; }
+
+    int value;
+};
+
+int Picky::live = 0;
+
+// runs out of memory on request
+template <typename T>
+struct failing_allocator : std::allocator<T>
+{
+    static bool fail;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = failing_allocator<U>;
+    };
+
+    T* allocate(std::size_t n)
+    {
+        if (fail)
+        {
+            throw std::bad_alloc();
+        }
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+template <typename T>
+bool failing_allocator<T>::fail = false;
+
+int main()
+{
+    // single thread: indices, segment boundaries, stable references
+    {
+        concurrent_vector<std::string> v;
+        assert(v.push_back("first") == 0);
+        const std::string* first = &v[0];
+        for (int i = 1; i < 1000; i++)
+        {
+            v.emplace_back(std::to_string(i));
+        }
+        assert(&v[0] == first && *first == "first");
+        assert(v.size() == 1000 && v[7] == "7" && v[8] == "8" && v[999] == "999");
+
+        size_t at = v.grow_by(20, "x");
+        assert(at == 1000 && v.size() == 1020 && v[1019] == "x");
+
+        size_t count = 0;
+        for (auto& s : v)
+        {
+            count += !s.empty();
+        }
+        assert(count == 1020);
+
+        bool threw = false;
+        try
+        {
+            v.at(1020);
+        }
+        catch (const std::out_of_range&)
+        {
+            threw = true;
+        }
+        assert(threw);
+
+        v.clear();
+        assert(v.empty());
+        v.push_back("again");
+        assert(v[0] == "again");
+    }
+
+    // a slot whose element never got built is skipped by clear() and the destructor
+    {
+        {
+            concurrent_vector<Picky, failing_allocator<Picky>> v;
+            v.emplace_back(1);
+            bool threw = false;
+            try
+            {
+                v.emplace_back(-1);
+            }
+            catch (int)
+            {
+                threw = true;
+            }
+            assert(threw && v.size() == 2 && Picky::live == 1);
+
+            v.emplace_back(3);
+            threw = false;
+            try
+            {
+                v.grow_by(3, Picky(2));
+                Picky bad(5);
+                bad.value = -5; // copies of it throw
+                v.grow_by(2, bad);
+            }
+            catch (int)
+            {
+                threw = true;
+            }
+            assert(threw && v.size() == 8 && Picky::live == 5 && v[5].value == 2);
+
+            // slot 24 starts a segment that can't be allocated
+            while (v.size() < 24)
+            {
+                v.emplace_back(4);
+            }
+            failing_allocator<Picky>::fail = true;
+            threw                          = false;
+            try
+            {
+                v.emplace_back(6);
+            }
+            catch (const std::bad_alloc&)
+            {
+                threw = true;
+            }
+            failing_allocator<Picky>::fail = false;
+            assert(threw && v.size() == 25);
+            v.emplace_back(7);
+            assert(v[25].value == 7);
+
+            v.clear();
+            assert(Picky::live == 0);
+            v.emplace_back(8);
+        }
+        assert(Picky::live == 0);
+    }
+
+    // many producers: every value lands exactly once
+    {
+        constexpr int kThreads = 4, kPerThread = 20000;
+
+        concurrent_vector<int> v;
+        std::vector<std::thread> producers;
+        for (int t = 0; t < kThreads; t++)
+        {
+            producers.emplace_back([&v, t] {
+                for (int i = 0; i < kPerThread; i++)
+                {
+                    if (i % 100 == 0)
+                    {
+                        // two adjacent slots, filled after reserving
+                        size_t first = v.grow_by(2, -1);
+                        v[first]     = t * kPerThread + i;
+                        v[first + 1] = t * kPerThread + i + 1;
+                        i++;
+                    }
+                    else
+                    {
+                        v.push_back(t * kPerThread + i);
+                    }
+                }
+            });
+        }
+        for (auto& p : producers)
+        {
+            p.join();
+        }
+
+        assert(v.size() == size_t(kThreads) * kPerThread);
+        std::vector<int> seen(kThreads * kPerThread, 0);
+        for (int x : v)
+        {
+            assert(x >= 0 && x < kThreads * kPerThread);
+            seen[x]++;
+        }
+        for (int s : seen)
+        {
+            assert(s == 1);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "m_AVLTree.h"
+#include "m_flat_map.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace m_std;
+
+template <typename Find>
+void lookups(const char* name, const std::vector<int>& probes, Find find)
+{
+    long long sink = 0;
+    double    ms   = 1e30;
+    for (int r = 0; r < 3; r++)
+    {
+        ms = std::min(ms, time_ms([&] {
+                 for (int key : probes)
+                 {
+                     sink += find(key);
+                 }
+             }));
+    }
+    std::printf("  %-28s %7.1f ns/find  %6.1f M finds/s%s\n", name, ms * 1e6 / double(probes.size()),
+                double(probes.size()) / ms / 1000.0, sink == 42 ? " " : "");
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t n = argc > 1 ? std::size_t(std::atoll(argv[1])) : 10000000;
+
+    // even keys 0..2n shuffled, probes half present half absent
+    std::mt19937     rng(11);
+    std::vector<int> keys(n), probes(4000000);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        keys[i] = int(2 * i);
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (int& key : probes)
+    {
+        key = int(rng() % (2 * n));
+    }
+
+    flat_map<int, int> flat;
+    double load_ms = time_ms([&] {
+        for (std::size_t i = 0; i < n; i++)
+        {
+            flat.insert(keys[i], int(i));
+        }
+        flat.commit();
+    });
+    double index_ms = time_ms([&] { flat.use_index(true); });
+    flat.use_index(false);
+
+    AVLTree<int, int> tree;
+    double tree_ms = time_ms([&] {
+        for (std::size_t i = 0; i < n; i++)
+        {
+            tree.insert(keys[i], int(i));
+        }
+    });
+
+    std::printf("%zu int keys, %zu random finds, best of 3\n", n, probes.size());
+    std::printf("  load: flat_map batch + commit %.0f ms, Eytzinger index %.0f ms, AVLTree inserts %.0f ms\n", load_ms, index_ms, tree_ms);
+
+    lookups("flat_map (sorted)", probes, [&](int key) { return flat.find(key) != flat.end(); });
+    flat.use_index(true);
+    lookups("flat_map (Eytzinger)", probes, [&](int key) { return flat.find(key) != flat.end(); });
+    lookups("AVLTree::find", probes, [&](int key) { return tree.find(key) != nullptr; });
+    std::printf("  memory: flat_map %zu MB with index, AVLTree %zu MB\n", flat.memory_usage() >> 20, tree.memory_usage() >> 20);
+    return 0;
+}
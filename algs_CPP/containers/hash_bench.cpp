@@ -0,0 +1,138 @@
+#include "m_AVLTree.h"
+#include "m_unordered_map.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace m_std;
+
+// the three maps behind one face
+template <typename Map>
+struct ops;
+
+template <typename K, typename V>
+struct ops<m_std::unordered_map<K, V>>
+{
+    static void reserve(m_std::unordered_map<K, V>& m, std::size_t n) { m.reserve(n); }
+    static void insert(m_std::unordered_map<K, V>& m, K k, V v) { m.insert(k, v); }
+    static bool find(m_std::unordered_map<K, V>& m, K k) { return m.find(k) != m.end(); }
+    static void erase(m_std::unordered_map<K, V>& m, K k) { m.erase(k); }
+};
+
+template <typename K, typename V>
+struct ops<std::unordered_map<K, V>>
+{
+    static void reserve(std::unordered_map<K, V>& m, std::size_t n) { m.reserve(n); }
+    static void insert(std::unordered_map<K, V>& m, K k, V v) { m.emplace(k, v); }
+    static bool find(std::unordered_map<K, V>& m, K k) { return m.find(k) != m.end(); }
+    static void erase(std::unordered_map<K, V>& m, K k) { m.erase(k); }
+};
+
+template <typename K, typename V>
+struct ops<AVLTree<K, V>>
+{
+    static void reserve(AVLTree<K, V>&, std::size_t) { }
+    static void insert(AVLTree<K, V>& m, K k, V v) { m.insert(k, v); }
+    static bool find(AVLTree<K, V>& m, K k) { return m.find(k) != nullptr; }
+    static void erase(AVLTree<K, V>& m, K k) { m.erase(m.find(k)); }
+};
+
+// keys are even, so a probe with an odd key misses
+template <typename Map>
+void run(const char* name, const std::vector<int>& keys, const std::vector<int>& hits, const std::vector<int>& misses)
+{
+    using O = ops<Map>;
+
+    std::size_t n       = keys.size();
+    std::size_t repeats = n < 1000000 ? 1000000 / n : 1;
+
+    double insert_ms = 0, reserved_ms = 0, hit_ms = 0, miss_ms = 0, erase_ms = 0;
+    long long sink   = 0;
+    for (std::size_t r = 0; r < repeats; r++)
+    {
+        {
+            Map m;
+            O::reserve(m, n);
+            reserved_ms += time_ms([&] {
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    O::insert(m, keys[i], int(i));
+                }
+            });
+        }
+
+        Map m;
+        insert_ms += time_ms([&] {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                O::insert(m, keys[i], int(i));
+            }
+        });
+        if (r == 0)
+        {
+            hit_ms = time_ms([&] {
+                for (int key : hits)
+                {
+                    sink += O::find(m, key);
+                }
+            });
+            miss_ms = time_ms([&] {
+                for (int key : misses)
+                {
+                    sink += O::find(m, key);
+                }
+            });
+        }
+        erase_ms += time_ms([&] {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                O::erase(m, keys[i]);
+            }
+        });
+    }
+
+    double per_op = 1e6 / double(n * repeats);
+    std::printf("  %-22s insert %6.1f  reserved %6.1f  hit %6.1f  miss %6.1f  erase %6.1f   (ns/op)%s\n", name, insert_ms * per_op,
+                reserved_ms * per_op, hit_ms * 1e6 / double(hits.size()), miss_ms * 1e6 / double(misses.size()), erase_ms * per_op,
+                sink == 42 ? " " : "");
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        sizes.push_back(std::size_t(std::atoll(argv[i])));
+    }
+    if (sizes.empty())
+    {
+        sizes = { 1000, 100000, 1000000, 10000000 };
+    }
+
+    for (std::size_t n : sizes)
+    {
+        std::mt19937     rng(9);
+        std::vector<int> keys(n), hits(2000000), misses(2000000);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            keys[i] = int(2 * i);
+        }
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (std::size_t i = 0; i < hits.size(); i++)
+        {
+            hits[i]   = int(2 * (rng() % n));
+            misses[i] = int(2 * (rng() % n) + 1);
+        }
+
+        std::printf("%zu int keys\n", n);
+        run<m_std::unordered_map<int, int>>("m_std::unordered_map", keys, hits, misses);
+        run<std::unordered_map<int, int>>("std::unordered_map", keys, hits, misses);
+        run<AVLTree<int, int>>("AVLTree", keys, hits, misses);
+    }
+    return 0;
+}
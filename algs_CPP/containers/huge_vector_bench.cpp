@@ -0,0 +1,96 @@
+#include "m_mmap_allocator.h"
+#include "m_vector.hpp"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#if !defined(_WIN32)
+#    include <sys/resource.h>
+#    include <sys/wait.h>
+#endif
+
+using namespace m_std;
+
+// the old growth path: fresh buffer, copy, free. no reallocate(), so vector relocates by hand
+template <typename T>
+struct copying_allocator
+{
+    using value_type = T;
+
+    T*   allocate(std::size_t n) { return static_cast<T*>(std::malloc(sizeof(T) * n)); }
+    void deallocate(T* p, std::size_t) noexcept { std::free(p); }
+
+    friend bool operator==(const copying_allocator&, const copying_allocator&) { return true; }
+    friend bool operator!=(const copying_allocator&, const copying_allocator&) { return false; }
+};
+
+// grow one element at a time up to n, timing each regrow separately
+template <typename Vec>
+void grow(const char* name, std::size_t n)
+{
+    double total_ms = 0, worst_regrow_ms = 0;
+    {
+        Vec v;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            if (v.size() == v.capacity())
+            {
+                Timer t;
+                v.push_back(int(i));
+                t.stop();
+                double ms = t.getElapsedTime<nanoseconds>() / 1e6;
+                worst_regrow_ms = ms > worst_regrow_ms ? ms : worst_regrow_ms;
+                total_ms += ms;
+            }
+            else
+            {
+                v.push_back(int(i));
+            }
+        }
+    }
+
+    std::printf("%-28s regrow total %9.2f ms, worst single regrow %9.2f ms", name, total_ms, worst_regrow_ms);
+    std::fflush(stdout);
+}
+
+#if !defined(_WIN32)
+// run each case in its own process so ru_maxrss is that case's peak
+template <typename Vec>
+void run_isolated(const char* name, std::size_t n)
+{
+    std::fflush(stdout); // or the child inherits and re-prints our pending output
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        grow<Vec>(name, n);
+        std::exit(0);
+    }
+
+    int           status = 0;
+    struct rusage usage {};
+    wait4(pid, &status, 0, &usage);
+    std::printf(", peak RSS %7.1f MB (data %7.1f MB)\n", usage.ru_maxrss / 1024.0, n * sizeof(int) / 1048576.0);
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    // default ~1 GB of ints; pass the element count to scale
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (std::size_t(1) << 28);
+
+#if defined(_WIN32)
+    grow<vector<int, copying_allocator<int>>>("copy on grow", n);
+    std::printf("\n");
+    grow<vector<int>>("heap realloc", n);
+    std::printf("\n");
+    grow<huge_vector<int>>("huge_vector (mmap)", n);
+    std::printf("\n");
+#else
+    run_isolated<vector<int, copying_allocator<int>>>("copy on grow", n);
+    run_isolated<vector<int>>("heap realloc", n);
+    run_isolated<huge_vector<int>>("huge_vector (mmap/mremap)", n);
+#endif
+
+    return 0;
+}
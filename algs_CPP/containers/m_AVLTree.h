@@ -1,58 +1,308 @@
 #pragma once
 
+#include "ThreadPool.h"
+#include "m_allocator.h"
 #include "m_pair.h"
+#include "m_stats.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <new>
 #include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 namespace m_std
 {
 
-template <typename Key_t, typename Value_t>
-struct AVLNode
+// how a node finds its neighbours ===========
+
+// plain pointers, nodes can live anywhere
+template <typename Node>
+struct pointer_links
+{
+    Node* left() const { return m_left; }
+    Node* right() const { return m_right; }
+    Node* parent() const { return m_parent; }
+
+    void setLeft(Node* node) { m_left = node; }
+    void setRight(Node* node) { m_right = node; }
+    void setParent(Node* node) { m_parent = node; }
+
+private:
+    Node* m_left   = nullptr;
+    Node* m_right  = nullptr;
+    Node* m_parent = nullptr;
+};
+
+// 32-bit distances, in nodes, from this node to its neighbours; 0 is null. every node of
+// a tree must sit in one array, which may move as a whole since the distances don't change
+template <typename Node>
+struct offset_links
+{
+    Node* left() const { return follow(m_left); }
+    Node* right() const { return follow(m_right); }
+    Node* parent() const { return follow(m_parent); }
+
+    void setLeft(Node* node) { m_left = offsetTo(node); }
+    void setRight(Node* node) { m_right = offsetTo(node); }
+    void setParent(Node* node) { m_parent = offsetTo(node); }
+
+private:
+    Node* self() const { return const_cast<Node*>(static_cast<const Node*>(this)); }
+
+    Node* follow(std::int32_t offset) const { return offset ? self() + offset : nullptr; }
+
+    std::int32_t offsetTo(const Node* node) const { return node ? std::int32_t(node - self()) : 0; }
+
+    std::int32_t m_left   = 0;
+    std::int32_t m_right  = 0;
+    std::int32_t m_parent = 0;
+};
+
+// what a node knows about its subtree ===========
+//
+// an augmentation keeps a `data` in every node, recomputed from the node and its children
+// by update(node). the tree calls it bottom-up wherever a subtree changes: inserts, erases,
+// rotations and bulk builds, one call per node it touches anyway. e.g.
+//
+//   struct max_value
+//   {
+//       struct data { int max = 0; };
+//       template <typename Node> static void update(Node& node) { ... node.left()->aug.max ... }
+//   };
+//
+// a data with a `size` member (the subtree's node count) enables select / rank /
+// count_range, a `monoid` type and a `total` enable aggregate_range
+
+struct no_augment
+{
+    struct data
+    {
+    };
+
+    template <typename Node>
+    static void update(Node& /*node*/)
+    {
+    }
+};
+
+// subtree sizes
+struct order_statistics
+{
+    struct data
+    {
+        std::size_t size = 1;
+    };
+
+    template <typename Node>
+    static std::size_t sizeOf(const Node* node)
+    {
+        return node ? node->aug.size : 0;
+    }
+
+    template <typename Node>
+    static void update(Node& node)
+    {
+        node.aug.size = 1 + sizeOf(node.left()) + sizeOf(node.right());
+    }
+};
+
+// subtree sizes and Monoid folded over the subtree's values in key order. Monoid has a
+// value_type, identity() and an associative combine(a, b); it need not commute
+template <typename Monoid>
+struct aggregate_of
+{
+    using monoid     = Monoid;
+    using value_type = typename Monoid::value_type;
+
+    struct data
+    {
+        std::size_t size  = 1;
+        value_type  total = Monoid::identity();
+    };
+
+    template <typename Node>
+    static value_type totalOf(const Node* node)
+    {
+        return node ? node->aug.total : Monoid::identity();
+    }
+
+    template <typename Node>
+    static void update(Node& node)
+    {
+        node.aug.size  = 1 + order_statistics::sizeOf(node.left()) + order_statistics::sizeOf(node.right());
+        node.aug.total = Monoid::combine(Monoid::combine(totalOf(node.left()), value_type(node.value())), totalOf(node.right()));
+    }
+};
+
+template <typename T>
+struct sum_monoid
+{
+    using value_type = T;
+    static T identity() { return T(); }
+    static T combine(const T& a, const T& b) { return a + b; }
+};
+
+template <typename T>
+struct min_monoid
+{
+    using value_type = T;
+    static T identity() { return std::numeric_limits<T>::max(); }
+    static T combine(const T& a, const T& b) { return b < a ? b : a; }
+};
+
+template <typename T>
+struct max_monoid
+{
+    using value_type = T;
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    static T combine(const T& a, const T& b) { return a < b ? b : a; }
+};
+
+namespace detail
+{
+
+template <typename Augment, typename = void>
+struct has_subtree_size : std::false_type
+{
+};
+
+template <typename Augment>
+struct has_subtree_size<Augment, decltype(void(std::declval<typename Augment::data&>().size))> : std::true_type
+{
+};
+
+template <typename Augment, typename = void>
+struct has_aggregate : std::false_type
+{
+};
+
+template <typename Augment>
+struct has_aggregate<Augment, decltype(void(std::declval<typename Augment::data&>().total), void(typename Augment::monoid()))>
+    : std::true_type
+{
+};
+
+// holds the comparator; an empty one takes no room
+template <typename Compare, bool Empty = std::is_empty<Compare>::value && !std::is_final<Compare>::value>
+class compare_holder : private Compare
+{
+public:
+    compare_holder() = default;
+    explicit compare_holder(const Compare& comp) :
+        Compare(comp) { }
+
+    const Compare& key_comp() const { return *this; }
+
+protected:
+    Compare& compareRef() { return *this; }
+};
+
+template <typename Compare>
+class compare_holder<Compare, false>
+{
+public:
+    compare_holder() = default;
+    explicit compare_holder(const Compare& comp) :
+        m_comp(comp) { }
+
+    const Compare& key_comp() const { return m_comp; }
+
+protected:
+    Compare& compareRef() { return m_comp; }
+
+private:
+    Compare m_comp = Compare();
+};
+
+} // namespace detail
+
+template <typename Key_t, typename Value_t, template <typename> class Links = pointer_links, typename Augment = no_augment>
+struct AVLNode : Links<AVLNode<Key_t, Value_t, Links, Augment>>
 {
 public:
     using pair_type = pair<Key_t, Value_t>;
-    using node_type = AVLNode<Key_t, Value_t>;
+    using node_type = AVLNode<Key_t, Value_t, Links, Augment>;
 
     ~AVLNode() = default;
     AVLNode()  = delete; // must have a key and value
-    template <typename Key_t, typename Value_t>
-    AVLNode(Key_t&& k, Value_t&& v) :
-        kv_pair(std::forward<Key_t>(k), std::forward<Value_t>(v))
+
+    // compact_nodes moves nodes when it grows
+    AVLNode(const AVLNode&) = default;
+    AVLNode(AVLNode&&)      = default;
+    template <typename K, typename V, typename = typename std::enable_if<!std::is_same<typename std::decay<K>::type, std::piecewise_construct_t>::value>::type>
+    AVLNode(K&& k, V&& v) :
+        kv_pair(std::forward<K>(k), std::forward<V>(v))
     {
     }
 
-    int getBalanceFactor() const
+    // the key, then the arguments the value is built from in place
+    template <typename K, typename... Args>
+    AVLNode(std::piecewise_construct_t, K&& k, Args&&... args) :
+        kv_pair(std::piecewise_construct, std::forward<K>(k), std::forward<Args>(args)...)
     {
-        int leftHeight  = (left ? left->height : -1);
-        int rightHeight = (right ? right->height : -1);
+    }
+
+    // an empty subtree has height -1, a leaf 0
+    static int heightOf(const node_type* node)
+    {
+        return node ? node->height : -1;
+    }
 
-        return leftHeight - rightHeight;
+    int getBalanceFactor() const
+    {
+        return heightOf(this->left()) - heightOf(this->right());
     }
 
+    const Key_t&   key() const { return kv_pair.first; }
+    Value_t&       value() { return kv_pair.second; }
+    const Value_t& value() const { return kv_pair.second; }
+
     // C++ impl wont replace the value for same key;
     pair<Key_t, Value_t> kv_pair;
-    Key_t&               key   = kv_pair.first;
-    Value_t&             value = kv_pair.second;
 
-    int height = 0;
+    // an AVL tree of 2^32 nodes is at most 46 high
+    std::int8_t height = 0;
 
-    node_type* left   = nullptr;
-    node_type* right  = nullptr;
-    node_type* parent = nullptr;
+    typename Augment::data aug;
 };
 
 // iterator ===========
 
-template <typename Key_t, typename Value_t>
+// bidirectional. besides the node it remembers where the tree keeps its root, so that
+// end() can step back to the last key
+template <typename Node_t, bool IsConst = false>
 class AVLIterator
 {
 public:
-    using node_type = typename AVLNode<Key_t, Value_t>::node_type;
-    using pair_type = typename AVLNode<Key_t, Value_t>::pair_type;
+    using node_type = typename std::conditional<IsConst, const Node_t, Node_t>::type;
+    using pair_type = typename std::conditional<IsConst, const typename Node_t::pair_type, typename Node_t::pair_type>::type;
+
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type        = typename Node_t::pair_type;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = pair_type*;
+    using reference         = pair_type&;
 
     AVLIterator() = default;
-    AVLIterator(node_type* node) :
-        m_current(node) { }
+    AVLIterator(node_type* node, Node_t* const* root = nullptr) :
+        m_current(node), m_root(root) { }
+
+    // iterator -> const_iterator
+    template <bool OtherConst, typename = typename std::enable_if<IsConst && !OtherConst>::type>
+    AVLIterator(const AVLIterator<Node_t, OtherConst>& other) :
+        m_current(other.node()), m_root(other.rootSlot())
+    {
+    }
+
+    node_type*     node() const { return m_current; }
+    Node_t* const* rootSlot() const { return m_root; }
 
     // prefix increment
     AVLIterator& operator++()
@@ -69,6 +319,20 @@ public:
         return _tmp;
     }
 
+    // from end() to the last key
+    AVLIterator& operator--()
+    {
+        m_current = m_current ? predecessor(m_current) : maximum(*m_root);
+        return *this;
+    }
+
+    AVLIterator operator--(int)
+    {
+        AVLIterator _tmp = *this;
+        --*this;
+        return _tmp;
+    }
+
     friend bool operator==(const AVLIterator& thisIter, const AVLIterator& other)
     {
         return thisIter.m_current == other.m_current;
@@ -97,490 +361,2331 @@ public:
             return nullptr;
         }
 
-        if (thisNode->right != nullptr)
+        if (thisNode->right() != nullptr)
         {
-            return minimum(thisNode->right);
+            return minimum(thisNode->right());
         }
 
         // go up until as a left child
-        auto _currNode = thisNode;
-        while (_currNode->parent
-               && _currNode != _currNode->parent->left)
+        node_type* _currNode = thisNode;
+        while (_currNode->parent()
+               && _currNode != _currNode->parent()->left())
         {
-            _currNode = _currNode->parent;
+            _currNode = _currNode->parent();
         }
 
         // if it hits the root, or thisNode is a left child of the successor we want;
-        return _currNode->parent;
+        return _currNode->parent();
     }
 
-    node_type* minimum(node_type* thisNode) const
+    // the mirror of successor
+    node_type* predecessor(node_type* thisNode) const
     {
-        node_type* _curr_node = thisNode;
+        if (thisNode->left() != nullptr)
+        {
+            return maximum(thisNode->left());
+        }
 
-        while (_curr_node->left != nullptr)
+        node_type* _currNode = thisNode;
+        while (_currNode->parent()
+               && _currNode != _currNode->parent()->right())
         {
-            _curr_node = _curr_node->left;
+            _currNode = _currNode->parent();
         }
 
-        return _curr_node;
+        return _currNode->parent();
     }
 
-private:
-    node_type* m_current = nullptr;
-};
-
-//================================================================================================
-template <typename Key_t, typename Value_t>
-class AVLTree
-{
-public:
-    using pair_type = typename AVLNode<Key_t, Value_t>::pair_type;
-    using Node_type = typename AVLNode<Key_t, Value_t>::node_type;
-
-public:
-    AVLTree() = default;
-    ~AVLTree()
+    node_type* minimum(node_type* thisNode) const
     {
-        // delete nodes by post-order traversal
-        deleteNode(m_root);
-    }
+        node_type* _curr_node = thisNode;
 
-    void deleteNode(Node_type* thisNode)
-    {
-        if (thisNode == nullptr)
+        while (_curr_node->left() != nullptr)
         {
-            return;
+            _curr_node = _curr_node->left();
         }
 
-        deleteNode(thisNode->left);
-        deleteNode(thisNode->right);
-
-        delete thisNode;
+        return _curr_node;
     }
 
-    Node_type* insert(const Key_t& key, const Value_t& value)
+    node_type* maximum(node_type* thisNode) const
     {
-        Node_type* _parent    = nullptr;
-        Node_type* _curr_node = m_root;
+        node_type* _curr_node = thisNode;
 
-        while (_curr_node != nullptr)
+        while (_curr_node != nullptr && _curr_node->right() != nullptr)
         {
-            _parent = _curr_node;
-            if (_curr_node->key > key)
-            {
-                _curr_node = _curr_node->left;
-            }
-            else if (_curr_node->key < key)
-            {
-                _curr_node = _curr_node->right;
-            }
-            else
-            {
-                return _curr_node;
-            }
+            _curr_node = _curr_node->right();
         }
 
-        // if _curr_node is nullptr insert new;
-        // be careful when assign to a local ptr
+        return _curr_node;
+    }
 
-        std::cout << "inserted: " << value << std::endl;
-        Node_type* _newNode = new Node_type(key, value);
-        _newNode->parent    = _parent;
+private:
+    node_type*     m_current = nullptr;
+    Node_t* const* m_root    = nullptr;
+};
 
-        // root case  cant access to member
-        if (_parent == nullptr)
-        {
-            m_root = _newNode;
-        }
-        else if (_parent->key > key)
-        {
-            _parent->left = _newNode;
-        }
-        else if (_parent->key < key)
-        {
-            _parent->right = _newNode;
-        }
+// where the nodes live ===========
 
-        updateHeightAndBalanceUpwards(_parent);
+// a policy names the node layout and a storage for it. call storage::prepare(n, root)
+// before n creates: it makes room up front, so only prepare may move nodes (only
+// compact_nodes ever does, and says so with moves_nodes), and it points root at the
+// moved root node. every live node must hang under root then
 
-        return _newNode;
-    }
+// one operator new per node
+struct heap_nodes
+{
+    template <typename Key_t, typename Value_t, typename Augment = no_augment>
+    using node = AVLNode<Key_t, Value_t, pointer_links, Augment>;
 
-private:
-    void updateHeightAndBalanceUpwards(Node_type* thisNode)
+    template <typename Node>
+    class storage
     {
-        auto _curr_node = thisNode;
+    public:
+        static constexpr bool bulk_release = false;
+        static constexpr bool moves_nodes  = false;
 
-        while (_curr_node != nullptr)
+        void prepare(std::size_t /*n*/, Node*& /*root*/) { }
+
+        template <typename... Args>
+        Node* create(Args&&... args)
         {
-            _curr_node->height = 1 + std::max((_curr_node->left ? _curr_node->left->height : 0), (_curr_node->right ? _curr_node->right->height : 0));
+            return new Node(std::forward<Args>(args)...);
+        }
 
-            int balanceFactor = _curr_node->getBalanceFactor();
+        void destroy(Node* node) noexcept { delete node; }
+        void release_all() noexcept { }
 
-            // debug:
-            if (balanceFactor > 1 || balanceFactor < -1)
-            {
-                std::cout << "balance happens at node: " << _curr_node->key << std::endl;
-            }
-            // four cases;
-            if (balanceFactor > 1)
-            {
-                // L
-                if (_curr_node->left->getBalanceFactor() > 0)
-                {
-                    _curr_node = right_rotate(_curr_node);
-                }
-                // LR
-                else
-                {
-                    _curr_node->left = left_rotate(_curr_node->left);
-                    _curr_node       = right_rotate(_curr_node);
-                }
-            }
-            else if (balanceFactor < -1)
-            {
-                // RR
-                if (_curr_node->right->getBalanceFactor() < 0)
-                {
-                    _curr_node = left_rotate(_curr_node);
-                }
-                // RL
-                else
-                {
-                    _curr_node->right = right_rotate(_curr_node->right);
-                    _curr_node        = left_rotate(_curr_node);
-                }
-            }
+        std::size_t bytes_reserved(std::size_t live_nodes) const { return live_nodes * sizeof(Node); }
+    };
+};
 
-            _curr_node = _curr_node->parent;
-        }
-    }
+// nodes are carved out of slabs that double from 64 to 4k nodes. an erased node goes
+// on a free list and is reused by the next insert, neighbours in insertion order sit
+// next to each other, and teardown frees whole slabs instead of walking every node
+struct pooled_nodes
+{
+    static constexpr std::size_t first_slab_nodes = 64;
+    static constexpr std::size_t max_slab_nodes   = std::size_t(1) << 12;
 
-    Node_type* left_rotate(Node_type* pivot)
-    {
-        if (pivot == nullptr)
-        {
-            return nullptr;
-        }
+    template <typename Key_t, typename Value_t, typename Augment = no_augment>
+    using node = AVLNode<Key_t, Value_t, pointer_links, Augment>;
 
-        auto _right  = pivot->right;
-        auto _parent = pivot->parent;
+    template <typename Node>
+    class storage
+    {
+        static_assert(alignof(Node) <= alignof(std::max_align_t), "fixed_pool blocks are max_align_t aligned");
 
-        // std::cout << "thisNode: " << pivot->value << std::endl;
-        // std::cout << "pivot right: " << (_right ? _right->value : -1) << std::endl;
-        // std::cout << "pivot parent: " << (_parent ? _parent->value : -1) << std::endl;
+    public:
+        static constexpr bool bulk_release = true;
+        static constexpr bool moves_nodes  = false;
 
-        pivot->right = _right->left;
-        if (pivot->right)
+        storage() :
+            m_pool(sizeof(Node), first_slab_nodes, max_slab_nodes)
         {
-            pivot->right->parent = pivot;
         }
 
-        _right->left  = pivot;
-        pivot->parent = _right;
+        void prepare(std::size_t /*n*/, Node*& /*root*/) { }
 
-        _right->parent = _parent;
-        if (_parent)
+        template <typename... Args>
+        Node* create(Args&&... args)
         {
-            if (_parent->left == pivot)
+            void* _block = m_pool.allocate();
+            try
             {
-                _parent->left = _right;
+                return ::new (_block) Node(std::forward<Args>(args)...);
             }
-            else
+            catch (...)
             {
-                _parent->right = _right;
+                m_pool.deallocate(_block);
+                throw;
             }
         }
-        else
+
+        void destroy(Node* node) noexcept
         {
-            m_root = _right;
+            node->~Node();
+            m_pool.deallocate(node);
         }
 
-        updateHeight(pivot);
-        updateHeight(_right);
+        // every node must already be destroyed, or not need it
+        void release_all() noexcept { m_pool.release(); }
 
-        return _right;
-    }
+        std::size_t bytes_reserved(std::size_t /*live_nodes*/) const { return m_pool.bytes_reserved(); }
 
-    Node_type* right_rotate(Node_type* pivot)
+    private:
+        fixed_pool m_pool;
+    };
+};
+
+// every node in one growing array, linked by 32-bit offsets and an 8-bit height:
+// AVLTree<int, int> needs 24 bytes a node instead of 40, and a lookup walks one block of
+// memory. growing the array moves the nodes, so node pointers and iterators are only
+// good until the next insert. erased slots are reused, teardown frees the array at once
+struct compact_nodes
+{
+    template <typename Key_t, typename Value_t, typename Augment = no_augment>
+    using node = AVLNode<Key_t, Value_t, offset_links, Augment>;
+
+    template <typename Node>
+    class storage
     {
-        if (pivot == nullptr)
+    public:
+        static constexpr bool bulk_release = true;
+        static constexpr bool moves_nodes  = true;
+
+        storage() = default;
+
+        storage(const storage&)            = delete;
+        storage& operator=(const storage&) = delete;
+
+        storage(storage&& other) noexcept :
+            m_nodes(other.m_nodes), m_capacity(other.m_capacity), m_used(other.m_used), m_free(other.m_free),
+            m_free_count(other.m_free_count)
         {
-            return nullptr;
+            other.forget();
         }
-        auto _left   = pivot->left;
-        auto _parent = pivot->parent;
 
-        pivot->left = _left->right;
-        if (pivot->left)
+        storage& operator=(storage&& other) noexcept
         {
-            pivot->left->parent = pivot;
+            if (this != &other)
+            {
+                release_all();
+                m_nodes      = other.m_nodes;
+                m_capacity   = other.m_capacity;
+                m_used       = other.m_used;
+                m_free       = other.m_free;
+                m_free_count = other.m_free_count;
+                other.forget();
+            }
+            return *this;
         }
 
-        _left->right  = pivot;
-        pivot->parent = _left;
+        // nodes must be destroyed by then
+        ~storage() { release_all(); }
 
-        _left->parent = _parent;
-        if (_parent)
+        void prepare(std::size_t n, Node*& root)
         {
-            if (_parent->left == pivot)
+            std::size_t _fresh = n > m_free_count ? n - m_free_count : 0;
+            if (m_used + _fresh > m_capacity)
             {
-                _parent->left = _left;
+                std::size_t _root = root ? std::size_t(root - m_nodes) : 0;
+                grow(std::max(m_used + _fresh, m_capacity * 2), root);
+                root = root ? m_nodes + _root : nullptr;
             }
-            else
+        }
+
+        template <typename... Args>
+        Node* create(Args&&... args)
+        {
+            if (m_free == no_slot && m_used == m_capacity)
+            {
+                throw std::logic_error("compact_nodes: create without prepare");
+            }
+
+            if (m_free == no_slot)
+            {
+                Node* _node = ::new (static_cast<void*>(m_nodes + m_used)) Node(std::forward<Args>(args)...);
+                m_used++;
+                return _node;
+            }
+
+            // the constructor overwrites the free list link
+            std::uint32_t _slot = m_free;
+            std::uint32_t _next = nextFree(_slot);
+            try
+            {
+                Node* _node = ::new (static_cast<void*>(m_nodes + _slot)) Node(std::forward<Args>(args)...);
+                m_free      = _next;
+                m_free_count--;
+                return _node;
+            }
+            catch (...)
             {
-                _parent->right = _left;
+                setNextFree(_slot, _next);
+                throw;
             }
         }
-        else
+
+        void destroy(Node* node) noexcept
         {
-            m_root = _left;
+            std::uint32_t _slot = std::uint32_t(node - m_nodes);
+            node->~Node();
+            setNextFree(_slot, m_free);
+            m_free = _slot;
+            m_free_count++;
         }
 
-        updateHeight(pivot);
-        updateHeight(_left);
+        void release_all() noexcept
+        {
+            ::operator delete(m_nodes);
+            forget();
+        }
 
-        return _left;
-    }
+        std::size_t bytes_reserved(std::size_t /*live_nodes*/) const { return m_capacity * sizeof(Node); }
 
-private:
-    void updateHeight(Node_type* thisNode)
-    {
-        if (thisNode == nullptr)
+    private:
+        static_assert(alignof(Node) <= alignof(std::max_align_t), "the array comes from operator new");
+        static_assert(sizeof(Node) >= sizeof(std::uint32_t), "a free slot holds the next free index");
+
+        static constexpr std::uint32_t no_slot   = std::uint32_t(-1);
+        static constexpr std::size_t   max_nodes = std::size_t(INT32_MAX);
+
+        void forget() noexcept
         {
-            return;
+            m_nodes      = nullptr;
+            m_capacity   = 0;
+            m_used       = 0;
+            m_free       = no_slot;
+            m_free_count = 0;
         }
 
-        if (thisNode->left == nullptr && thisNode->right == nullptr)
+        // a free slot keeps the index of the next one in its first bytes
+        std::uint32_t nextFree(std::uint32_t slot) const
         {
-            thisNode->height = 0;
-            return;
+            std::uint32_t _next;
+            std::memcpy(&_next, m_nodes + slot, sizeof(_next));
+            return _next;
         }
-        else
+
+        void setNextFree(std::uint32_t slot, std::uint32_t next) { writeNextFree(m_nodes, slot, next); }
+
+        // through void*: the slot is raw memory, not a Node
+        static void writeNextFree(Node* nodes, std::uint32_t slot, std::uint32_t next)
         {
-            thisNode->height = 1 + std::max((thisNode->left ? thisNode->left->height : 0), (thisNode->right ? thisNode->right->height : 0));
-            return;
+            std::memcpy(static_cast<void*>(nodes + slot), &next, sizeof(next));
         }
-    }
 
-public:
-    void erase(Node_type* node)
-    {
-        if (node == nullptr)
+        // fn(slot) for every node under top, parents first
+        template <typename Fn>
+        void forEachSlot(const Node* top, Fn& fn) const
         {
-            return;
+            if (top != nullptr)
+            {
+                fn(std::size_t(top - m_nodes));
+                forEachSlot(top->left(), fn);
+                forEachSlot(top->right(), fn);
+            }
         }
 
-        auto _parent_of_deleted = node->parent;
-
-        // 2x2 = 4 cases
-        // case 1
-        if ((node->left == nullptr) && (node->right == nullptr))
+        // live nodes keep their index, so their offsets stay right. every live node hangs
+        // under root, so the tree walk finds them and the free list is followed into the
+        // same slots of the new array: no pass over the slots and no side table
+        void grow(std::size_t capacity, const Node* root)
         {
-            if (node->parent)
+            if (capacity > max_nodes)
             {
-                if (node->parent->left == node)
-                {
-                    node->parent->left = nullptr;
-                }
-                else if (node->parent->right == node)
+                if (m_used >= max_nodes)
                 {
-                    node->parent->right = nullptr;
+                    throw std::length_error("compact_nodes: more than 2^31 nodes");
                 }
+                capacity = max_nodes;
             }
-            delete node;
-        }
-        // case 2
-        else if ((node->left == nullptr) && (node->right != nullptr))
-        {
-            transplant(node, node->right);
-        }
-        else if ((node->left != nullptr) && (node->right == nullptr))
-        {
-            transplant(node, node->left);
-        }
-        // case 3
-        else if ((node->left != nullptr) && (node->right != nullptr))
-        {
-            auto _successor = minimum(node->right);
 
-            swap(node->kv_pair, _successor->kv_pair);
-            erase(_successor);
-        }
+            Node* _nodes = static_cast<Node*>(::operator new(capacity * sizeof(Node)));
+
+            std::size_t _moved = 0;
+            auto        _move  = [this, _nodes, &_moved](std::size_t slot) {
+                ::new (static_cast<void*>(_nodes + slot)) Node(std::move_if_noexcept(m_nodes[slot]));
+                _moved++;
+            };
+            try
+            {
+                forEachSlot(root, _move);
+            }
+            catch (...)
+            {
+                // the same walk reaches the built ones first
+                auto _undo = [_nodes, &_moved](std::size_t slot) {
+                    if (_moved > 0)
+                    {
+                        _nodes[slot].~Node();
+                        _moved--;
+                    }
+                };
+                forEachSlot(root, _undo);
+                ::operator delete(_nodes);
+                throw;
+            }
+
+            for (std::uint32_t _slot = m_free; _slot != no_slot; _slot = nextFree(_slot))
+            {
+                writeNextFree(_nodes, _slot, nextFree(_slot));
+            }
+
+            auto _destroy = [this](std::size_t slot) { m_nodes[slot].~Node(); };
+            forEachSlot(root, _destroy);
+            ::operator delete(m_nodes);
+            m_nodes    = _nodes;
+            m_capacity = capacity;
+        }
+
+    private:
+        Node*         m_nodes      = nullptr;
+        std::size_t   m_capacity   = 0;
+        std::size_t   m_used       = 0; // slots ever handed out, live or free
+        std::uint32_t m_free       = no_slot;
+        std::size_t   m_free_count = 0;
+    };
+};
+
+//================================================================================================
+// Compare orders the keys; a transparent one (std::less<> and the like) lets find, insert
+// and the bounds take any key type it can compare with Key_t, e.g. a string_view for a
+// std::string key, without building a Key_t. Augment keeps per-subtree data in the nodes
+// (no_augment, order_statistics, aggregate_of). NodeStorage decides where nodes are
+// allocated: pooled_nodes (default), heap_nodes or compact_nodes. Stats is an
+// instrumentation policy (m_stats.h), a no-op unless asked for. comparator, storage and
+// stats are bases so the stateless ones take no room
+template <typename Key_t, typename Value_t, typename Compare = std::less<Key_t>, typename Augment = no_augment,
+          typename NodeStorage = pooled_nodes, typename Stats = default_stats>
+class AVLTree : private NodeStorage::template storage<typename NodeStorage::template node<Key_t, Value_t, Augment>>,
+                public detail::compare_holder<Compare>,
+                private Stats
+{
+public:
+    using Node_type    = typename NodeStorage::template node<Key_t, Value_t, Augment>;
+    using pair_type    = typename Node_type::pair_type;
+    using key_compare  = Compare;
+    using augment_type = Augment;
+    using stats_type   = Stats;
+
+    using detail::compare_holder<Compare>::key_comp;
+
+    using iterator               = AVLIterator<Node_type>;
+    using const_iterator         = AVLIterator<Node_type, true>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+private:
+    using node_storage   = typename NodeStorage::template storage<Node_type>;
+    using compare_holder = detail::compare_holder<Compare>;
+
+    // overloads that take K only exist for a transparent Compare
+    template <typename K>
+    using if_transparent = typename std::enable_if<detail::is_transparent<Compare>::value && !std::is_same<K, Key_t>::value &&
+                                                   !std::is_convertible<K, const_iterator>::value>::type;
+
+public:
+    AVLTree() = default;
+
+    explicit AVLTree(const Compare& comp) :
+        compare_holder(comp)
+    {
+    }
+    ~AVLTree()
+    {
+        destroyAll();
+    }
+
+    // copies keep the shape, no rebalancing needed
+    AVLTree(const AVLTree& other) :
+        node_storage(), compare_holder(other.key_comp())
+    {
+        nodes().prepare(other.m_size, m_root);
+        m_root = cloneNode(other.m_root, nullptr);
+        resetRightmost();
+        stats_ref().on_copy();
+    }
+
+    AVLTree& operator=(const AVLTree& other)
+    {
+        if (this != &other)
+        {
+            AVLTree _copy(other);
+            swap(_copy);
+            stats_ref().on_copy();
+        }
+        return *this;
+    }
+
+    AVLTree(AVLTree&& other) noexcept :
+        node_storage(std::move(other.nodes())), compare_holder(other.key_comp()), m_root(other.m_root),
+        m_rightmost(other.m_rightmost), m_size(other.m_size)
+    {
+        other.m_root      = nullptr;
+        other.m_rightmost = nullptr;
+        other.m_size      = 0;
+        stats_ref().on_move();
+    }
+
+    AVLTree& operator=(AVLTree&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroyAll();
+            swap(other);
+            stats_ref().on_move();
+        }
+        return *this;
+    }
+
+    // nodes, their storage and the comparator change hands, stats stay with the object
+    void swap(AVLTree& other) noexcept
+    {
+        std::swap(nodes(), other.nodes());
+        std::swap(this->compareRef(), other.compareRef());
+        std::swap(m_root, other.m_root);
+        std::swap(m_rightmost, other.m_rightmost);
+        std::swap(m_size, other.m_size);
+    }
+
+    void deleteNode(Node_type* thisNode)
+    {
+        if (thisNode == nullptr)
+        {
+            return;
+        }
+
+        deleteNode(thisNode->left());
+        deleteNode(thisNode->right());
+
+        destroyNode(thisNode);
+    }
+
+    void clear()
+    {
+        destroyAll();
+        reportShape();
+    }
+
+    // replaces the contents with n pairs that next() returns in strictly ascending key
+    // order. O(n) with no comparisons: the middle pair becomes the root and each half is
+    // built the same way, so the result is balanced by construction. if next() throws
+    // the tree is left empty
+    template <typename Next>
+    void assign_sorted(std::size_t n, Next&& next)
+    {
+        clear();
+        nodes().prepare(n, m_root);
+        m_root = buildSorted(n, next);
+        if (m_root != nullptr)
+        {
+            m_root->setParent(nullptr);
+        }
+        resetRightmost();
+        reportShape();
+    }
+
+    // replaces the contents with [first, last), key/value pairs sorted by key, in O(n).
+    // of equal keys the first wins, as with insert. reads the range twice, so forward
+    // iterators at least; throws std::invalid_argument, before touching the tree, when
+    // the range is out of order
+    template <typename It>
+    void bulk_load(It first, It last)
+    {
+        std::size_t _n = 0;
+        for (It _it = first; _it != last; _n++)
+        {
+            _it = skipEqualKeys(_it, last);
+        }
+
+        It _it = first;
+        assign_sorted(_n, [this, &_it, last] {
+            It _kv = _it;
+            _it    = skipEqualKeys(_it, last);
+            return pair_type(_kv->first, _kv->second);
+        });
+    }
+
+    // inserts [first, last), key/value pairs in any order. a batch that isn't tiny next to
+    // the tree is sorted, merged with the tree in key order and rebuilt balanced: O(n + m log m)
+    // with no rotations, instead of O(m log n) and a rebalance walk per key. keys already in
+    // the tree win, then the first of equal keys in the batch, as with insert. if anything
+    // throws the tree is unchanged
+    template <typename It>
+    void insert_batch(It first, It last)
+    {
+        std::vector<pair_type> _batch;
+        for (; first != last; ++first)
+        {
+            _batch.emplace_back(first->first, first->second);
+        }
+
+        if (batchIsSmall(_batch.size()))
+        {
+            for (const pair_type& _kv : _batch)
+            {
+                insert(_kv.first, _kv.second);
+            }
+            return;
+        }
+
+        std::stable_sort(_batch.begin(), _batch.end(), [this](const pair_type& a, const pair_type& b) { return keyLess(a.first, b.first); });
+
+        const AVLTree&   _self  = *this;
+        const pair_type* _begin = _batch.data();
+        const pair_type* _end   = _batch.data() + _batch.size();
+
+        // assign_sorted wants the count up front
+        std::size_t _n = 0;
+        for (MergeCursor _cursor{ key_comp(), _self.begin(), _self.end(), _begin, _end }; !_cursor.done(); _cursor.next())
+        {
+            _n++;
+        }
+
+        AVLTree     _merged(key_comp());
+        MergeCursor _cursor{ key_comp(), _self.begin(), _self.end(), _begin, _end };
+        _merged.assign_sorted(_n, [&_cursor] { return _cursor.next(); });
+
+        std::size_t _old_size = m_size;
+        swap(_merged);
+        stats_ref().on_deallocate(_old_size * sizeof(Node_type));
+        stats_ref().on_allocate(m_size * sizeof(Node_type));
+        reportShape();
+    }
+
+    std::size_t size() const { return m_size; }
+    bool        empty() const { return m_size == 0; }
+
+    const Stats& stats() const { return *this; }
+
+    // bytes owned by this tree: the object plus the node storage
+    std::size_t memory_usage() const { return sizeof(*this) + nodes().bytes_reserved(m_size); }
+
+private:
+    Stats&              stats_ref() { return *this; }
+    node_storage&       nodes() { return *this; }
+    const node_storage& nodes() const { return *this; }
+
+    template <typename... Args>
+    Node_type* createNode(Args&&... args)
+    {
+        Node_type* _node = nodes().create(std::forward<Args>(args)...);
+        m_size++;
+        stats_ref().on_allocate(sizeof(Node_type));
+        return _node;
+    }
+
+    void destroyNode(Node_type* node)
+    {
+        nodes().destroy(node);
+        m_size--;
+        stats_ref().on_deallocate(sizeof(Node_type));
+    }
+
+    // run the destructors only, the storage takes the memory back in bulk
+    void destructNode(Node_type* thisNode)
+    {
+        if (thisNode == nullptr)
+        {
+            return;
+        }
+
+        destructNode(thisNode->left());
+        destructNode(thisNode->right());
+
+        thisNode->~Node_type();
+    }
+
+    void destroyAll()
+    {
+        if constexpr (node_storage::bulk_release)
+        {
+            if constexpr (!std::is_trivially_destructible<Node_type>::value)
+            {
+                destructNode(m_root);
+            }
+            nodes().release_all();
+            stats_ref().on_deallocate(m_size * sizeof(Node_type));
+            m_size = 0;
+        }
+        else
+        {
+            // delete nodes by post-order traversal
+            deleteNode(m_root);
+        }
+        m_root      = nullptr;
+        m_rightmost = nullptr;
+    }
+
+    Node_type* cloneNode(const Node_type* node, Node_type* parent)
+    {
+        if (node == nullptr)
+        {
+            return nullptr;
+        }
+
+        Node_type* _copy = createNode(node->key(), node->value());
+        _copy->height    = node->height;
+        _copy->aug       = node->aug;
+        _copy->setParent(parent);
+        try
+        {
+            _copy->setLeft(cloneNode(node->left(), _copy));
+            _copy->setRight(cloneNode(node->right(), _copy));
+        }
+        catch (...)
+        {
+            deleteNode(_copy);
+            throw;
+        }
+        return _copy;
+    }
+
+    void reportShape()
+    {
+        stats_ref().on_shape(m_size, Node_type::heightOf(m_root));
+    }
+
+    // the first element after it with a greater key
+    template <typename It>
+    It skipEqualKeys(It it, It last) const
+    {
+        It _next = it;
+        ++_next;
+        while (_next != last && !keyLess(it->first, _next->first))
+        {
+            if (keyLess(_next->first, it->first))
+            {
+                throw std::invalid_argument("AVLTree::bulk_load: range is not sorted");
+            }
+            ++_next;
+        }
+        return _next;
+    }
+
+    // per-key inserts cost about m log n, a merge about n
+    bool batchIsSmall(std::size_t m) const { return isLopsided(m, m_size); }
+
+    // whether m log n work on the smaller side beats a pass over the n of the larger
+    static bool isLopsided(std::size_t m, std::size_t n)
+    {
+        std::size_t _log = 1;
+        while ((std::size_t(1) << _log) < n)
+        {
+            _log++;
+        }
+        return m * _log < n;
+    }
+
+    // walks the tree and a sorted batch together in key order, dropping batch keys that
+    // are already in the tree or repeat within the batch
+    struct MergeCursor
+    {
+        const Compare&   comp;
+        const_iterator   tree;
+        const_iterator   tree_end;
+        const pair_type* batch;
+        const pair_type* batch_end;
+
+        bool done() const { return tree == tree_end && batch == batch_end; }
+
+        const pair_type& next()
+        {
+            bool             _from_tree = batch == batch_end || (tree != tree_end && !comp(batch->first, tree->first));
+            const pair_type& _kv        = _from_tree ? *tree++ : *batch++;
+            while (batch != batch_end && !comp(_kv.first, batch->first))
+            {
+                ++batch;
+            }
+            return _kv;
+        }
+    };
+
+    // in-order: left subtree, this node, right subtree, so next() is called in key order
+    template <typename Next>
+    Node_type* buildSorted(std::size_t n, Next& next)
+    {
+        if (n == 0)
+        {
+            return nullptr;
+        }
+
+        Node_type* _left = buildSorted(n / 2, next);
+        Node_type* _node = nullptr;
+        try
+        {
+            pair_type _kv = next();
+            _node         = createNode(std::move(_kv.first), std::move(_kv.second));
+        }
+        catch (...)
+        {
+            deleteNode(_left);
+            throw;
+        }
+
+        _node->setLeft(_left);
+        if (_left)
+        {
+            _left->setParent(_node);
+        }
+
+        try
+        {
+            _node->setRight(buildSorted(n - n / 2 - 1, next));
+        }
+        catch (...)
+        {
+            deleteNode(_node);
+            throw;
+        }
+        if (_node->right())
+        {
+            _node->right()->setParent(_node);
+        }
+
+        updateNode(_node);
+        return _node;
+    }
+
+public:
+
+    Node_type* insert(const Key_t& key, const Value_t& value)
+    {
+        return try_emplace(key, value).first;
+    }
+
+    Node_type* insert(Key_t&& key, Value_t&& value)
+    {
+        return try_emplace(std::move(key), std::move(value)).first;
+    }
+
+    // a Key_t is built from key only when it is new
+    template <typename K, typename = if_transparent<K>>
+    Node_type* insert(const K& key, const Value_t& value)
+    {
+        return try_emplace(key, value).first;
+    }
+
+    // hint is where the key would go: the first node with a greater key, or end(). with a
+    // right hint the insert skips the descent, which makes appends at end() amortized O(1);
+    // a wrong hint only costs the check
+    Node_type* insert(const_iterator hint, const Key_t& key, const Value_t& value)
+    {
+        return try_emplace(hint, key, value);
+    }
+
+    Node_type* insert(const_iterator hint, Key_t&& key, Value_t&& value)
+    {
+        return try_emplace(hint, std::move(key), std::move(value));
+    }
+
+    // if key is absent, adds it with a value built from args in place; if it is there,
+    // args are left untouched. returns the node with key and whether it is new
+    template <typename... Args>
+    std::pair<Node_type*, bool> try_emplace(const Key_t& key, Args&&... args)
+    {
+        return emplaceKey(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<Node_type*, bool> try_emplace(Key_t&& key, Args&&... args)
+    {
+        return emplaceKey(std::move(key), std::forward<Args>(args)...);
+    }
+
+    template <typename K, typename... Args, typename = if_transparent<K>>
+    std::pair<Node_type*, bool> try_emplace(const K& key, Args&&... args)
+    {
+        return emplaceKey(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    Node_type* try_emplace(const_iterator hint, const Key_t& key, Args&&... args)
+    {
+        return emplaceHinted(hint, key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    Node_type* try_emplace(const_iterator hint, Key_t&& key, Args&&... args)
+    {
+        return emplaceHinted(hint, std::move(key), std::forward<Args>(args)...);
+    }
+
+private:
+    template <typename K, typename... Args>
+    std::pair<Node_type*, bool> emplaceKey(K&& key, Args&&... args)
+    {
+        // one comparison per level. _not_greater ends as the largest key <= key, which is
+        // the equal one if there is one
+        Node_type* _parent      = nullptr;
+        Node_type* _not_greater = nullptr;
+        Node_type* _curr_node   = m_root;
+        bool       _go_left     = false;
+
+        while (_curr_node != nullptr)
+        {
+            _parent  = _curr_node;
+            _go_left = keyLess(key, _curr_node->key());
+            if (_go_left)
+            {
+                _curr_node = _curr_node->left();
+            }
+            else
+            {
+                _not_greater = _curr_node;
+                _curr_node   = _curr_node->right();
+            }
+        }
+
+        if (_not_greater != nullptr && !keyLess(_not_greater->key(), key))
+        {
+            return { _not_greater, false };
+        }
+
+        return { linkNew(_parent, _go_left, std::forward<K>(key), std::forward<Args>(args)...), true };
+    }
+
+    template <typename K, typename... Args>
+    Node_type* emplaceHinted(const_iterator hint, K&& key, Args&&... args)
+    {
+        // the key goes between the hint and the node before it; that one is the
+        // rightmost node for end(), else at most a walk down the hint's left subtree
+        Node_type* _next = const_cast<Node_type*>(hint.node());
+        Node_type* _prev = _next ? predecessorOf(_next) : m_rightmost;
+        if (_next != nullptr && !keyLess(key, _next->key()))
+        {
+            if (!keyLess(_next->key(), key))
+            {
+                return _next;
+            }
+            return emplaceKey(std::forward<K>(key), std::forward<Args>(args)...).first;
+        }
+        if (_prev != nullptr && !keyLess(_prev->key(), key))
+        {
+            if (!keyLess(key, _prev->key()))
+            {
+                return _prev;
+            }
+            return emplaceKey(std::forward<K>(key), std::forward<Args>(args)...).first;
+        }
+
+        // one of the two has a free slot on the facing side
+        if (_next != nullptr && _next->left() == nullptr)
+        {
+            return linkNew(_next, true, std::forward<K>(key), std::forward<Args>(args)...);
+        }
+        return linkNew(_prev, false, std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    Node_type* predecessorOf(Node_type* node) const
+    {
+        if (node->left() != nullptr)
+        {
+            Node_type* _curr_node = node->left();
+            while (_curr_node->right() != nullptr)
+            {
+                _curr_node = _curr_node->right();
+            }
+            return _curr_node;
+        }
+        while (node->parent() != nullptr && node == node->parent()->left())
+        {
+            node = node->parent();
+        }
+        return node->parent();
+    }
+
+    // hangs a new node under parent, nullptr for an empty tree, and rebalances. room is
+    // made here, once the key is known to be new, so finding an existing key never moves
+    // the nodes
+    template <typename K, typename... Args>
+    Node_type* linkNew(Node_type* parent, bool as_left, K&& key, Args&&... args)
+    {
+        if constexpr (node_storage::moves_nodes)
+        {
+            // key and args may point into the array that making room moves: the pair is
+            // built first, parent is found again by its place in the array
+            pair_type      _kv(std::piecewise_construct, makeKey(std::forward<K>(key)), std::forward<Args>(args)...);
+            std::ptrdiff_t _parent_at = parent ? parent - m_root : 0;
+            Node_type*     _old_root  = m_root;
+            nodes().prepare(1, m_root);
+            if (m_root != _old_root)
+            {
+                parent = parent ? m_root + _parent_at : nullptr;
+                resetRightmost();
+            }
+            return attachNew(parent, as_left, createNode(std::move(_kv.first), std::move(_kv.second)));
+        }
+        else
+        {
+            return attachNew(parent, as_left,
+                             createNode(std::piecewise_construct, makeKey(std::forward<K>(key)), std::forward<Args>(args)...));
+        }
+    }
+
+    Node_type* attachNew(Node_type* parent, bool as_left, Node_type* node)
+    {
+        node->setParent(parent);
+        updateNode(node);
+
+        if (parent == nullptr)
+        {
+            m_root = node;
+        }
+        else if (as_left)
+        {
+            parent->setLeft(node);
+        }
+        else
+        {
+            parent->setRight(node);
+        }
+        if (parent == m_rightmost && !as_left)
+        {
+            m_rightmost = node;
+        }
+
+        rebalanceAfterInsert(parent);
+        reportShape();
+
+        return node;
+    }
+
+    void resetRightmost()
+    {
+        m_rightmost = m_root ? maximum(m_root) : nullptr;
+    }
+
+    static const Key_t& makeKey(const Key_t& key) { return key; }
+    static Key_t&&      makeKey(Key_t&& key) { return std::move(key); }
+
+    template <typename K, typename = typename std::enable_if<!std::is_same<typename std::decay<K>::type, Key_t>::value>::type>
+    static Key_t makeKey(const K& key)
+    {
+        return Key_t(key);
+    }
+
+    template <typename A, typename B>
+    bool keyLess(const A& a, const B& b) const
+    {
+        return key_comp()(a, b);
+    }
+
+    void updateHeightAndBalanceUpwards(Node_type* thisNode)
+    {
+        if (thisNode != nullptr)
+        {
+            m_root = rebalanceUpwards(thisNode);
+        }
+    }
+
+    // fixes heights, augmentation and balance from thisNode up to the top of its tree,
+    // which may be a detached subtree, and returns that top
+    Node_type* rebalanceUpwards(Node_type* thisNode)
+    {
+        Node_type* _curr_node = thisNode;
+        Node_type* _top       = thisNode;
+
+        while (_curr_node != nullptr)
+        {
+            updateNode(_curr_node);
+            _curr_node = rebalanceNode(_curr_node);
+            _top       = _curr_node;
+            _curr_node = _curr_node->parent();
+        }
+        return _top;
+    }
+
+    // after an insert, a node whose height did not change, or that one rotation brought
+    // back to it, leaves everything above as it was: the walk stops there, so inserts
+    // cost amortized O(1) past the descent. augmented trees still go to the root
+    void rebalanceAfterInsert(Node_type* thisNode)
+    {
+        if constexpr (!std::is_empty<typename Augment::data>::value)
+        {
+            updateHeightAndBalanceUpwards(thisNode);
+        }
+        else
+        {
+            Node_type* _curr_node = thisNode;
+            while (_curr_node != nullptr)
+            {
+                int _old_height = _curr_node->height;
+                updateNode(_curr_node);
+
+                Node_type* _top = rebalanceNode(_curr_node);
+                if (_top != _curr_node || _top->height == _old_height)
+                {
+                    if (_top->parent() == nullptr)
+                    {
+                        m_root = _top;
+                    }
+                    return;
+                }
+                _curr_node = _top->parent();
+            }
+        }
+    }
+
+    // one rotation, or two, if node is out of balance; returns the top of its subtree
+    Node_type* rebalanceNode(Node_type* node)
+    {
+        int balanceFactor = node->getBalanceFactor();
+
+        // four cases;
+        if (balanceFactor > 1)
+        {
+            // LL; a balanced child only happens after an erase and needs a single rotation too
+            if (node->left()->getBalanceFactor() >= 0)
+            {
+                return right_rotate(node);
+            }
+            // LR
+            node->setLeft(left_rotate(node->left()));
+            return right_rotate(node);
+        }
+        if (balanceFactor < -1)
+        {
+            // RR
+            if (node->right()->getBalanceFactor() <= 0)
+            {
+                return left_rotate(node);
+            }
+            // RL
+            node->setRight(right_rotate(node->right()));
+            return left_rotate(node);
+        }
+        return node;
+    }
+
+    // rotations keep the parent's link, a subtree top stays parentless
+
+    Node_type* left_rotate(Node_type* pivot)
+    {
+        if (pivot == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto _right  = pivot->right();
+        auto _parent = pivot->parent();
+        stats_ref().on_rotation();
+
+        pivot->setRight(_right->left());
+        if (pivot->right())
+        {
+            pivot->right()->setParent(pivot);
+        }
+
+        _right->setLeft(pivot);
+        pivot->setParent(_right);
+
+        _right->setParent(_parent);
+        if (_parent)
+        {
+            if (_parent->left() == pivot)
+            {
+                _parent->setLeft(_right);
+            }
+            else
+            {
+                _parent->setRight(_right);
+            }
+        }
+
+        updateNode(pivot);
+        updateNode(_right);
+
+        return _right;
+    }
+
+    Node_type* right_rotate(Node_type* pivot)
+    {
+        if (pivot == nullptr)
+        {
+            return nullptr;
+        }
+        auto _left   = pivot->left();
+        auto _parent = pivot->parent();
+        stats_ref().on_rotation();
+
+        pivot->setLeft(_left->right());
+        if (pivot->left())
+        {
+            pivot->left()->setParent(pivot);
+        }
+
+        _left->setRight(pivot);
+        pivot->setParent(_left);
+
+        _left->setParent(_parent);
+        if (_parent)
+        {
+            if (_parent->left() == pivot)
+            {
+                _parent->setLeft(_left);
+            }
+            else
+            {
+                _parent->setRight(_left);
+            }
+        }
+
+        updateNode(pivot);
+        updateNode(_left);
+
+        return _left;
+    }
+
+private:
+    // height and augmentation from the children
+    void updateNode(Node_type* thisNode)
+    {
+        if (thisNode == nullptr)
+        {
+            return;
+        }
+
+        thisNode->height = std::int8_t(1 + std::max(Node_type::heightOf(thisNode->left()), Node_type::heightOf(thisNode->right())));
+        Augment::update(*thisNode);
+    }
+
+public:
+    void erase(Node_type* node)
+    {
+        if (node == nullptr)
+        {
+            return;
+        }
+
+        auto _parent_of_deleted = node->parent();
+        bool _was_rightmost     = node == m_rightmost;
+
+        // 2x2 = 4 cases
+        // case 1
+        if ((node->left() == nullptr) && (node->right() == nullptr))
+        {
+            if (node->parent())
+            {
+                if (node->parent()->left() == node)
+                {
+                    node->parent()->setLeft(nullptr);
+                }
+                else if (node->parent()->right() == node)
+                {
+                    node->parent()->setRight(nullptr);
+                }
+            }
+            else
+            {
+                m_root = nullptr;
+            }
+            destroyNode(node);
+        }
+        // case 2
+        else if ((node->left() == nullptr) && (node->right() != nullptr))
+        {
+            transplant(node, node->right());
+        }
+        else if ((node->left() != nullptr) && (node->right() == nullptr))
+        {
+            transplant(node, node->left());
+        }
+        // case 3
+        else if ((node->left() != nullptr) && (node->right() != nullptr))
+        {
+            auto _successor = minimum(node->right());
+
+            using std::swap; // the member swap would hide pair's
+            swap(node->kv_pair, _successor->kv_pair);
+            erase(_successor);
+        }
 
         updateHeightAndBalanceUpwards(_parent_of_deleted);
+        if (_was_rightmost)
+        {
+            resetRightmost();
+        }
+        reportShape();
+    }
+
+private:
+    void transplant(Node_type* thisNode, Node_type* child)
+    {
+        // check either is nullptr
+        if (thisNode == nullptr || child == nullptr)
+        {
+            return;
+        }
+
+        auto _grandParent = thisNode->parent();
+        if (_grandParent == nullptr)
+        {
+            m_root = child;
+        }
+        else if (_grandParent->right() == thisNode)
+        {
+            _grandParent->setRight(child);
+        }
+        else if (_grandParent->left() == thisNode)
+        {
+            _grandParent->setLeft(child);
+        }
+        child->setParent(_grandParent);
+
+        destroyNode(thisNode);
+    }
+
+public:
+    // new : iterative version
+    // the C++ impl wont replace for same key;
+    // one comparison per level down to the lower bound, then one for equality
+    Node_type* find(const Key_t& key)
+    {
+        return findNode(key);
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    Node_type* find(const K& key)
+    {
+        return findNode(key);
+    }
+
+    const Node_type* find(const Key_t& key) const
+    {
+        return findNode(key);
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    const Node_type* find(const K& key) const
+    {
+        return findNode(key);
+    }
+
+private:
+    template <typename K>
+    Node_type* findNode(const K& key) const
+    {
+        Node_type* _candidate = lowerBound(key);
+        return _candidate != nullptr && !keyLess(key, _candidate->key()) ? _candidate : nullptr;
+    }
+
+public:
+
+    // assigns a node's value and refreshes the augmentation up to the root; assigning
+    // through value() leaves aggregates stale
+    template <typename V>
+    void set_value(Node_type* node, V&& value)
+    {
+        node->kv_pair.second = std::forward<V>(value);
+        for (; node != nullptr; node = node->parent())
+        {
+            Augment::update(*node);
+        }
+    }
+
+    // order statistics, O(log n) with an augmentation that keeps subtree sizes ===========
+
+    // the k-th smallest key, counting from 0; nullptr when k >= size()
+    Node_type* select(std::size_t k)
+    {
+        static_assert(detail::has_subtree_size<Augment>::value, "select needs subtree sizes, e.g. order_statistics");
+
+        Node_type* _curr_node = m_root;
+        while (_curr_node != nullptr)
+        {
+            std::size_t _left = order_statistics::sizeOf(_curr_node->left());
+            if (k < _left)
+            {
+                _curr_node = _curr_node->left();
+            }
+            else if (k == _left)
+            {
+                return _curr_node;
+            }
+            else
+            {
+                k -= _left + 1;
+                _curr_node = _curr_node->right();
+            }
+        }
+        return nullptr;
+    }
+
+    // how many keys are less than key
+    std::size_t rank(const Key_t& key) const
+    {
+        return rankOf(key);
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    std::size_t rank(const K& key) const
+    {
+        return rankOf(key);
+    }
+
+    // how many keys are in [lo, hi]
+    std::size_t count_range(const Key_t& lo, const Key_t& hi) const
+    {
+        return countRange(lo, hi);
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    std::size_t count_range(const K& lo, const K& hi) const
+    {
+        return countRange(lo, hi);
+    }
+
+    // the monoid over the values with keys in [lo, hi], in key order
+    template <typename A = Augment>
+    typename A::value_type aggregate_range(const Key_t& lo, const Key_t& hi) const
+    {
+        return aggregateRange<A>(lo, hi);
+    }
+
+    template <typename K, typename A = Augment, typename = if_transparent<K>>
+    typename A::value_type aggregate_range(const K& lo, const K& hi) const
+    {
+        return aggregateRange<A>(lo, hi);
+    }
+
+private:
+    template <typename K>
+    std::size_t rankOf(const K& key) const
+    {
+        static_assert(detail::has_subtree_size<Augment>::value, "rank needs subtree sizes, e.g. order_statistics");
+        return countBelow(key, false);
+    }
+
+    template <typename K>
+    std::size_t countRange(const K& lo, const K& hi) const
+    {
+        static_assert(detail::has_subtree_size<Augment>::value, "count_range needs subtree sizes, e.g. order_statistics");
+        return keyLess(hi, lo) ? 0 : countBelow(hi, true) - countBelow(lo, false);
+    }
+
+    // the paths to lo and hi split at one node; below it, every step toward lo takes a
+    // whole right subtree and every step toward hi a whole left one
+    template <typename A, typename K>
+    typename A::value_type aggregateRange(const K& lo, const K& hi) const
+    {
+        static_assert(detail::has_aggregate<A>::value, "aggregate_range needs aggregate_of<Monoid>");
+        using monoid     = typename A::monoid;
+        using value_type = typename A::value_type;
+
+        const Node_type* _split = m_root;
+        while (_split != nullptr && (keyLess(_split->key(), lo) || keyLess(hi, _split->key())))
+        {
+            _split = keyLess(_split->key(), lo) ? _split->right() : _split->left();
+        }
+        if (_split == nullptr || keyLess(hi, lo))
+        {
+            return monoid::identity();
+        }
+
+        // keys >= lo in the left subtree, the nearest ones found last
+        value_type       _left      = monoid::identity();
+        const Node_type* _curr_node = _split->left();
+        while (_curr_node != nullptr)
+        {
+            if (keyLess(_curr_node->key(), lo))
+            {
+                _curr_node = _curr_node->right();
+            }
+            else
+            {
+                value_type _here = monoid::combine(value_type(_curr_node->value()), A::totalOf(_curr_node->right()));
+                _left            = monoid::combine(_here, _left);
+                _curr_node       = _curr_node->left();
+            }
+        }
+
+        // keys <= hi in the right subtree
+        value_type _right = monoid::identity();
+        _curr_node        = _split->right();
+        while (_curr_node != nullptr)
+        {
+            if (keyLess(hi, _curr_node->key()))
+            {
+                _curr_node = _curr_node->left();
+            }
+            else
+            {
+                value_type _here = monoid::combine(A::totalOf(_curr_node->left()), value_type(_curr_node->value()));
+                _right           = monoid::combine(_right, _here);
+                _curr_node       = _curr_node->right();
+            }
+        }
+
+        return monoid::combine(monoid::combine(_left, value_type(_split->value())), _right);
+    }
+
+    // keys below key, or up to and including it
+    template <typename K>
+    std::size_t countBelow(const K& key, bool inclusive) const
+    {
+        std::size_t      _count     = 0;
+        const Node_type* _curr_node = m_root;
+        while (_curr_node != nullptr)
+        {
+            if (inclusive ? !keyLess(key, _curr_node->key()) : keyLess(_curr_node->key(), key))
+            {
+                _count += order_statistics::sizeOf(_curr_node->left()) + 1;
+                _curr_node = _curr_node->right();
+            }
+            else
+            {
+                _curr_node = _curr_node->left();
+            }
+        }
+        return _count;
+    }
+
+public:
+    void traverse()
+    {
+        traverseNode(m_root);
+    }
+
+    void traverseNode(Node_type* thisNode)
+    {
+        if (thisNode == nullptr) return;
+
+        traverseNode(thisNode->left());
+
+        std::cout << thisNode->value() << std::endl;
+
+        traverseNode(thisNode->right());
+    }
+
+    // print it in a tree-like structure by BFS
+    void print()
+    {
+        printBFS(m_root);
+    }
+
+    void printBFS(Node_type* root)
+    {
+        if (root == nullptr) return;
+
+        std::queue<std::pair<Node_type*, int>> q;
+        q.push({ root, 0 });
+        int currentLevel = 0;
+
+        while (!q.empty())
+        {
+            auto nodePair = q.front();
+            q.pop();
+            Node_type* currentNode = nodePair.first;
+            int        level       = nodePair.second;
+
+            if (level != currentLevel)
+            {
+                std::cout << std::endl;
+                currentLevel = level;
+            }
+
+            std::cout << "(" << currentNode->key() << "," << currentNode->value() << ") ";
+
+            if (currentNode->left())
+            {
+                q.push({ currentNode->left(), level + 1 });
+            }
+
+            if (currentNode->right())
+            {
+                q.push({ currentNode->right(), level + 1 });
+            }
+        }
+
+        std::cout << std::endl;
+    }
+
+    // -1 when empty
+    int height() const
+    {
+        return Node_type::heightOf(m_root);
+    }
+
+public:
+    Node_type* minimum()
+    {
+        return minimum(m_root);
+    }
+
+    Node_type* minimum(Node_type* thisNode)
+    {
+        Node_type* _curr_node = thisNode;
+
+        while (_curr_node->left() != nullptr)
+        {
+            _curr_node = _curr_node->left();
+        }
+
+        return _curr_node;
+    }
+
+    Node_type* maximum()
+    {
+        return maximum(m_root);
+    }
+
+    Node_type* maximum(Node_type* thisNode)
+    {
+        Node_type* _curr_node = thisNode;
+
+        while (_curr_node->right() != nullptr)
+        {
+            _curr_node = _curr_node->right();
+        }
+
+        return _curr_node;
+    }
+
+    // iterator
+public:
+    iterator begin()
+    {
+        return iterator(m_root ? this->minimum() : nullptr, &m_root);
+    }
+
+    iterator end()
+    {
+        return iterator(nullptr, &m_root);
+    }
+
+    const_iterator begin() const
+    {
+        const Node_type* _curr_node = m_root;
+        while (_curr_node && _curr_node->left())
+        {
+            _curr_node = _curr_node->left();
+        }
+        return const_iterator(_curr_node, &m_root);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(nullptr, &m_root);
+    }
+
+    reverse_iterator       rbegin() { return reverse_iterator(end()); }
+    reverse_iterator       rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    // ordered lookups ===========
+
+    // the first key not less than key
+    iterator       lower_bound(const Key_t& key) { return iterator(lowerBound(key), &m_root); }
+    const_iterator lower_bound(const Key_t& key) const { return const_iterator(lowerBound(key), &m_root); }
+
+    template <typename K, typename = if_transparent<K>>
+    iterator lower_bound(const K& key)
+    {
+        return iterator(lowerBound(key), &m_root);
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    const_iterator lower_bound(const K& key) const
+    {
+        return const_iterator(lowerBound(key), &m_root);
+    }
+
+    // the first key greater than key
+    iterator       upper_bound(const Key_t& key) { return iterator(upperBound(key), &m_root); }
+    const_iterator upper_bound(const Key_t& key) const { return const_iterator(upperBound(key), &m_root); }
+
+    template <typename K, typename = if_transparent<K>>
+    iterator upper_bound(const K& key)
+    {
+        return iterator(upperBound(key), &m_root);
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    const_iterator upper_bound(const K& key) const
+    {
+        return const_iterator(upperBound(key), &m_root);
+    }
+
+    std::pair<iterator, iterator> equal_range(const Key_t& key)
+    {
+        return { lower_bound(key), upper_bound(key) };
     }
 
-private:
-    void transplant(Node_type* thisNode, Node_type* child)
+    std::pair<const_iterator, const_iterator> equal_range(const Key_t& key) const
     {
-        // check either is nullptr
-        if (thisNode == nullptr || child == nullptr)
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    std::pair<iterator, iterator> equal_range(const K& key)
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    std::pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    // range erase ===========
+
+    // erases [first, last) and returns last. the range is cut out with two splits and the
+    // rest joined back, O(log n) restructuring plus O(k) to free k nodes, instead of a
+    // rebalance walk per key
+    iterator erase(iterator first, iterator last)
+    {
+        if (first == last)
         {
-            return;
+            return last;
         }
 
-        auto _grandParent = thisNode->parent;
-        if (_grandParent == nullptr)
+        Node_type *_less, *_rest, *_doomed, *_greater;
+        split(m_root, first->first, _less, _rest);
+        if (last == end())
         {
-            m_root = child;
+            _doomed  = _rest;
+            _greater = nullptr;
+        }
+        else
+        {
+            split(_rest, last->first, _doomed, _greater);
         }
-        else if (_grandParent->right == thisNode)
+        m_root = join2(_less, _greater);
+        resetRightmost();
+
+        deleteNode(_doomed);
+        reportShape();
+        return last;
+    }
+
+    // erases every pair pred(pair) is true for and returns how many. one in-order pass
+    // sorts the nodes out, the survivors are relinked into a balanced tree without
+    // rotations or reallocation. if pred throws nothing is erased
+    template <typename Pred>
+    std::size_t erase_if(Pred pred)
+    {
+        std::vector<Node_type*> _keep, _doomed;
+        for (iterator _it = begin(); _it != end(); ++_it)
         {
-            _grandParent->right = child;
+            (pred(*_it) ? _doomed : _keep).push_back(_it.node());
         }
-        else if (_grandParent->left == thisNode)
+        if (_doomed.empty())
         {
-            _grandParent->left = child;
+            return 0;
         }
-        child->parent = _grandParent;
 
-        delete thisNode;
+        for (Node_type* _node : _doomed)
+        {
+            destroyNode(_node);
+        }
+        m_root = linkSorted(_keep.data(), _keep.size());
+        if (m_root != nullptr)
+        {
+            m_root->setParent(nullptr);
+        }
+        resetRightmost();
+        reportShape();
+        return _doomed.size();
     }
 
-public:
-    // new : iterative version
-    // the C++ impl wont replace for same key;
-    Node_type* find(int key)
+private:
+    template <typename K>
+    Node_type* lowerBound(const K& key) const
     {
+        Node_type* _result    = nullptr;
         Node_type* _curr_node = m_root;
-
         while (_curr_node != nullptr)
         {
-            if (_curr_node->key > key)
+            if (keyLess(_curr_node->key(), key))
+            {
+                _curr_node = _curr_node->right();
+            }
+            else
             {
-                _curr_node = _curr_node->left;
+                _result    = _curr_node;
+                _curr_node = _curr_node->left();
             }
-            else if (_curr_node->key < key)
+        }
+        return _result;
+    }
+
+    template <typename K>
+    Node_type* upperBound(const K& key) const
+    {
+        Node_type* _result    = nullptr;
+        Node_type* _curr_node = m_root;
+        while (_curr_node != nullptr)
+        {
+            if (keyLess(key, _curr_node->key()))
             {
-                _curr_node = _curr_node->right;
+                _result    = _curr_node;
+                _curr_node = _curr_node->left();
             }
             else
             {
-                return _curr_node;
+                _curr_node = _curr_node->right();
             }
         }
+        return _result;
+    }
 
-        return nullptr;
+    // split / join on detached subtrees ===========
+    // a detached subtree's top has no parent and m_root is not involved; nodes are relinked,
+    // never copied or reallocated. each costs O(log n)
+
+    static Node_type* detach(Node_type* node)
+    {
+        if (node != nullptr)
+        {
+            node->setParent(nullptr);
+        }
+        return node;
     }
 
-public:
-    void traverse()
+    // every key in left < middle's key < every key in right. the shorter tree hangs off
+    // the spine of the taller one where the heights meet, then that spine rebalances
+    Node_type* join(Node_type* left, Node_type* middle, Node_type* right)
     {
-        traverseNode(m_root);
+        int _left_height  = Node_type::heightOf(left);
+        int _right_height = Node_type::heightOf(right);
+
+        Node_type* _spine  = nullptr;
+        bool       _rising = _left_height > _right_height + 1 || _right_height > _left_height + 1;
+        if (_left_height > _right_height + 1)
+        {
+            while (Node_type::heightOf(left) > _right_height + 1)
+            {
+                _spine = left;
+                left   = left->right();
+            }
+        }
+        else if (_right_height > _left_height + 1)
+        {
+            while (Node_type::heightOf(right) > _left_height + 1)
+            {
+                _spine = right;
+                right  = right->left();
+            }
+        }
+
+        middle->setLeft(left);
+        middle->setRight(right);
+        middle->setParent(_spine);
+        if (left)
+        {
+            left->setParent(middle);
+        }
+        if (right)
+        {
+            right->setParent(middle);
+        }
+        updateNode(middle);
+
+        if (!_rising)
+        {
+            return middle;
+        }
+        if (_left_height > _right_height)
+        {
+            _spine->setRight(middle);
+        }
+        else
+        {
+            _spine->setLeft(middle);
+        }
+        return rebalanceUpwards(_spine);
     }
 
-    void traverseNode(Node_type* thisNode)
+    // join without a middle key: the smallest of right steps in
+    Node_type* join2(Node_type* left, Node_type* right)
     {
-        if (thisNode == nullptr) return;
+        if (left == nullptr)
+        {
+            return right;
+        }
+        if (right == nullptr)
+        {
+            return left;
+        }
+
+        Node_type* _min = nullptr;
+        right           = detachMinimum(right, _min);
+        return join(left, _min, right);
+    }
 
-        traverseNode(thisNode->left);
+    // unlinks the smallest node of a detached subtree into min, returns the new top
+    Node_type* detachMinimum(Node_type* top, Node_type*& min)
+    {
+        min                = minimum(top);
+        Node_type* _parent = min->parent();
+        Node_type* _right  = min->right();
+        if (_right)
+        {
+            _right->setParent(_parent);
+        }
+        if (_parent == nullptr)
+        {
+            return _right;
+        }
+        _parent->setLeft(_right);
+        return rebalanceUpwards(_parent);
+    }
 
-        std::cout << thisNode->value << std::endl;
+    // keys < key go to less, the rest to greater
+    void split(Node_type* top, const Key_t& key, Node_type*& less, Node_type*& greater)
+    {
+        if (top == nullptr)
+        {
+            less    = nullptr;
+            greater = nullptr;
+            return;
+        }
 
-        traverseNode(thisNode->right);
+        Node_type* _left  = detach(top->left());
+        Node_type* _right = detach(top->right());
+        if (keyLess(top->key(), key))
+        {
+            Node_type* _right_less;
+            split(_right, key, _right_less, greater);
+            less = join(_left, top, _right_less);
+        }
+        else
+        {
+            Node_type* _left_greater;
+            split(_left, key, less, _left_greater);
+            greater = join(_left_greater, top, _right);
+        }
     }
 
-    // print it in a tree-like structure by BFS
-    void print()
+    // like split, but a node with key itself is cut out and returned, childless, rather
+    // than going to greater; nullptr if there is none
+    Node_type* splitOut(Node_type* top, const Key_t& key, Node_type*& less, Node_type*& greater)
     {
-        printBFS(m_root);
+        if (top == nullptr)
+        {
+            less    = nullptr;
+            greater = nullptr;
+            return nullptr;
+        }
+
+        Node_type* _left  = detach(top->left());
+        Node_type* _right = detach(top->right());
+        if (keyLess(top->key(), key))
+        {
+            Node_type* _right_less;
+            Node_type* _found = splitOut(_right, key, _right_less, greater);
+            less              = join(_left, top, _right_less);
+            return _found;
+        }
+        if (keyLess(key, top->key()))
+        {
+            Node_type* _left_greater;
+            Node_type* _found = splitOut(_left, key, less, _left_greater);
+            greater           = join(_left_greater, top, _right);
+            return _found;
+        }
+
+        less    = _left;
+        greater = _right;
+        top->setLeft(nullptr);
+        top->setRight(nullptr);
+        top->setParent(nullptr);
+        updateNode(top);
+        return top;
     }
 
-    void printBFS(Node_type* root)
+    // nodes[0, n) in key order become a balanced subtree, middle first
+    Node_type* linkSorted(Node_type* const* nodes, std::size_t n)
     {
-        if (root == nullptr) return;
+        if (n == 0)
+        {
+            return nullptr;
+        }
 
-        std::queue<std::pair<Node_type*, int>> q;
-        q.push({ root, 0 });
-        int currentLevel = 0;
+        std::size_t _mid   = n / 2;
+        Node_type*  _node  = nodes[_mid];
+        Node_type*  _left  = linkSorted(nodes, _mid);
+        Node_type*  _right = linkSorted(nodes + _mid + 1, n - _mid - 1);
+        _node->setLeft(_left);
+        _node->setRight(_right);
+        if (_left)
+        {
+            _left->setParent(_node);
+        }
+        if (_right)
+        {
+            _right->setParent(_node);
+        }
+        updateNode(_node);
+        return _node;
+    }
 
-        while (!q.empty())
+public:
+    // split, join and set operations ===========
+    // built on the join of two subtrees and a middle node, O(log n) each. a set operation
+    // splits this tree at the root key of other and recurses on both halves, O(m log(n/m + 1))
+    // for m keys against n. when both trees are big the halves run as fork-join tasks on a
+    // ThreadPool, the shared one unless given: the recursion only relinks nodes that are
+    // already there, so the tasks never allocate. when the sizes are close and there is
+    // no pool to spread the work over, an in-order merge rebuilt balanced is cheaper,
+    // O(n + m), and that is used instead. other must order keys the same way
+
+    // moves every key >= key into the returned tree. O(log n) to cut; the moved keys are
+    // then counted (heap_nodes) or copied into the new tree's storage (the others)
+    AVLTree split(const Key_t& key)
+    {
+        AVLTree    _greater(key_comp());
+        Node_type *_less, *_rest;
+        split(m_root, key, _less, _rest);
+        try
         {
-            auto nodePair = q.front();
-            q.pop();
-            Node_type* currentNode = nodePair.first;
-            int        level       = nodePair.second;
+            _greater.m_root = _greater.adopt(*this, _rest, countNodes(_rest));
+        }
+        catch (...)
+        {
+            m_root = join2(_less, _rest);
+            resetRightmost();
+            throw;
+        }
+        m_root = _less;
+        resetRightmost();
+        reportShape();
+        _greater.resetRightmost();
+        _greater.reportShape();
+        return _greater;
+    }
 
-            if (level != currentLevel)
-            {
-                std::cout << std::endl;
-                currentLevel = level;
-            }
+    // appends other, whose keys must all be greater than this tree's, and leaves it
+    // empty. O(log n) for heap_nodes, the others copy other's nodes over first. throws
+    // std::invalid_argument, before touching either tree, when the keys overlap
+    void join(AVLTree&& other)
+    {
+        if (other.empty() || &other == this)
+        {
+            return;
+        }
+        if (m_rightmost != nullptr && !keyLess(m_rightmost->key(), other.minimum()->key()))
+        {
+            throw std::invalid_argument("AVLTree::join: keys are not all greater");
+        }
+
+        Node_type* _right = adopt(other, other.m_root, other.m_size);
+        other.m_root      = nullptr;
+        other.m_rightmost = nullptr;
+        other.reportShape();
+
+        m_root = join2(m_root, _right);
+        resetRightmost();
+        reportShape();
+    }
+
+    // adds the keys only other has; keys both have keep this tree's value, as with
+    // insert. returns how many were added. if anything throws the tree is unchanged
+    std::size_t union_with(const AVLTree& other) { return unionWith(other, nullptr); }
+    std::size_t union_with(const AVLTree& other, ThreadPool& pool) { return unionWith(other, &pool); }
+
+    // erases the keys other doesn't have, returns how many
+    std::size_t intersect_with(const AVLTree& other) { return keepShared(other, true, nullptr); }
+    std::size_t intersect_with(const AVLTree& other, ThreadPool& pool) { return keepShared(other, true, &pool); }
+
+    // erases the keys other has, returns how many
+    std::size_t difference(const AVLTree& other) { return keepShared(other, false, nullptr); }
+    std::size_t difference(const AVLTree& other, ThreadPool& pool) { return keepShared(other, false, &pool); }
 
-            std::cout << "(" << currentNode->key << "," << currentNode->value << ") ";
+private:
+    // below this many keys on the smaller side a set operation stays on the calling thread
+    static constexpr std::size_t parallel_set_keys = std::size_t(1) << 16;
+    // a recursion step forks while both subtrees are at least this high, some 1k to 16k keys
+    static constexpr int parallel_set_height = 14;
+
+    // detached subtrees waiting to be freed, chained through their tops' parent links so
+    // that collecting them allocates nothing
+    struct DoomedList
+    {
+        Node_type* head = nullptr;
+        Node_type* tail = nullptr;
 
-            if (currentNode->left)
+        void push(Node_type* top)
+        {
+            top->setParent(head);
+            head = top;
+            if (tail == nullptr)
             {
-                q.push({ currentNode->left, level + 1 });
+                tail = top;
             }
+        }
 
-            if (currentNode->right)
+        void splice(DoomedList& other)
+        {
+            if (other.head == nullptr)
+            {
+                return;
+            }
+            other.tail->setParent(head);
+            head = other.head;
+            if (tail == nullptr)
             {
-                q.push({ currentNode->right, level + 1 });
+                tail = other.tail;
             }
         }
+    };
 
-        std::cout << std::endl;
+    void deleteDoomed(DoomedList& doomed)
+    {
+        for (Node_type* _top = doomed.head; _top != nullptr;)
+        {
+            Node_type* _next = _top->parent();
+            _top->setParent(nullptr);
+            deleteNode(_top);
+            _top = _next;
+        }
+        doomed = DoomedList();
     }
 
-    int height()
+    static std::size_t countNodes(const Node_type* node)
     {
-        return m_root->height;
+        return node == nullptr ? 0 : 1 + countNodes(node->left()) + countNodes(node->right());
     }
 
-public:
-    Node_type* minimum()
+    // the detached subtree top, count nodes in from's storage, as a detached subtree in
+    // this tree's. heap nodes change trees as they are, the others are copied and the
+    // originals freed. if the copy throws, top is still from's
+    Node_type* adopt(AVLTree& from, Node_type* top, std::size_t count)
     {
-        return minimum(m_root);
+        if constexpr (std::is_same<NodeStorage, heap_nodes>::value)
+        {
+            from.m_size -= count;
+            from.stats_ref().on_deallocate(count * sizeof(Node_type));
+            m_size += count;
+            stats_ref().on_allocate(count * sizeof(Node_type));
+            return top;
+        }
+        else
+        {
+            nodes().prepare(count, m_root);
+            Node_type* _copy = cloneNode(top, nullptr);
+            from.deleteNode(top);
+            return _copy;
+        }
     }
 
-    Node_type* minimum(Node_type* thisNode)
+    // the join recursion goes parallel only with a second thread to run on and both sides
+    // big; counting stats aren't atomic, so an instrumented tree stays on this thread.
+    // otherwise it runs here when one side is much smaller, and the merge runs when not
+    ThreadPool* setOpPool(std::size_t m, ThreadPool* pool) const
     {
-        Node_type* _curr_node = thisNode;
+        if (Stats::enabled || std::min(m_size, m) < parallel_set_keys)
+        {
+            return nullptr;
+        }
+        if (pool == nullptr)
+        {
+            pool = &ThreadPool::instance();
+        }
+        return pool->threadCount() > 1 ? pool : nullptr;
+    }
+
+    bool setOpByJoin(std::size_t m, ThreadPool* pool) const
+    {
+        return pool != nullptr || isLopsided(std::min(m_size, m), std::max(m_size, m));
+    }
 
-        while (_curr_node->left != nullptr)
+    template <typename Left, typename Right>
+    static void forkJoin(ThreadPool* pool, bool fork, Left&& left, Right&& right)
+    {
+        if (!fork)
         {
-            _curr_node = _curr_node->left;
+            left();
+            right();
+            return;
         }
+        TaskGroup _group(*pool);
+        _group.run(std::forward<Right>(right));
+        left();
+        _group.wait();
+    }
 
-        return _curr_node;
+    static bool forkable(ThreadPool* pool, const Node_type* mine, const Node_type* theirs)
+    {
+        return pool != nullptr && std::min(Node_type::heightOf(mine), Node_type::heightOf(theirs)) >= parallel_set_height;
     }
 
-    Node_type* maximum()
+    std::size_t unionWith(const AVLTree& other, ThreadPool* pool)
     {
-        return maximum(m_root);
+        if (&other == this || other.empty())
+        {
+            return 0;
+        }
+
+        std::size_t _old_size = m_size;
+        pool                  = setOpPool(other.m_size, pool);
+        if (setOpByJoin(other.m_size, pool))
+        {
+            // other's nodes are copied in up front, so the recursion only relinks
+            nodes().prepare(other.m_size, m_root);
+            Node_type* _theirs = cloneNode(other.m_root, nullptr);
+            DoomedList _doomed;
+            m_root = unite(m_root, _theirs, _doomed, pool);
+            deleteDoomed(_doomed);
+        }
+        else
+        {
+            mergeUnion(other);
+        }
+        resetRightmost();
+        reportShape();
+        return m_size - _old_size;
     }
 
-    Node_type* maximum(Node_type* thisNode)
+    // keep_shared: erase the keys other lacks, else the keys it has
+    std::size_t keepShared(const AVLTree& other, bool keep_shared, ThreadPool* pool)
     {
-        Node_type* _curr_node = thisNode;
+        std::size_t _old_size = m_size;
+        if (&other == this)
+        {
+            if (!keep_shared)
+            {
+                clear();
+            }
+            return _old_size - m_size;
+        }
+
+        pool = setOpPool(other.m_size, pool);
+        if (setOpByJoin(other.m_size, pool))
+        {
+            DoomedList _doomed;
+            m_root = keep_shared ? intersect(m_root, other.m_root, _doomed, pool) : subtract(m_root, other.m_root, _doomed, pool);
+            deleteDoomed(_doomed);
+            resetRightmost();
+            reportShape();
+        }
+        else
+        {
+            const_iterator _theirs = other.begin();
+            const_iterator _end    = other.end();
+            erase_if([this, &_theirs, _end, keep_shared](const pair_type& kv) {
+                while (_theirs != _end && keyLess(_theirs->first, kv.first))
+                {
+                    ++_theirs;
+                }
+                bool _shared = _theirs != _end && !keyLess(kv.first, _theirs->first);
+                return _shared != keep_shared;
+            });
+        }
+        return _old_size - m_size;
+    }
 
-        while (_curr_node->right != nullptr)
+    // mine and theirs are detached subtrees of this tree; of equal keys theirs is doomed
+    Node_type* unite(Node_type* mine, Node_type* theirs, DoomedList& doomed, ThreadPool* pool)
+    {
+        if (mine == nullptr)
+        {
+            return theirs;
+        }
+        if (theirs == nullptr)
         {
-            _curr_node = _curr_node->right;
+            return mine;
         }
 
-        return _curr_node;
+        bool       _fork         = forkable(pool, mine, theirs);
+        Node_type* _theirs_left  = detach(theirs->left());
+        Node_type* _theirs_right = detach(theirs->right());
+        Node_type *_less, *_greater;
+        Node_type* _middle = splitOut(mine, theirs->key(), _less, _greater);
+        if (_middle == nullptr)
+        {
+            _middle = theirs;
+        }
+        else
+        {
+            theirs->setLeft(nullptr);
+            theirs->setRight(nullptr);
+            doomed.push(theirs);
+        }
+
+        DoomedList _right_doomed;
+        forkJoin(pool, _fork, [&] { _less = unite(_less, _theirs_left, doomed, pool); },
+                 [&] { _greater = unite(_greater, _theirs_right, _right_doomed, pool); });
+        doomed.splice(_right_doomed);
+        return join(_less, _middle, _greater);
     }
 
-    // iterator
-public:
-    using iterator = AVLIterator<Key_t, Value_t>;
+    // theirs belongs to the other tree and is only read
+    Node_type* intersect(Node_type* mine, const Node_type* theirs, DoomedList& doomed, ThreadPool* pool)
+    {
+        if (mine == nullptr)
+        {
+            return nullptr;
+        }
+        if (theirs == nullptr)
+        {
+            doomed.push(mine);
+            return nullptr;
+        }
 
-    iterator begin()
+        bool       _fork = forkable(pool, mine, theirs);
+        Node_type *_less, *_greater;
+        Node_type* _middle = splitOut(mine, theirs->key(), _less, _greater);
+
+        DoomedList _right_doomed;
+        forkJoin(pool, _fork, [&] { _less = intersect(_less, theirs->left(), doomed, pool); },
+                 [&] { _greater = intersect(_greater, theirs->right(), _right_doomed, pool); });
+        doomed.splice(_right_doomed);
+        return _middle != nullptr ? join(_less, _middle, _greater) : join2(_less, _greater);
+    }
+
+    Node_type* subtract(Node_type* mine, const Node_type* theirs, DoomedList& doomed, ThreadPool* pool)
     {
-        return iterator(this->minimum());
+        if (mine == nullptr || theirs == nullptr)
+        {
+            return mine;
+        }
+
+        bool       _fork = forkable(pool, mine, theirs);
+        Node_type *_less, *_greater;
+        Node_type* _middle = splitOut(mine, theirs->key(), _less, _greater);
+        if (_middle != nullptr)
+        {
+            doomed.push(_middle);
+        }
+
+        DoomedList _right_doomed;
+        forkJoin(pool, _fork, [&] { _less = subtract(_less, theirs->left(), doomed, pool); },
+                 [&] { _greater = subtract(_greater, theirs->right(), _right_doomed, pool); });
+        doomed.splice(_right_doomed);
+        return join2(_less, _greater);
     }
 
-    iterator end()
+    // both trees in key order into one list of nodes, other's keys copied in where this
+    // tree lacks them, then relinked balanced. the new nodes are freed if a copy throws
+    void mergeUnion(const AVLTree& other)
     {
-        return iterator(nullptr);
+        nodes().prepare(other.m_size, m_root);
+
+        std::vector<Node_type*> _merged, _created;
+        _merged.reserve(m_size + other.m_size);
+        const_iterator _theirs = other.begin();
+        const_iterator _end    = other.end();
+        try
+        {
+            for (iterator _it = begin(); _it != end() || _theirs != _end;)
+            {
+                if (_theirs == _end || (_it != end() && keyLess(_it->first, _theirs->first)))
+                {
+                    _merged.push_back(_it.node());
+                    ++_it;
+                    continue;
+                }
+                if (_it == end() || keyLess(_theirs->first, _it->first))
+                {
+                    _created.push_back(createNode(_theirs->first, _theirs->second));
+                    _merged.push_back(_created.back());
+                }
+                ++_theirs;
+            }
+        }
+        catch (...)
+        {
+            for (Node_type* _node : _created)
+            {
+                destroyNode(_node);
+            }
+            throw;
+        }
+
+        m_root = linkSorted(_merged.data(), _merged.size());
+        m_root->setParent(nullptr);
     }
 
 private:
-    Node_type* m_root = nullptr;
+    Node_type*  m_root      = nullptr;
+    Node_type*  m_rightmost = nullptr; // the last node, so appends at end() skip the descent
+    std::size_t m_size      = 0;
 };
 
 } // namespace m_std
\ No newline at end of file
@@ -0,0 +1,491 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#    include <malloc.h>
+#endif
+
+namespace m_std
+{
+
+// default allocator: the global heap. backed by malloc rather than ::operator new
+// so that trivially relocatable elements can be grown in place with realloc
+template <typename T>
+struct allocator
+{
+    using value_type = T;
+
+    allocator() = default;
+    template <typename U>
+    allocator(const allocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        void* _p = std::malloc(sizeof(T) * n);
+        if (_p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(_p);
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        std::free(p);
+    }
+
+    // only valid for trivially relocatable T, the bytes are moved by realloc
+    T* reallocate(T* p, std::size_t, std::size_t new_n)
+    {
+        void* _p = std::realloc(p, sizeof(T) * new_n);
+        if (_p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(_p);
+    }
+
+    friend bool operator==(const allocator&, const allocator&) { return true; }
+    friend bool operator!=(const allocator&, const allocator&) { return false; }
+};
+
+// over-aligned heap storage, e.g. 32 / 64 bytes so SIMD loads never straddle a cache line.
+// no reallocate(): realloc would drop the alignment, growth relocates into a new block.
+template <typename T, std::size_t Alignment = 64>
+struct aligned_allocator
+{
+    static_assert((Alignment & (Alignment - 1)) == 0 && Alignment >= alignof(T), "alignment must be a power of two");
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() = default;
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+#if defined(_WIN32)
+        void* _p = ::_aligned_malloc(sizeof(T) * n, Alignment);
+#else
+        void* _p = nullptr;
+        if (::posix_memalign(&_p, Alignment < sizeof(void*) ? sizeof(void*) : Alignment, sizeof(T) * n) != 0)
+        {
+            _p = nullptr;
+        }
+#endif
+        if (_p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(_p);
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+#if defined(_WIN32)
+        ::_aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+
+    friend bool operator==(const aligned_allocator&, const aligned_allocator&) { return true; }
+    friend bool operator!=(const aligned_allocator&, const aligned_allocator&) { return false; }
+};
+
+//================================================================================================
+// monotonic arena: bump-allocates from big blocks, deallocate is a no-op,
+// and everything is given back at once by release() / reset()
+class arena
+{
+public:
+    explicit arena(std::size_t initial_block_size = 64 * 1024) :
+        m_initial_block_size(initial_block_size < 256 ? 256 : initial_block_size), m_next_block_size(m_initial_block_size)
+    {
+    }
+
+    ~arena()
+    {
+        release();
+    }
+
+    arena(const arena&)            = delete;
+    arena& operator=(const arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        char* _p = align_up(m_cursor, alignment);
+        if (m_cursor == nullptr || _p + bytes > m_end)
+        {
+            add_block(bytes + alignment);
+            _p = align_up(m_cursor, alignment);
+        }
+
+        m_cursor = _p + bytes;
+        m_bytes_used += bytes;
+        return _p;
+    }
+
+    // monotonic: memory comes back only through release() / reset()
+    void deallocate(void*, std::size_t) noexcept { }
+
+    // grow or shrink the most recent allocation in place, returns false otherwise
+    bool try_resize_last(void* p, std::size_t old_bytes, std::size_t new_bytes) noexcept
+    {
+        char* _p = static_cast<char*>(p);
+        if (_p + old_bytes != m_cursor || _p + new_bytes > m_end)
+        {
+            return false;
+        }
+
+        m_cursor = _p + new_bytes;
+        m_bytes_used += new_bytes;
+        m_bytes_used -= old_bytes;
+        return true;
+    }
+
+    // free every block, growth starts over from the initial size
+    void release() noexcept
+    {
+        while (m_blocks != nullptr)
+        {
+            block_header* _next = m_blocks->next;
+            ::operator delete(m_blocks);
+            m_blocks = _next;
+        }
+        m_cursor          = nullptr;
+        m_end             = nullptr;
+        m_bytes_used      = 0;
+        m_next_block_size = m_initial_block_size;
+    }
+
+    // keep the newest (largest) block for the next request, free the rest.
+    // blocks added past it start over from the initial size
+    void reset() noexcept
+    {
+        if (m_blocks == nullptr)
+        {
+            return;
+        }
+
+        block_header* _keep = m_blocks;
+        m_blocks            = m_blocks->next;
+        release();
+
+        _keep->next = nullptr;
+        m_blocks    = _keep;
+        m_cursor    = reinterpret_cast<char*>(_keep + 1);
+        m_end       = reinterpret_cast<char*>(_keep) + _keep->size;
+    }
+
+    std::size_t bytes_used() const { return m_bytes_used; }
+
+    friend bool operator==(const arena& a, const arena& b) { return &a == &b; }
+
+private:
+    struct alignas(std::max_align_t) block_header
+    {
+        block_header* next;
+        std::size_t   size;
+    };
+
+    static char* align_up(char* p, std::size_t alignment)
+    {
+        auto _addr = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<char*>((_addr + alignment - 1) & ~(std::uintptr_t)(alignment - 1));
+    }
+
+    void add_block(std::size_t min_bytes)
+    {
+        // grow geometrically so a long request touches few blocks
+        std::size_t _size = sizeof(block_header) + (min_bytes > m_next_block_size ? min_bytes : m_next_block_size);
+        m_next_block_size *= 2;
+
+        auto _block  = static_cast<block_header*>(::operator new(_size));
+        _block->next = m_blocks;
+        _block->size = _size;
+        m_blocks     = _block;
+
+        m_cursor = reinterpret_cast<char*>(_block + 1);
+        m_end    = reinterpret_cast<char*>(_block) + _size;
+    }
+
+private:
+    block_header* m_blocks             = nullptr;
+    char*         m_cursor             = nullptr;
+    char*         m_end                = nullptr;
+    std::size_t   m_initial_block_size = 0;
+    std::size_t   m_next_block_size    = 0;
+    std::size_t   m_bytes_used         = 0;
+};
+
+template <typename T>
+class arena_allocator
+{
+public:
+    using value_type = T;
+
+    arena_allocator(arena& a) noexcept :
+        m_arena(&a) { }
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept :
+        m_arena(other.get_arena())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(m_arena->allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        m_arena->deallocate(p, sizeof(T) * n);
+    }
+
+    // only valid for trivially relocatable T: the tail allocation is extended in place,
+    // anything else is a bump allocation plus a byte copy
+    T* reallocate(T* p, std::size_t old_n, std::size_t new_n)
+    {
+        if (p != nullptr && m_arena->try_resize_last(p, sizeof(T) * old_n, sizeof(T) * new_n))
+        {
+            return p;
+        }
+
+        T* _p = allocate(new_n);
+        if (p != nullptr)
+        {
+            std::memcpy(static_cast<void*>(_p), static_cast<const void*>(p), sizeof(T) * (old_n < new_n ? old_n : new_n));
+        }
+        return _p;
+    }
+
+    arena* get_arena() const { return m_arena; }
+
+    friend bool operator==(const arena_allocator& a, const arena_allocator& b) { return a.m_arena == b.m_arena; }
+    friend bool operator!=(const arena_allocator& a, const arena_allocator& b) { return !(a == b); }
+
+private:
+    arena* m_arena;
+};
+
+//================================================================================================
+// fixed-size pool: hands out blocks of one size from chunks, recycles them
+// through an intrusive free list, and frees whole chunks on release().
+// chunks start at blocks_per_chunk and double up to max_blocks_per_chunk
+class fixed_pool
+{
+public:
+    explicit fixed_pool(std::size_t block_size, std::size_t blocks_per_chunk = 256, std::size_t max_blocks_per_chunk = 0) :
+        m_block_size(round_up(block_size < sizeof(free_block) ? sizeof(free_block) : block_size)),
+        m_blocks_per_chunk(blocks_per_chunk == 0 ? 1 : blocks_per_chunk),
+        m_max_blocks_per_chunk(max_blocks_per_chunk < m_blocks_per_chunk ? m_blocks_per_chunk : max_blocks_per_chunk),
+        m_next_chunk_blocks(m_blocks_per_chunk)
+    {
+    }
+
+    ~fixed_pool()
+    {
+        release();
+    }
+
+    fixed_pool(const fixed_pool&)            = delete;
+    fixed_pool& operator=(const fixed_pool&) = delete;
+
+    fixed_pool(fixed_pool&& other) noexcept :
+        m_block_size(other.m_block_size),
+        m_blocks_per_chunk(other.m_blocks_per_chunk),
+        m_max_blocks_per_chunk(other.m_max_blocks_per_chunk),
+        m_next_chunk_blocks(other.m_next_chunk_blocks),
+        m_bytes_reserved(other.m_bytes_reserved),
+        m_chunks(other.m_chunks),
+        m_free(other.m_free),
+        m_bump(other.m_bump),
+        m_bump_end(other.m_bump_end)
+    {
+        other.m_chunks         = nullptr;
+        other.m_free           = nullptr;
+        other.m_bump           = nullptr;
+        other.m_bump_end       = nullptr;
+        other.m_bytes_reserved = 0;
+    }
+
+    fixed_pool& operator=(fixed_pool&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_block_size           = other.m_block_size;
+            m_blocks_per_chunk     = other.m_blocks_per_chunk;
+            m_max_blocks_per_chunk = other.m_max_blocks_per_chunk;
+            m_next_chunk_blocks    = other.m_next_chunk_blocks;
+            m_bytes_reserved       = other.m_bytes_reserved;
+            m_chunks               = other.m_chunks;
+            m_free                 = other.m_free;
+            m_bump                 = other.m_bump;
+            m_bump_end             = other.m_bump_end;
+            other.m_chunks         = nullptr;
+            other.m_free           = nullptr;
+            other.m_bump           = nullptr;
+            other.m_bump_end       = nullptr;
+            other.m_bytes_reserved = 0;
+        }
+        return *this;
+    }
+
+    // recycled blocks first, then the untouched tail of the newest chunk
+    void* allocate()
+    {
+        if (m_free != nullptr)
+        {
+            free_block* _block = m_free;
+            m_free             = _block->next;
+            return _block;
+        }
+
+        if (m_bump == m_bump_end)
+        {
+            add_chunk();
+        }
+        void* _block = m_bump;
+        m_bump += m_block_size;
+        return _block;
+    }
+
+    void deallocate(void* p) noexcept
+    {
+        auto _block  = static_cast<free_block*>(p);
+        _block->next = m_free;
+        m_free       = _block;
+    }
+
+    // drop every chunk at once, outstanding blocks become invalid
+    void release() noexcept
+    {
+        while (m_chunks != nullptr)
+        {
+            chunk_header* _next = m_chunks->next;
+            ::operator delete(m_chunks);
+            m_chunks = _next;
+        }
+        m_free              = nullptr;
+        m_bump              = nullptr;
+        m_bump_end          = nullptr;
+        m_bytes_reserved    = 0;
+        m_next_chunk_blocks = m_blocks_per_chunk;
+    }
+
+    std::size_t block_size() const { return m_block_size; }
+
+    // bytes held in chunks, handed out or not
+    std::size_t bytes_reserved() const { return m_bytes_reserved; }
+
+    friend bool operator==(const fixed_pool& a, const fixed_pool& b) { return &a == &b; }
+
+private:
+    struct free_block
+    {
+        free_block* next;
+    };
+
+    struct alignas(std::max_align_t) chunk_header
+    {
+        chunk_header* next;
+    };
+
+    static std::size_t round_up(std::size_t n)
+    {
+        constexpr std::size_t _align = alignof(std::max_align_t);
+        return (n + _align - 1) & ~(_align - 1);
+    }
+
+    void add_chunk()
+    {
+        std::size_t _blocks = m_next_chunk_blocks;
+        std::size_t _bytes  = sizeof(chunk_header) + m_block_size * _blocks;
+        auto        _chunk  = static_cast<chunk_header*>(::operator new(_bytes));
+        _chunk->next        = m_chunks;
+        m_chunks            = _chunk;
+        m_bytes_reserved += _bytes;
+        m_next_chunk_blocks = _blocks * 2 < m_max_blocks_per_chunk ? _blocks * 2 : m_max_blocks_per_chunk;
+
+        // blocks are handed out in address order and never touched before that
+        m_bump     = reinterpret_cast<char*>(_chunk + 1);
+        m_bump_end = m_bump + m_block_size * _blocks;
+    }
+
+private:
+    std::size_t   m_block_size;
+    std::size_t   m_blocks_per_chunk;
+    std::size_t   m_max_blocks_per_chunk;
+    std::size_t   m_next_chunk_blocks;
+    std::size_t   m_bytes_reserved = 0;
+    chunk_header* m_chunks         = nullptr;
+    free_block*   m_free           = nullptr;
+    char*         m_bump           = nullptr;
+    char*         m_bump_end       = nullptr;
+};
+
+// requests that fit one pool block come from the pool, larger ones from the heap
+template <typename T>
+class pool_allocator
+{
+public:
+    using value_type = T;
+
+    pool_allocator(fixed_pool& pool) noexcept :
+        m_pool(&pool) { }
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>& other) noexcept :
+        m_pool(other.get_pool())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        if (sizeof(T) * n <= m_pool->block_size())
+        {
+            return static_cast<T*>(m_pool->allocate());
+        }
+        return static_cast<T*>(::operator new(sizeof(T) * n));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (sizeof(T) * n <= m_pool->block_size())
+        {
+            m_pool->deallocate(p);
+        }
+        else
+        {
+            ::operator delete(p);
+        }
+    }
+
+    fixed_pool* get_pool() const { return m_pool; }
+
+    friend bool operator==(const pool_allocator& a, const pool_allocator& b) { return a.m_pool == b.m_pool; }
+    friend bool operator!=(const pool_allocator& a, const pool_allocator& b) { return !(a == b); }
+
+private:
+    fixed_pool* m_pool;
+};
+
+} // namespace m_std
@@ -0,0 +1,1055 @@
+#pragma once
+
+#include "m_vector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace m_std
+{
+
+// an ordered map for many readers and a few writers: the relaxed-balance AVL tree of
+// Bronson, Casper, Chafi and Olukotun ("A Practical Concurrent Binary Search Tree").
+//
+// readers take no lock. every node carries a version that a rotation bumps when the
+// node's key range shrinks; a reader reads a node's version, steps to the child, and
+// checks the version again, going back one level when it moved. writers lock the node
+// they hang a leaf under, the parent and node of an unlink, and the parent, node and
+// child(ren) of a rotation, always top down. an erase whose node has two children only
+// drops the value and leaves a routing node that a later rebalance unlinks.
+//
+// unlinked nodes and replaced values are freed once no reader that might still hold
+// them is left: each operation publishes the epoch it started in, and a retired object
+// waits for every published epoch to pass its own.
+//
+// values are copied out, there are no references into the map. for_each and the
+// destructor need the map to themselves; the map is neither copied nor moved.
+template <typename Key_t, typename Value_t, typename Compare = std::less<Key_t>>
+class concurrent_map
+{
+public:
+    using key_type    = Key_t;
+    using mapped_type = Value_t;
+    using key_compare = Compare;
+
+    concurrent_map() = default;
+
+    explicit concurrent_map(const Compare& comp) :
+        m_comp(comp)
+    {
+    }
+
+    concurrent_map(const concurrent_map&)            = delete;
+    concurrent_map& operator=(const concurrent_map&) = delete;
+
+    ~concurrent_map()
+    {
+        destroySubtree(m_holder.right.load(std::memory_order_relaxed));
+        for (const retired& _r : m_retired)
+        {
+            delete _r.n;
+            delete _r.box;
+        }
+    }
+
+    // live keys; exact once the writers are done
+    std::size_t size() const { return m_size.load(std::memory_order_relaxed); }
+    bool        empty() const { return size() == 0; }
+
+    // levels counting the root, 0 when empty
+    int height() const { return heightOf(m_holder.right.load()); }
+
+    // lookup ===========
+
+    // copies the value out, returns false if the key is absent
+    bool find(const Key_t& key, Value_t& out) const
+    {
+        epoch_guard _guard(*this);
+        value_box*  _box = findBox(key);
+        if (_box == nullptr)
+        {
+            return false;
+        }
+        out = _box->value;
+        return true;
+    }
+
+    bool contains(const Key_t& key) const
+    {
+        epoch_guard _guard(*this);
+        return findBox(key) != nullptr;
+    }
+
+    // update ===========
+
+    // returns false, and leaves the value alone, if the key was there
+    bool insert(const Key_t& key, const Value_t& value) { return update(mode::insert, key, &value) == result::absent; }
+
+    // returns true if the key was new
+    bool insert_or_assign(const Key_t& key, const Value_t& value)
+    {
+        return update(mode::assign, key, &value) == result::absent;
+    }
+
+    // returns true if the key was there
+    bool erase(const Key_t& key) { return update(mode::erase, key, nullptr) == result::present; }
+
+    // in key order; not safe while a writer runs
+    template <typename Fn>
+    void for_each(Fn fn) const
+    {
+        vector<node*> _stack;
+        node*         _node = m_holder.right.load();
+        while (_node != nullptr || !_stack.empty())
+        {
+            for (; _node != nullptr; _node = _node->left.load())
+            {
+                _stack.push_back(_node);
+            }
+            _node = _stack[_stack.size() - 1];
+            _stack.pop_back();
+            if (value_box* _box = _node->value.load())
+            {
+                fn(_node->key, _box->value);
+            }
+            _node = _node->right.load();
+        }
+    }
+
+private:
+    struct node;
+
+    struct value_box
+    {
+        Value_t value;
+    };
+
+    // version bits: unlinked for good, a shrinking rotation in progress, then a counter
+    static constexpr std::uint64_t unlinked     = 1;
+    static constexpr std::uint64_t shrinking    = 2;
+    static constexpr std::uint64_t version_step = 4;
+
+    static bool isShrinkingOrUnlinked(std::uint64_t version) { return (version & (unlinked | shrinking)) != 0; }
+
+    // the links of a node, and all of the holder above the root (its right child)
+    struct link
+    {
+        node* child(int dir) const { return dir < 0 ? left.load() : right.load(); }
+        void  setChild(int dir, node* child) { (dir < 0 ? left : right).store(child); }
+
+        void lock()
+        {
+            while (locked.exchange(true, std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        void unlock() { locked.store(false, std::memory_order_release); }
+
+        std::atomic<node*>         left{ nullptr };
+        std::atomic<node*>         right{ nullptr };
+        std::atomic<std::uint64_t> version{ 0 };
+        std::atomic<bool>          locked{ false };
+    };
+
+    struct node : link
+    {
+        node(const Key_t& k, value_box* box, link* p) :
+            key(k), value(box), parent(p)
+        {
+        }
+
+        const Key_t             key;
+        std::atomic<value_box*> value; // null: a routing node, its key was erased
+        std::atomic<link*>      parent;
+        std::atomic<int>        height{ 1 };
+    };
+
+    using lock_guard = std::lock_guard<link>;
+
+    enum class mode
+    {
+        insert,
+        assign,
+        erase
+    };
+
+    enum class result
+    {
+        retry,
+        absent,
+        present
+    };
+
+    // epochs ===========
+
+    static constexpr std::size_t reader_slots = 64;
+
+    struct alignas(64) reader_slot
+    {
+        std::atomic<std::uint64_t> epoch{ 0 }; // 0: free
+    };
+
+    struct retired
+    {
+        std::uint64_t epoch;
+        node*         n;
+        value_box*    box;
+    };
+
+    // publishes the epoch an operation starts in. a thread keeps to its own slot unless
+    // more threads than slots are in flight
+    class epoch_guard
+    {
+    public:
+        explicit epoch_guard(const concurrent_map& map) :
+            m_slot(map.enter())
+        {
+        }
+
+        epoch_guard(const epoch_guard&)            = delete;
+        epoch_guard& operator=(const epoch_guard&) = delete;
+
+        ~epoch_guard() { m_slot->epoch.store(0); }
+
+    private:
+        reader_slot* m_slot;
+    };
+
+    static std::size_t preferredSlot()
+    {
+        static std::atomic<std::size_t> _next{ 0 };
+        thread_local std::size_t        _slot = _next.fetch_add(1, std::memory_order_relaxed);
+        return _slot;
+    }
+
+    reader_slot* enter() const
+    {
+        std::size_t _first = preferredSlot();
+        for (;;)
+        {
+            for (std::size_t i = 0; i < reader_slots; i++)
+            {
+                reader_slot&  _slot     = m_readers[(_first + i) % reader_slots];
+                std::uint64_t _expected = 0;
+                if (_slot.epoch.load(std::memory_order_relaxed) == 0 && _slot.epoch.compare_exchange_strong(_expected, m_epoch.load()))
+                {
+                    return &_slot;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // an operation that published an epoch after this one's saw the object gone
+    void retire(node* n, value_box* box)
+    {
+        std::lock_guard<std::mutex> _guard(m_retire_lock);
+        m_retired.push_back(retired{ m_epoch.fetch_add(1), n, box });
+        if (m_retired.size() >= m_reclaim_at)
+        {
+            reclaim();
+        }
+    }
+
+    void reclaim()
+    {
+        std::uint64_t _oldest = ~std::uint64_t(0);
+        for (const reader_slot& _slot : m_readers)
+        {
+            std::uint64_t _epoch = _slot.epoch.load();
+            if (_epoch != 0)
+            {
+                _oldest = std::min(_oldest, _epoch);
+            }
+        }
+        std::size_t _kept = 0;
+        for (std::size_t i = 0; i < m_retired.size(); i++)
+        {
+            if (m_retired[i].epoch < _oldest)
+            {
+                delete m_retired[i].n;
+                delete m_retired[i].box;
+            }
+            else
+            {
+                m_retired[_kept++] = m_retired[i];
+            }
+        }
+        m_retired.resize(_kept);
+        m_reclaim_at = std::max<std::size_t>(64, 2 * _kept);
+    }
+
+    // search ===========
+
+    int compare(const Key_t& a, const Key_t& b) const { return m_comp(a, b) ? -1 : m_comp(b, a) ? 1 : 0; }
+
+    // the box goes with the node if the node cannot be made
+    static node* newNode(const Key_t& key, const Value_t& value, link* parent)
+    {
+        std::unique_ptr<value_box> _box(new value_box{ value });
+        node*                      _node = new node(key, _box.get(), parent);
+        _box.release();
+        return _node;
+    }
+
+    static int heightOf(const node* n) { return n == nullptr ? 0 : n->height.load(); }
+
+    static void waitUntilShrinkCompleted(const node* n, std::uint64_t version)
+    {
+        if ((version & shrinking) == 0)
+        {
+            return;
+        }
+        for (int i = 0; n->version.load() == version; i++)
+        {
+            if (i >= 100)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    value_box* findBox(const Key_t& key) const
+    {
+        for (;;)
+        {
+            node* _root = m_holder.right.load();
+            if (_root == nullptr)
+            {
+                return nullptr;
+            }
+            int _cmp = compare(key, _root->key);
+            if (_cmp == 0)
+            {
+                return _root->value.load();
+            }
+            std::uint64_t _version = _root->version.load();
+            if (isShrinkingOrUnlinked(_version))
+            {
+                waitUntilShrinkCompleted(_root, _version);
+            }
+            else if (_root == m_holder.right.load())
+            {
+                value_box* _box = nullptr;
+                if (attemptGet(key, _root, _cmp, _version, _box) != result::retry)
+                {
+                    return _box;
+                }
+            }
+        }
+    }
+
+    // node was reached while its version was node_version; the step to a child only counts
+    // if that version still holds after the child was read. once the child's own version
+    // is read and the step validated, rotations at node no longer matter
+    result attemptGet(const Key_t& key, const node* n, int dir, std::uint64_t node_version, value_box*& box) const
+    {
+        for (;;)
+        {
+            node* _child = n->child(dir);
+            if (_child == nullptr)
+            {
+                return n->version.load() != node_version ? result::retry : result::absent;
+            }
+            int _cmp = compare(key, _child->key);
+            if (_cmp == 0)
+            {
+                // the key never changes; an unlinked node has dropped its value
+                box = _child->value.load();
+                return result::present;
+            }
+            std::uint64_t _child_version = _child->version.load();
+            if (isShrinkingOrUnlinked(_child_version))
+            {
+                waitUntilShrinkCompleted(_child, _child_version);
+                if (n->version.load() != node_version)
+                {
+                    return result::retry;
+                }
+            }
+            else if (_child != n->child(dir))
+            {
+                if (n->version.load() != node_version)
+                {
+                    return result::retry;
+                }
+            }
+            else
+            {
+                if (n->version.load() != node_version)
+                {
+                    return result::retry;
+                }
+                result _result = attemptGet(key, _child, _cmp, _child_version, box);
+                if (_result != result::retry)
+                {
+                    return _result;
+                }
+            }
+        }
+    }
+
+    // update ===========
+
+    // value is null for an erase. its box is only made once the key is found absent,
+    // or for an assign
+    result update(mode how, const Key_t& key, const Value_t* value)
+    {
+        result _result;
+        {
+            epoch_guard _guard(*this);
+            for (;;)
+            {
+                node* _root = m_holder.right.load();
+                if (_root == nullptr)
+                {
+                    if (how == mode::erase)
+                    {
+                        _result = result::absent;
+                        break;
+                    }
+                    lock_guard _lock(m_holder);
+                    if (m_holder.right.load() == nullptr)
+                    {
+                        m_holder.right.store(newNode(key, *value, &m_holder));
+                        _result = result::absent;
+                        break;
+                    }
+                    continue;
+                }
+                std::uint64_t _version = _root->version.load();
+                if (isShrinkingOrUnlinked(_version))
+                {
+                    waitUntilShrinkCompleted(_root, _version);
+                }
+                else if (_root == m_holder.right.load())
+                {
+                    _result = attemptUpdate(how, key, value, &m_holder, _root, _version);
+                    if (_result != result::retry)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        bool _added   = how != mode::erase && _result == result::absent;
+        bool _removed = how == mode::erase && _result == result::present;
+        if (_added)
+        {
+            m_size.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (_removed)
+        {
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return _result;
+    }
+
+    result attemptUpdate(mode how, const Key_t& key, const Value_t* value, link* parent, node* n, std::uint64_t node_version)
+    {
+        int _dir = compare(key, n->key);
+        if (_dir == 0)
+        {
+            return attemptNodeUpdate(how, value, parent, n);
+        }
+
+        for (;;)
+        {
+            node* _child = n->child(_dir);
+            if (n->version.load() != node_version)
+            {
+                return result::retry;
+            }
+
+            if (_child == nullptr)
+            {
+                if (how == mode::erase)
+                {
+                    return result::absent;
+                }
+                link* _damaged = nullptr;
+                {
+                    lock_guard _lock(*n);
+                    // under the lock no rotation can move n; did one before it?
+                    if (n->version.load() != node_version)
+                    {
+                        return result::retry;
+                    }
+                    if (n->child(_dir) == nullptr)
+                    {
+                        n->setChild(_dir, newNode(key, *value, n));
+                        _damaged = fixHeight_nl(n);
+                    }
+                    else
+                    {
+                        // lost a race with another insert here, look again
+                        continue;
+                    }
+                }
+                fixHeightAndRebalance(_damaged);
+                return result::absent;
+            }
+
+            std::uint64_t _child_version = _child->version.load();
+            if (isShrinkingOrUnlinked(_child_version))
+            {
+                waitUntilShrinkCompleted(_child, _child_version);
+            }
+            else if (_child == n->child(_dir))
+            {
+                if (n->version.load() != node_version)
+                {
+                    return result::retry;
+                }
+                result _result = attemptUpdate(how, key, value, n, _child, _child_version);
+                if (_result != result::retry)
+                {
+                    return _result;
+                }
+            }
+        }
+    }
+
+    // parent is only needed to unlink n
+    result attemptNodeUpdate(mode how, const Value_t* value, link* parent, node* n)
+    {
+        if (how == mode::erase && n->value.load() == nullptr)
+        {
+            return result::absent;
+        }
+
+        if (how == mode::erase && (n->left.load() == nullptr || n->right.load() == nullptr))
+        {
+            value_box* _previous = nullptr;
+            link*      _damaged  = nullptr;
+            {
+                lock_guard _parent_lock(*parent);
+                if ((parent->version.load() & unlinked) != 0 || n->parent.load() != parent)
+                {
+                    return result::retry;
+                }
+                {
+                    lock_guard _lock(*n);
+                    _previous = n->value.load();
+                    if (_previous == nullptr)
+                    {
+                        return result::absent;
+                    }
+                    if (!attemptUnlink_nl(parent, n))
+                    {
+                        return result::retry;
+                    }
+                }
+                _damaged = fixHeight_nl(parent);
+            }
+            retire(n, _previous);
+            fixHeightAndRebalance(_damaged);
+            return result::present;
+        }
+
+        value_box* _previous = nullptr;
+        {
+            lock_guard _lock(*n);
+            if ((n->version.load() & unlinked) != 0)
+            {
+                return result::retry;
+            }
+            _previous = n->value.load();
+            if (how == mode::insert)
+            {
+                if (_previous != nullptr)
+                {
+                    return result::present;
+                }
+                n->value.store(new value_box{ *value });
+                return result::absent;
+            }
+            if (how == mode::erase)
+            {
+                if (_previous == nullptr)
+                {
+                    return result::absent;
+                }
+                // a child went away since we looked, so n can be unlinked after all
+                if (n->left.load() == nullptr || n->right.load() == nullptr)
+                {
+                    return result::retry;
+                }
+            }
+            n->value.store(value != nullptr ? new value_box{ *value } : nullptr);
+        }
+        if (_previous != nullptr)
+        {
+            retire(nullptr, _previous);
+        }
+        return _previous != nullptr ? result::present : result::absent;
+    }
+
+    // parent and n locked; splices n's only child (or nothing) into its place
+    bool attemptUnlink_nl(link* parent, node* n)
+    {
+        node* _parent_left  = parent->left.load();
+        node* _parent_right = parent->right.load();
+        if (_parent_left != n && _parent_right != n)
+        {
+            return false;
+        }
+        node* _left  = n->left.load();
+        node* _right = n->right.load();
+        if (_left != nullptr && _right != nullptr)
+        {
+            return false;
+        }
+        node* _splice = _left != nullptr ? _left : _right;
+        if (_parent_left == n)
+        {
+            parent->left.store(_splice);
+        }
+        else
+        {
+            parent->right.store(_splice);
+        }
+        if (_splice != nullptr)
+        {
+            _splice->parent.store(parent);
+        }
+        n->version.store(unlinked);
+        n->value.store(nullptr);
+        return true;
+    }
+
+    // rebalancing ===========
+
+    static constexpr int unlink_required    = -1;
+    static constexpr int rebalance_required = -2;
+    static constexpr int nothing_required   = -3;
+
+    // the repair n needs, or its corrected height. the reads are not atomic together, but
+    // whoever changes a node promises to repair it, so a stale "nothing" is someone else's
+    static int nodeCondition(const node* n)
+    {
+        node* _left  = n->left.load();
+        node* _right = n->right.load();
+        if ((_left == nullptr || _right == nullptr) && n->value.load() == nullptr)
+        {
+            return unlink_required;
+        }
+        int _height = n->height.load();
+        int _hl     = heightOf(_left);
+        int _hr     = heightOf(_right);
+        int _repl   = 1 + std::max(_hl, _hr);
+        int _bal    = _hl - _hr;
+        if (_bal < -1 || _bal > 1)
+        {
+            return rebalance_required;
+        }
+        return _height != _repl ? _repl : nothing_required;
+    }
+
+    // walks the damage up from a node, locking the node (or its parent too) per repair
+    void fixHeightAndRebalance(link* damaged)
+    {
+        while (damaged != nullptr && damaged != &m_holder)
+        {
+            node* _node      = static_cast<node*>(damaged);
+            int   _condition = nodeCondition(_node);
+            if (_condition == nothing_required || (_node->version.load() & unlinked) != 0)
+            {
+                return;
+            }
+            if (_condition != unlink_required && _condition != rebalance_required)
+            {
+                lock_guard _lock(*_node);
+                damaged = fixHeight_nl(_node);
+            }
+            else
+            {
+                link*      _parent = _node->parent.load();
+                lock_guard _parent_lock(*_parent);
+                if ((_parent->version.load() & unlinked) == 0 && _node->parent.load() == _parent)
+                {
+                    lock_guard _lock(*_node);
+                    damaged = rebalance_nl(_parent, _node);
+                }
+            }
+        }
+    }
+
+    // l locked; fixes its height if that is all it needs. returns the next damaged node
+    // this thread answers for
+    link* fixHeight_nl(link* l)
+    {
+        if (l == &m_holder)
+        {
+            return nullptr;
+        }
+        node* _node      = static_cast<node*>(l);
+        int   _condition = nodeCondition(_node);
+        if (_condition == rebalance_required || _condition == unlink_required)
+        {
+            return _node;
+        }
+        if (_condition == nothing_required)
+        {
+            return nullptr;
+        }
+        _node->height.store(_condition);
+        return _node->parent.load();
+    }
+
+    // parent and n locked
+    link* rebalance_nl(link* parent, node* n)
+    {
+        node* _left  = n->left.load();
+        node* _right = n->right.load();
+        if ((_left == nullptr || _right == nullptr) && n->value.load() == nullptr)
+        {
+            if (attemptUnlink_nl(parent, n))
+            {
+                retire(n, nullptr);
+                return fixHeight_nl(parent);
+            }
+            return n;
+        }
+
+        int _height = n->height.load();
+        int _hl     = heightOf(_left);
+        int _hr     = heightOf(_right);
+        int _repl   = 1 + std::max(_hl, _hr);
+        int _bal    = _hl - _hr;
+        if (_bal > 1)
+        {
+            return rebalanceToRight_nl(parent, n, _left, _hr);
+        }
+        if (_bal < -1)
+        {
+            return rebalanceToLeft_nl(parent, n, _right, _hl);
+        }
+        if (_repl != _height)
+        {
+            n->height.store(_repl);
+            return fixHeight_nl(parent);
+        }
+        return nullptr;
+    }
+
+    // n's left side is too tall: rotate right, first rotating left at nl if its inner
+    // grandchild is the taller one
+    link* rebalanceToRight_nl(link* parent, node* n, node* nl, int hr0)
+    {
+        lock_guard _lock(*nl);
+        int        _hl = nl->height.load();
+        if (_hl - hr0 <= 1)
+        {
+            return n;
+        }
+        node* _nlr  = nl->right.load();
+        int   _hll0 = heightOf(nl->left.load());
+        int   _hlr0 = heightOf(_nlr);
+        if (_hll0 >= _hlr0)
+        {
+            return rotateRight_nl(parent, n, nl, hr0, _hll0, _nlr, _hlr0);
+        }
+        {
+            lock_guard _inner_lock(*_nlr);
+            int        _hlr = _nlr->height.load();
+            if (_hll0 >= _hlr)
+            {
+                return rotateRight_nl(parent, n, nl, hr0, _hll0, _nlr, _hlr);
+            }
+            // a double rotation only when it leaves nl balanced and not a bare routing node
+            int _hlrl = heightOf(_nlr->left.load());
+            int _b    = _hll0 - _hlrl;
+            if (_b >= -1 && _b <= 1 && !((_hll0 == 0 || _hlrl == 0) && nl->value.load() == nullptr))
+            {
+                return rotateRightOverLeft_nl(parent, n, nl, hr0, _hll0, _nlr, _hlrl);
+            }
+        }
+        // fix nl on its own, n comes back round if it still needs it
+        return rebalanceToLeft_nl(n, nl, _nlr, _hll0);
+    }
+
+    link* rebalanceToLeft_nl(link* parent, node* n, node* nr, int hl0)
+    {
+        lock_guard _lock(*nr);
+        int        _hr = nr->height.load();
+        if (hl0 - _hr >= -1)
+        {
+            return n;
+        }
+        node* _nrl  = nr->left.load();
+        int   _hrl0 = heightOf(_nrl);
+        int   _hrr0 = heightOf(nr->right.load());
+        if (_hrr0 >= _hrl0)
+        {
+            return rotateLeft_nl(parent, n, hl0, nr, _nrl, _hrl0, _hrr0);
+        }
+        {
+            lock_guard _inner_lock(*_nrl);
+            int        _hrl = _nrl->height.load();
+            if (_hrr0 >= _hrl)
+            {
+                return rotateLeft_nl(parent, n, hl0, nr, _nrl, _hrl, _hrr0);
+            }
+            int _hrlr = heightOf(_nrl->right.load());
+            int _b    = _hrr0 - _hrlr;
+            if (_b >= -1 && _b <= 1 && !((_hrr0 == 0 || _hrlr == 0) && nr->value.load() == nullptr))
+            {
+                return rotateLeftOverRight_nl(parent, n, hl0, nr, _nrl, _hrr0, _hrlr);
+            }
+        }
+        return rebalanceToRight_nl(n, nr, _nrl, _hrr0);
+    }
+
+    static void replaceChild(link* parent, node* old_child, node* new_child)
+    {
+        if (parent->left.load() == old_child)
+        {
+            parent->left.store(new_child);
+        }
+        else
+        {
+            parent->right.store(new_child);
+        }
+        new_child->parent.store(parent);
+    }
+
+    // the node that moves down has its key range cut, so its version marks the change
+    static void beginChange(node* n, std::uint64_t version) { n->version.store(version | shrinking); }
+    static void endChange(node* n, std::uint64_t version) { n->version.store((version | (unlinked | shrinking)) + 1); }
+
+    // returns the deepest node the rotation left damaged, repairing what the held
+    // locks allow
+    link* rotateRight_nl(link* parent, node* n, node* nl, int hr, int hll, node* nlr, int hlr)
+    {
+        std::uint64_t _version = n->version.load();
+        beginChange(n, _version);
+
+        n->left.store(nlr);
+        if (nlr != nullptr)
+        {
+            nlr->parent.store(n);
+        }
+        nl->right.store(n);
+        n->parent.store(nl);
+        replaceChild(parent, n, nl);
+
+        int _hn = 1 + std::max(hlr, hr);
+        n->height.store(_hn);
+        nl->height.store(1 + std::max(hll, _hn));
+
+        endChange(n, _version);
+
+        int _bal_n = hlr - hr;
+        if (_bal_n < -1 || _bal_n > 1)
+        {
+            return n;
+        }
+        if ((nlr == nullptr || hr == 0) && n->value.load() == nullptr)
+        {
+            return n;
+        }
+        int _bal_l = hll - _hn;
+        if (_bal_l < -1 || _bal_l > 1)
+        {
+            return nl;
+        }
+        if (hll == 0 && nl->value.load() == nullptr)
+        {
+            return nl;
+        }
+        return fixHeight_nl(parent);
+    }
+
+    link* rotateLeft_nl(link* parent, node* n, int hl, node* nr, node* nrl, int hrl, int hrr)
+    {
+        std::uint64_t _version = n->version.load();
+        beginChange(n, _version);
+
+        n->right.store(nrl);
+        if (nrl != nullptr)
+        {
+            nrl->parent.store(n);
+        }
+        nr->left.store(n);
+        n->parent.store(nr);
+        replaceChild(parent, n, nr);
+
+        int _hn = 1 + std::max(hl, hrl);
+        n->height.store(_hn);
+        nr->height.store(1 + std::max(_hn, hrr));
+
+        endChange(n, _version);
+
+        int _bal_n = hrl - hl;
+        if (_bal_n < -1 || _bal_n > 1)
+        {
+            return n;
+        }
+        if ((nrl == nullptr || hl == 0) && n->value.load() == nullptr)
+        {
+            return n;
+        }
+        int _bal_r = hrr - _hn;
+        if (_bal_r < -1 || _bal_r > 1)
+        {
+            return nr;
+        }
+        if (hrr == 0 && nr->value.load() == nullptr)
+        {
+            return nr;
+        }
+        return fixHeight_nl(parent);
+    }
+
+    link* rotateRightOverLeft_nl(link* parent, node* n, node* nl, int hr, int hll, node* nlr, int hlrl)
+    {
+        std::uint64_t _version      = n->version.load();
+        std::uint64_t _left_version = nl->version.load();
+        node*         _nlrl         = nlr->left.load();
+        node*         _nlrr         = nlr->right.load();
+        int           _hlrr         = heightOf(_nlrr);
+
+        beginChange(n, _version);
+        beginChange(nl, _left_version);
+
+        n->left.store(_nlrr);
+        if (_nlrr != nullptr)
+        {
+            _nlrr->parent.store(n);
+        }
+        nl->right.store(_nlrl);
+        if (_nlrl != nullptr)
+        {
+            _nlrl->parent.store(nl);
+        }
+        nlr->left.store(nl);
+        nl->parent.store(nlr);
+        nlr->right.store(n);
+        n->parent.store(nlr);
+        replaceChild(parent, n, nlr);
+
+        int _hn = 1 + std::max(_hlrr, hr);
+        n->height.store(_hn);
+        int _hl = 1 + std::max(hll, hlrl);
+        nl->height.store(_hl);
+        nlr->height.store(1 + std::max(_hl, _hn));
+
+        endChange(n, _version);
+        endChange(nl, _left_version);
+
+        int _bal_n = _hlrr - hr;
+        if (_bal_n < -1 || _bal_n > 1)
+        {
+            return n;
+        }
+        if ((_nlrr == nullptr || hr == 0) && n->value.load() == nullptr)
+        {
+            return n;
+        }
+        int _bal_lr = _hl - _hn;
+        if (_bal_lr < -1 || _bal_lr > 1)
+        {
+            return nlr;
+        }
+        return fixHeight_nl(parent);
+    }
+
+    link* rotateLeftOverRight_nl(link* parent, node* n, int hl, node* nr, node* nrl, int hrr, int hrlr)
+    {
+        std::uint64_t _version       = n->version.load();
+        std::uint64_t _right_version = nr->version.load();
+        node*         _nrll          = nrl->left.load();
+        node*         _nrlr          = nrl->right.load();
+        int           _hrll          = heightOf(_nrll);
+
+        beginChange(n, _version);
+        beginChange(nr, _right_version);
+
+        n->right.store(_nrll);
+        if (_nrll != nullptr)
+        {
+            _nrll->parent.store(n);
+        }
+        nr->left.store(_nrlr);
+        if (_nrlr != nullptr)
+        {
+            _nrlr->parent.store(nr);
+        }
+        nrl->right.store(nr);
+        nr->parent.store(nrl);
+        nrl->left.store(n);
+        n->parent.store(nrl);
+        replaceChild(parent, n, nrl);
+
+        int _hn = 1 + std::max(hl, _hrll);
+        n->height.store(_hn);
+        int _hr = 1 + std::max(hrlr, hrr);
+        nr->height.store(_hr);
+        nrl->height.store(1 + std::max(_hn, _hr));
+
+        endChange(n, _version);
+        endChange(nr, _right_version);
+
+        int _bal_n = _hrll - hl;
+        if (_bal_n < -1 || _bal_n > 1)
+        {
+            return n;
+        }
+        if ((_nrll == nullptr || hl == 0) && n->value.load() == nullptr)
+        {
+            return n;
+        }
+        int _bal_rl = _hr - _hn;
+        if (_bal_rl < -1 || _bal_rl > 1)
+        {
+            return nrl;
+        }
+        return fixHeight_nl(parent);
+    }
+
+    static void destroySubtree(node* n)
+    {
+        vector<node*> _stack;
+        if (n != nullptr)
+        {
+            _stack.push_back(n);
+        }
+        while (!_stack.empty())
+        {
+            node* _node = _stack[_stack.size() - 1];
+            _stack.pop_back();
+            if (node* _left = _node->left.load(std::memory_order_relaxed))
+            {
+                _stack.push_back(_left);
+            }
+            if (node* _right = _node->right.load(std::memory_order_relaxed))
+            {
+                _stack.push_back(_right);
+            }
+            delete _node->value.load(std::memory_order_relaxed);
+            delete _node;
+        }
+    }
+
+    Compare                    m_comp = Compare();
+    link                       m_holder;
+    std::atomic<std::size_t>   m_size{ 0 };
+    mutable reader_slot        m_readers[reader_slots];
+    std::atomic<std::uint64_t> m_epoch{ 1 };
+    std::mutex                 m_retire_lock;
+    vector<retired>            m_retired;
+    std::size_t                m_reclaim_at = 64;
+};
+
+} // namespace m_std
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "m_allocator.h"
+
+namespace m_std
+{
+
+// append-only vector for many producer threads. storage is a table of segments whose
+// sizes double (8, 16, 32, ...), so growing never moves an element: references and
+// indices stay valid for the life of the container. push_back / grow_by reserve slots
+// with one fetch_add and allocate a missing segment with one CAS, no locks.
+//
+// size() counts reserved slots. an element may be read once the call that built it has
+// returned and that is visible to the reader (thread join, or the index handed over
+// through an atomic / queue). clear(), copy and destruction are not thread-safe.
+//
+// a reserved slot can't be handed back: if its segment can't be allocated or T's
+// constructor throws, the call rethrows and the slot stays empty for good. reading it is
+// undefined; a T that needs destroying carries a built flag per slot, so clear() and the
+// destructor skip it.
+template <typename T, typename Allocator = allocator<T>>
+class concurrent_vector
+{
+public:
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using size_t         = std::size_t;
+
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    static constexpr size_t first_segment_bits = 3;
+    static constexpr size_t first_segment_size = size_t(1) << first_segment_bits;
+    static constexpr size_t max_segments       = sizeof(size_t) * 8 - first_segment_bits;
+
+    // trivially destructible elements need no record of which slots were built
+    static constexpr bool track_built = !std::is_trivially_destructible<T>::value;
+
+    std::atomic<T*>             m_segments[max_segments] = {};
+    std::atomic<unsigned char*> m_built[max_segments]    = {}; // one byte a slot, 1 once built
+    std::atomic<size_t>         m_size{ 0 };
+    Allocator                   m_alloc;
+
+public:
+    concurrent_vector() = default;
+
+    explicit concurrent_vector(const Allocator& alloc) :
+        m_alloc(alloc)
+    {
+    }
+
+    concurrent_vector(const concurrent_vector&)            = delete;
+    concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+    ~concurrent_vector()
+    {
+        clear();
+    }
+
+    // returns the slot index, which stays valid forever
+    size_t push_back(const T& value)
+    {
+        return emplace_back(value);
+    }
+
+    size_t push_back(T&& value)
+    {
+        return emplace_back(std::move(value));
+    }
+
+    template <typename... Args>
+    size_t emplace_back(Args&&... args)
+    {
+        size_t _index = m_size.fetch_add(1, std::memory_order_relaxed);
+        construct_at(_index, std::forward<Args>(args)...);
+        return _index;
+    }
+
+    // reserve n consecutive slots in one atomic step, returns the first index. if a copy
+    // throws, the slots from there on stay empty
+    size_t grow_by(size_t n, const T& value = T())
+    {
+        size_t _first = m_size.fetch_add(n, std::memory_order_relaxed);
+        for (size_t i = 0; i < n; i++)
+        {
+            construct_at(_first + i, value);
+        }
+        return _first;
+    }
+
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+    bool   empty() const { return size() == 0; }
+
+    // bytes owned: the object plus every allocated segment
+    size_t memory_usage() const
+    {
+        size_t _bytes = sizeof(*this);
+        for (size_t k = 0; k < max_segments; k++)
+        {
+            if (m_segments[k].load(std::memory_order_acquire) != nullptr)
+            {
+                _bytes += segment_size(k) * sizeof(T);
+            }
+            if (m_built[k].load(std::memory_order_acquire) != nullptr)
+            {
+                _bytes += segment_size(k);
+            }
+        }
+        return _bytes;
+    }
+
+    T& operator[](size_t index)
+    {
+        return *existing_slot(index);
+    }
+
+    const T& operator[](size_t index) const
+    {
+        return *existing_slot(index);
+    }
+
+    T& at(size_t index)
+    {
+        if (index >= size())
+        {
+            throw std::out_of_range("index out of range");
+        }
+        return *existing_slot(index);
+    }
+
+    // not thread-safe
+    void clear()
+    {
+        for (size_t k = 0; k < max_segments; k++)
+        {
+            T*             _segment = m_segments[k].load(std::memory_order_relaxed);
+            unsigned char* _built   = m_built[k].load(std::memory_order_relaxed);
+            if (_built != nullptr)
+            {
+                for (size_t i = 0; i < segment_size(k); i++)
+                {
+                    if (_built[i])
+                    {
+                        _segment[i].~T();
+                    }
+                }
+                delete[] _built;
+                m_built[k].store(nullptr, std::memory_order_relaxed);
+            }
+            if (_segment != nullptr)
+            {
+                alloc_traits::deallocate(m_alloc, _segment, segment_size(k));
+                m_segments[k].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        m_size.store(0, std::memory_order_relaxed);
+    }
+
+    // iterator ===========
+
+    template <bool IsConst>
+    class basic_iterator
+    {
+        using owner_type = typename std::conditional<IsConst, const concurrent_vector, concurrent_vector>::type;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = typename std::conditional<IsConst, const T&, T&>::type;
+        using pointer           = typename std::conditional<IsConst, const T*, T*>::type;
+
+        basic_iterator() = default;
+        basic_iterator(owner_type* owner, size_t index) :
+            m_owner(owner), m_index(index) { }
+
+        reference operator*() const { return (*m_owner)[m_index]; }
+        pointer   operator->() const { return &(*m_owner)[m_index]; }
+
+        basic_iterator& operator++()
+        {
+            m_index++;
+            return *this;
+        }
+
+        basic_iterator operator++(int)
+        {
+            basic_iterator _tmp = *this;
+            m_index++;
+            return _tmp;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.m_index == b.m_index; }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return !(a == b); }
+
+    private:
+        owner_type* m_owner = nullptr;
+        size_t      m_index = 0;
+    };
+
+    using iterator       = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    // a snapshot of [0, size())
+    iterator       begin() { return iterator(this, 0); }
+    iterator       end() { return iterator(this, size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    // segment k covers [first_segment_size * (2^k - 1), first_segment_size * (2^(k+1) - 1))
+    static size_t segment_of(size_t index)
+    {
+        return highest_bit(index + first_segment_size) - first_segment_bits;
+    }
+
+    static size_t segment_base(size_t k) { return first_segment_size * ((size_t(1) << k) - 1); }
+    static size_t segment_size(size_t k) { return first_segment_size << k; }
+
+    // v > 0
+    static size_t highest_bit(size_t v)
+    {
+#if defined(__GNUC__)
+        return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(v);
+#else
+        size_t _bit = 0;
+        while (v >>= 1)
+        {
+            _bit++;
+        }
+        return _bit;
+#endif
+    }
+
+    // the slot for a reserved index, allocating its segment if nobody has yet
+    T* slot(size_t index)
+    {
+        size_t k        = segment_of(index);
+        T*     _segment = m_segments[k].load(std::memory_order_acquire);
+        if (_segment == nullptr)
+        {
+            T* _fresh = alloc_traits::allocate(m_alloc, segment_size(k));
+            if (m_segments[k].compare_exchange_strong(_segment, _fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                _segment = _fresh;
+            }
+            else
+            {
+                // another producer won the race, _segment now holds its pointer
+                alloc_traits::deallocate(m_alloc, _fresh, segment_size(k));
+            }
+        }
+        return _segment + (index - segment_base(k));
+    }
+
+    T* existing_slot(size_t index) const
+    {
+        size_t k = segment_of(index);
+        return m_segments[k].load(std::memory_order_acquire) + (index - segment_base(k));
+    }
+
+    // the built flags of segment k, allocated by whoever needs them first
+    unsigned char* built_flags(size_t k)
+    {
+        unsigned char* _built = m_built[k].load(std::memory_order_acquire);
+        if (_built == nullptr)
+        {
+            unsigned char* _fresh = new unsigned char[segment_size(k)]();
+            if (m_built[k].compare_exchange_strong(_built, _fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                _built = _fresh;
+            }
+            else
+            {
+                delete[] _fresh;
+            }
+        }
+        return _built;
+    }
+
+    // everything that can fail comes before the flag is set, so a throw leaves the slot
+    // unbuilt and unflagged. each slot's flag byte is written by its one producer only
+    template <typename... Args>
+    void construct_at(size_t index, Args&&... args)
+    {
+        T* _slot = slot(index);
+        if constexpr (track_built)
+        {
+            unsigned char* _built = built_flags(segment_of(index));
+            ::new (_slot) T(std::forward<Args>(args)...);
+            _built[index - segment_base(segment_of(index))] = 1;
+        }
+        else
+        {
+            ::new (_slot) T(std::forward<Args>(args)...);
+        }
+    }
+};
+
+} // namespace m_std
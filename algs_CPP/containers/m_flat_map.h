@@ -0,0 +1,302 @@
+#pragma once
+
+#include "m_pair.h"
+#include "m_simd.h"
+#include "m_vector.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+
+#if defined(_MSC_VER) && !defined(__clang__) && M_SIMD_X86
+#    include <xmmintrin.h>
+#endif
+
+namespace m_std
+{
+
+namespace detail
+{
+
+inline void prefetch(const void* p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#elif M_SIMD_X86
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
+} // namespace detail
+
+// a read-mostly map: the records sit sorted in one m_std::vector, so lookups are binary
+// searches and a scan is a walk over an array. updates are staged and land together on
+// commit(): one sort of the batch and one merge with the records. until then lookups and
+// iteration see the records as of the last commit.
+//
+// use_index(true) adds an Eytzinger copy of the keys: the keys in the order of a
+// breadth-first walk of the implicit search tree, so the first levels share cache lines
+// and the next ones can be prefetched. the descent has no branch to mispredict. it costs
+// a key and a 32-bit rank a record and is rebuilt by every commit
+template <typename Key_t, typename Value_t, typename Compare = std::less<Key_t>>
+class flat_map
+{
+public:
+    using key_type       = Key_t;
+    using mapped_type    = Value_t;
+    using key_compare    = Compare;
+    using pair_type      = pair<Key_t, Value_t>;
+    using iterator       = pair_type*;
+    using const_iterator = const pair_type*;
+
+    flat_map() = default;
+
+    explicit flat_map(const Compare& comp) :
+        m_comp(comp)
+    {
+    }
+
+    std::size_t size() const { return m_records.size(); }
+    bool        empty() const { return m_records.empty(); }
+    std::size_t pending() const { return m_pending.size(); }
+
+    const Compare& key_comp() const { return m_comp; }
+
+    // bytes owned by this map: the object, the records, the index and the staged updates
+    std::size_t memory_usage() const
+    {
+        return sizeof(*this) + m_records.memory_usage() - sizeof(m_records) + m_index.memory_usage() - sizeof(m_index) +
+               m_rank.memory_usage() - sizeof(m_rank) + m_pending.memory_usage() - sizeof(m_pending);
+    }
+
+    // updates ===========
+
+    // staged until commit(). an insert leaves an existing key alone, insert_or_assign
+    // replaces its value; for one key, later calls win over earlier ones
+    void insert(const Key_t& key, const Value_t& value) { stage(update::insert, key, value); }
+    void insert(Key_t&& key, Value_t&& value) { stage(update::insert, std::move(key), std::move(value)); }
+    void insert_or_assign(const Key_t& key, const Value_t& value) { stage(update::assign, key, value); }
+    void erase(const Key_t& key) { stage(update::erase, key, Value_t()); }
+
+    // sorts the staged updates and merges them into the records: O(n + m log m) for m
+    // updates on n records, against O(m log n) tree inserts that each end in a cache miss
+    void commit()
+    {
+        if (m_pending.empty())
+        {
+            return;
+        }
+
+        std::stable_sort(m_pending.begin(), m_pending.end(), [this](const staged& a, const staged& b) { return keyLess(a.kv.first, b.kv.first); });
+
+        vector<pair_type> _merged;
+        _merged.reserve(m_records.size() + m_pending.size());
+
+        pair_type*    _record = m_records.begin();
+        pair_type*    _last   = m_records.end();
+        staged*       _update = m_pending.begin();
+        staged* const _end    = m_pending.end();
+        while (_update != _end)
+        {
+            staged* _group_end = _update + 1;
+            while (_group_end != _end && !keyLess(_update->kv.first, _group_end->kv.first))
+            {
+                ++_group_end;
+            }
+
+            for (; _record != _last && keyLess(_record->first, _update->kv.first); ++_record)
+            {
+                _merged.push_back(std::move(*_record));
+            }
+            bool _present = _record != _last && !keyLess(_update->kv.first, _record->first);
+            if (_present)
+            {
+                _merged.push_back(std::move(*_record++));
+            }
+
+            // the key's updates in the order they were made
+            for (; _update != _group_end; ++_update)
+            {
+                if (_update->kind == update::erase)
+                {
+                    if (_present)
+                    {
+                        _merged.pop_back();
+                    }
+                    _present = false;
+                }
+                else if (!_present)
+                {
+                    _merged.push_back(std::move(_update->kv));
+                    _present = true;
+                }
+                else if (_update->kind == update::assign)
+                {
+                    _merged[_merged.size() - 1].second = std::move(_update->kv.second);
+                }
+            }
+        }
+        for (; _record != _last; ++_record)
+        {
+            _merged.push_back(std::move(*_record));
+        }
+
+        // a bulk load would otherwise keep its staging buffer for good
+        m_records = std::move(_merged);
+        m_pending = vector<staged>();
+        if (m_indexed)
+        {
+            buildIndex();
+        }
+    }
+
+    // builds or drops the Eytzinger index. records beyond the 32-bit ranks stay unindexed
+    void use_index(bool on)
+    {
+        m_indexed = on;
+        if (on)
+        {
+            buildIndex();
+        }
+        else
+        {
+            m_index = aligned_vector<Key_t>();
+            m_rank  = vector<std::uint32_t>();
+        }
+    }
+
+    bool indexed() const { return m_indexed && !m_index.empty(); }
+
+    // lookup ===========
+
+    iterator       find(const Key_t& key) { return m_records.begin() + findRank(key); }
+    const_iterator find(const Key_t& key) const { return m_records.begin() + findRank(key); }
+
+    bool contains(const Key_t& key) const { return find(key) != end(); }
+
+    // the first record with a key not less than key
+    iterator       lower_bound(const Key_t& key) { return m_records.begin() + lowerRank(key); }
+    const_iterator lower_bound(const Key_t& key) const { return m_records.begin() + lowerRank(key); }
+
+    // iteration, in key order ===========
+
+    iterator       begin() { return m_records.begin(); }
+    iterator       end() { return m_records.end(); }
+    const_iterator begin() const { return m_records.begin(); }
+    const_iterator end() const { return m_records.end(); }
+
+private:
+    enum class update : std::uint8_t
+    {
+        insert,
+        assign,
+        erase
+    };
+
+    struct staged
+    {
+        pair_type kv;
+        update    kind;
+    };
+
+    // one cache line of index keys holds this many; a descent that reaches slot k will
+    // need slots 16k.. four levels further down for 4-byte keys, so it asks for them now
+    static constexpr std::size_t keys_per_line = sizeof(Key_t) < 64 ? 64 / sizeof(Key_t) : 1;
+
+    template <typename K, typename V>
+    void stage(update kind, K&& key, V&& value)
+    {
+        m_pending.push_back(staged{ pair_type(std::forward<K>(key), std::forward<V>(value)), kind });
+    }
+
+    template <typename A, typename B>
+    bool keyLess(const A& a, const B& b) const
+    {
+        return m_comp(a, b);
+    }
+
+    std::size_t lowerRank(const Key_t& key) const
+    {
+        return indexed() ? indexedRank(key) : sortedRank(key);
+    }
+
+    // the record holding key, or size() when there is none
+    std::size_t findRank(const Key_t& key) const
+    {
+        std::size_t _rank = lowerRank(key);
+        return _rank != m_records.size() && !keyLess(key, m_records[_rank].first) ? _rank : m_records.size();
+    }
+
+    // halves the range without a branch; ends on one record left to look at
+    std::size_t sortedRank(const Key_t& key) const
+    {
+        const pair_type* _base = m_records.begin();
+        std::size_t      _n    = m_records.size();
+        while (_n > 1)
+        {
+            std::size_t _half = _n / 2;
+            _base             = keyLess(_base[_half - 1].first, key) ? _base + _half : _base;
+            _n -= _half;
+        }
+        return std::size_t(_base - m_records.begin()) + (_n == 1 && keyLess(_base->first, key));
+    }
+
+    // slot k has its children at 2k and 2k + 1, slot 0 is unused. the descent goes right
+    // past every key less than key; the lower bound is the last slot where it went left,
+    // found by shifting the trailing right turns (and that left turn) off k
+    std::size_t indexedRank(const Key_t& key) const
+    {
+        const Key_t* _keys = m_index.data();
+        std::size_t  _n    = m_records.size();
+        std::size_t  _k    = 1;
+        while (_k <= _n)
+        {
+            detail::prefetch(_keys + std::min(_k * keys_per_line, _n));
+            _k = 2 * _k + std::size_t(keyLess(_keys[_k], key));
+        }
+        _k >>= simd::detail::count_trailing_zeros(~std::uint64_t(_k)) + 1;
+        return _k == 0 ? _n : m_rank[_k];
+    }
+
+    void buildIndex()
+    {
+        std::size_t _n = m_records.size();
+        if (_n > std::numeric_limits<std::uint32_t>::max())
+        {
+            m_index = aligned_vector<Key_t>();
+            m_rank  = vector<std::uint32_t>();
+            return;
+        }
+        m_index.resize(_n + 1);
+        m_rank.resize(_n + 1);
+        std::size_t _next = 0;
+        fillIndex(1, _next);
+    }
+
+    // an in-order walk of the implicit tree hands out the sorted records
+    void fillIndex(std::size_t k, std::size_t& next)
+    {
+        if (k > m_records.size())
+        {
+            return;
+        }
+        fillIndex(2 * k, next);
+        m_index[k] = m_records[next].first;
+        m_rank[k]  = std::uint32_t(next++);
+        fillIndex(2 * k + 1, next);
+    }
+
+    Compare                m_comp = Compare();
+    vector<pair_type>      m_records;
+    aligned_vector<Key_t>  m_index;
+    vector<std::uint32_t>  m_rank;
+    vector<staged>         m_pending;
+    bool                   m_indexed = false;
+};
+
+} // namespace m_std
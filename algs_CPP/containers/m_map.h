@@ -1,6 +1,852 @@
 #pragma once
 
+#include "m_pair.h"
+#include "m_simd.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
 namespace m_std
 {
 
-}
\ No newline at end of file
+namespace detail
+{
+
+// keys the simd kernels can order: int32_t, float and double under the default order
+template <typename Key_t, typename Compare>
+struct simd_searchable : std::integral_constant<bool, simd::detail::has_simd_ops<Key_t>::value &&
+                                                          (std::is_same<Compare, std::less<Key_t>>::value ||
+                                                           std::is_same<Compare, std::less<>>::value)>
+{
+};
+
+} // namespace detail
+
+// iterator ===========
+
+// a leaf and a slot in it. leaves keep keys and values in separate arrays, so there is no
+// pair to point at: * gives a pair of references and -> a proxy holding one. end() is a
+// null leaf; it remembers where the map keeps its last leaf so that -- can step back
+template <typename Leaf, bool IsConst = false>
+class map_iterator
+{
+    using leaf_type = typename std::conditional<IsConst, const Leaf, Leaf>::type;
+    using key_type  = typename Leaf::key_type;
+    using mapped    = typename std::conditional<IsConst, const typename Leaf::mapped_type, typename Leaf::mapped_type>::type;
+
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type        = pair<key_type, typename Leaf::mapped_type>;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = pair<const key_type&, mapped&>;
+
+    struct pointer
+    {
+        reference        ref;
+        const reference* operator->() const { return &ref; }
+    };
+
+    map_iterator() = default;
+    map_iterator(leaf_type* leaf, std::size_t index, Leaf* const* last) :
+        m_leaf(leaf), m_index(index), m_last(last) { }
+
+    // iterator -> const_iterator
+    template <bool OtherConst, typename = typename std::enable_if<IsConst && !OtherConst>::type>
+    map_iterator(const map_iterator<Leaf, OtherConst>& other) :
+        m_leaf(other.leaf()), m_index(other.index()), m_last(other.lastSlot())
+    {
+    }
+
+    leaf_type*   leaf() const { return m_leaf; }
+    std::size_t  index() const { return m_index; }
+    Leaf* const* lastSlot() const { return m_last; }
+
+    reference operator*() const { return reference(m_leaf->keys[m_index], m_leaf->values[m_index]); }
+    pointer   operator->() const { return pointer{ **this }; }
+
+    map_iterator& operator++()
+    {
+        if (++m_index == m_leaf->count)
+        {
+            m_leaf  = m_leaf->next;
+            m_index = 0;
+        }
+        return *this;
+    }
+
+    map_iterator operator++(int)
+    {
+        map_iterator _tmp = *this;
+        ++*this;
+        return _tmp;
+    }
+
+    // from end() to the last key
+    map_iterator& operator--()
+    {
+        if (m_leaf == nullptr)
+        {
+            m_leaf  = *m_last;
+            m_index = m_leaf->count;
+        }
+        else if (m_index == 0)
+        {
+            m_leaf  = m_leaf->prev;
+            m_index = m_leaf->count;
+        }
+        m_index--;
+        return *this;
+    }
+
+    map_iterator operator--(int)
+    {
+        map_iterator _tmp = *this;
+        --*this;
+        return _tmp;
+    }
+
+    friend bool operator==(const map_iterator& a, const map_iterator& b)
+    {
+        return a.m_leaf == b.m_leaf && a.m_index == b.m_index;
+    }
+
+    friend bool operator!=(const map_iterator& a, const map_iterator& b)
+    {
+        return !(a == b);
+    }
+
+private:
+    leaf_type*   m_leaf  = nullptr;
+    std::size_t  m_index = 0;
+    Leaf* const* m_last  = nullptr;
+};
+
+// map ===========
+
+// an ordered map as an in-memory B+tree. nodes are NodeBytes wide and start on a cache
+// line, so a lookup takes a few misses per level where AVLTree takes one per key compared.
+// keys sit in their own array in every node: int32_t, float and double keys under the
+// default order are searched with the simd kernels, any other key by a branchless binary
+// search. all pairs live in the leaves, which are linked both ways, so a range scan walks
+// arrays instead of chasing parents.
+//
+// slots are plain arrays, so Key_t and Value_t must be default constructible and
+// move assignable. like a vector, an insert or erase invalidates every iterator
+template <typename Key_t, typename Value_t, typename Compare = std::less<Key_t>, std::size_t NodeBytes = 512>
+class map
+{
+    static_assert(std::is_default_constructible<Key_t>::value && std::is_default_constructible<Value_t>::value,
+                  "node slots are default constructed arrays");
+
+    struct node_base
+    {
+        std::uint16_t count = 0;
+    };
+
+    static constexpr std::size_t fit(std::size_t bytes, std::size_t per_slot)
+    {
+        return std::min<std::size_t>(std::max<std::size_t>(bytes / per_slot, 4), 1u << 15);
+    }
+
+public:
+    // as many slots as fit in NodeBytes, at least 4
+    static constexpr std::size_t leaf_capacity  = fit(NodeBytes - 3 * sizeof(void*), sizeof(Key_t) + sizeof(Value_t));
+    static constexpr std::size_t inner_capacity = fit(NodeBytes - 2 * sizeof(void*), sizeof(Key_t) + sizeof(void*));
+
+    struct alignas(64) leaf_node : node_base
+    {
+        using key_type    = Key_t;
+        using mapped_type = Value_t;
+
+        leaf_node* prev = nullptr;
+        leaf_node* next = nullptr;
+        Key_t      keys[leaf_capacity];
+        Value_t    values[leaf_capacity];
+    };
+
+    // child i holds the keys in (keys[i - 1], keys[i]], the last child the rest
+    struct alignas(64) inner_node : node_base
+    {
+        Key_t      keys[inner_capacity];
+        node_base* children[inner_capacity + 1];
+    };
+
+    using key_type       = Key_t;
+    using mapped_type    = Value_t;
+    using key_compare    = Compare;
+    using size_type      = std::size_t;
+    using iterator       = map_iterator<leaf_node>;
+    using const_iterator = map_iterator<leaf_node, true>;
+
+    map() = default;
+
+    explicit map(const Compare& comp) :
+        m_comp(comp)
+    {
+    }
+
+    ~map() { clear(); }
+
+    map(const map& other) :
+        m_comp(other.m_comp)
+    {
+        if (other.m_root != nullptr)
+        {
+            leaf_node* _last = nullptr;
+            m_root           = cloneNode(other.m_root, other.m_height, _last);
+            m_tail           = _last;
+            m_height         = other.m_height;
+            m_size           = other.m_size;
+        }
+    }
+
+    map& operator=(const map& other)
+    {
+        if (this != &other)
+        {
+            map _copy(other);
+            swap(_copy);
+        }
+        return *this;
+    }
+
+    map(map&& other) noexcept :
+        m_comp(other.m_comp)
+    {
+        swap(other);
+    }
+
+    map& operator=(map&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    void swap(map& other) noexcept
+    {
+        using std::swap;
+        swap(m_comp, other.m_comp);
+        swap(m_root, other.m_root);
+        swap(m_head, other.m_head);
+        swap(m_tail, other.m_tail);
+        swap(m_height, other.m_height);
+        swap(m_size, other.m_size);
+        swap(m_leaves, other.m_leaves);
+        swap(m_inners, other.m_inners);
+    }
+
+    void clear()
+    {
+        if (m_root != nullptr)
+        {
+            freeNode(m_root, m_height);
+        }
+        m_root   = nullptr;
+        m_head   = nullptr;
+        m_tail   = nullptr;
+        m_height = 0;
+        m_size   = 0;
+    }
+
+    size_type size() const { return m_size; }
+    bool      empty() const { return m_size == 0; }
+
+    const Compare& key_comp() const { return m_comp; }
+
+    // levels from the root to the leaves, 0 when empty
+    std::size_t depth() const { return m_root ? m_height + 1 : 0; }
+
+    // bytes owned by this map: the object plus every node
+    std::size_t memory_usage() const { return sizeof(*this) + m_leaves * sizeof(leaf_node) + m_inners * sizeof(inner_node); }
+
+    // insert ===========
+
+    // an existing key keeps its value
+    std::pair<iterator, bool> insert(const Key_t& key, const Value_t& value)
+    {
+        return try_emplace(key, value);
+    }
+
+    std::pair<iterator, bool> insert(Key_t&& key, Value_t&& value)
+    {
+        return try_emplace(std::move(key), std::move(value));
+    }
+
+    // the value is made from args only when key is absent
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key_t& key, Args&&... args)
+    {
+        return emplaceKey(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(Key_t&& key, Args&&... args)
+    {
+        return emplaceKey(std::move(key), std::forward<Args>(args)...);
+    }
+
+    Value_t& operator[](const Key_t& key)
+    {
+        return emplaceKey(key).first->second;
+    }
+
+    // lookup ===========
+
+    iterator find(const Key_t& key) { return findAs<iterator>(key); }
+
+    const_iterator find(const Key_t& key) const { return findAs<const_iterator>(key); }
+
+    bool contains(const Key_t& key) const { return find(key) != end(); }
+
+    // the first key not less than key
+    iterator lower_bound(const Key_t& key) { return lowerBoundAs<iterator>(key); }
+
+    const_iterator lower_bound(const Key_t& key) const { return lowerBoundAs<const_iterator>(key); }
+
+    // the first key greater than key
+    iterator upper_bound(const Key_t& key) { return upperBoundAs<iterator>(key); }
+
+    const_iterator upper_bound(const Key_t& key) const { return upperBoundAs<const_iterator>(key); }
+
+    std::pair<iterator, iterator> equal_range(const Key_t& key)
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const Key_t& key) const
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    // erase ===========
+
+    // returns how many were erased, 0 or 1
+    size_type erase(const Key_t& key)
+    {
+        if (m_root == nullptr)
+        {
+            return 0;
+        }
+
+        path        _path;
+        leaf_node*  _leaf  = descend(key, _path);
+        std::size_t _index = searchKeys(_leaf->keys, _leaf->count, key);
+        if (_index == _leaf->count || keyLess(key, _leaf->keys[_index]))
+        {
+            return 0;
+        }
+
+        removeSlot(_leaf, _index);
+        m_size--;
+        rebalanceLeaf(_leaf, _path);
+        return 1;
+    }
+
+    // returns the position after it
+    iterator erase(const_iterator pos)
+    {
+        Key_t _key = pos->first;
+        erase(_key);
+        return upper_bound(_key);
+    }
+
+    // iteration ===========
+
+    iterator       begin() { return m_head ? iterator(m_head, 0, &m_tail) : end(); }
+    iterator       end() { return iterator(nullptr, 0, &m_tail); }
+    const_iterator begin() const { return m_head ? const_iterator(m_head, 0, &m_tail) : end(); }
+    const_iterator end() const { return const_iterator(nullptr, 0, &m_tail); }
+
+private:
+    // the inner nodes a descent went through and the child taken in each. a node has at
+    // least two children, so 64 levels cover any size_t count
+    struct path
+    {
+        inner_node*   nodes[64];
+        std::uint16_t index[64];
+    };
+
+    template <typename A, typename B>
+    bool keyLess(const A& a, const B& b) const
+    {
+        return m_comp(a, b);
+    }
+
+    // the first of n sorted keys not less than key
+    std::size_t searchKeys(const Key_t* keys, std::size_t n, const Key_t& key) const
+    {
+        if constexpr (detail::simd_searchable<Key_t, Compare>::value)
+        {
+            return simd::lower_bound(keys, n, key);
+        }
+        else
+        {
+            // halves the range without a branch; ends on one slot left to look at
+            const Key_t* _base = keys;
+            while (n > 1)
+            {
+                std::size_t _half = n / 2;
+                _base             = keyLess(_base[_half - 1], key) ? _base + _half : _base;
+                n -= _half;
+            }
+            return std::size_t(_base - keys) + (n == 1 && keyLess(*_base, key));
+        }
+    }
+
+    leaf_node* findLeaf(const Key_t& key) const
+    {
+        node_base* _node = m_root;
+        for (std::size_t _level = 0; _level < m_height; _level++)
+        {
+            inner_node* _inner = static_cast<inner_node*>(_node);
+            _node              = _inner->children[searchKeys(_inner->keys, _inner->count, key)];
+        }
+        return static_cast<leaf_node*>(_node);
+    }
+
+    leaf_node* descend(const Key_t& key, path& path) const
+    {
+        node_base* _node = m_root;
+        for (std::size_t _level = 0; _level < m_height; _level++)
+        {
+            inner_node* _inner = static_cast<inner_node*>(_node);
+            std::size_t _child = searchKeys(_inner->keys, _inner->count, key);
+            path.nodes[_level] = _inner;
+            path.index[_level] = std::uint16_t(_child);
+            _node              = _inner->children[_child];
+        }
+        return static_cast<leaf_node*>(_node);
+    }
+
+    // a slot past the end of a leaf is the start of the next one
+    template <typename It>
+    It position(leaf_node* leaf, std::size_t index) const
+    {
+        if (index == leaf->count)
+        {
+            return It(leaf->next, 0, &m_tail);
+        }
+        return It(leaf, index, &m_tail);
+    }
+
+    // the lookups behind the iterator and const_iterator overloads; findLeaf only reads
+    template <typename It>
+    It findAs(const Key_t& key) const
+    {
+        leaf_node*  _leaf  = findLeaf(key);
+        std::size_t _index = _leaf ? searchKeys(_leaf->keys, _leaf->count, key) : 0;
+        return _leaf && _index < _leaf->count && !keyLess(key, _leaf->keys[_index]) ? It(_leaf, _index, &m_tail)
+                                                                                     : It(nullptr, 0, &m_tail);
+    }
+
+    template <typename It>
+    It lowerBoundAs(const Key_t& key) const
+    {
+        leaf_node* _leaf = findLeaf(key);
+        return _leaf ? position<It>(_leaf, searchKeys(_leaf->keys, _leaf->count, key)) : It(nullptr, 0, &m_tail);
+    }
+
+    template <typename It>
+    It upperBoundAs(const Key_t& key) const
+    {
+        leaf_node* _leaf = findLeaf(key);
+        if (_leaf == nullptr)
+        {
+            return It(nullptr, 0, &m_tail);
+        }
+        std::size_t _index = searchKeys(_leaf->keys, _leaf->count, key);
+        if (_index < _leaf->count && !keyLess(key, _leaf->keys[_index]))
+        {
+            _index++;
+        }
+        return position<It>(_leaf, _index);
+    }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplaceKey(K&& key, Args&&... args)
+    {
+        if (m_root == nullptr)
+        {
+            m_root = m_head = m_tail = newLeaf();
+        }
+
+        path        _path;
+        leaf_node*  _leaf  = descend(key, _path);
+        std::size_t _index = searchKeys(_leaf->keys, _leaf->count, key);
+        if (_index < _leaf->count && !keyLess(key, _leaf->keys[_index]))
+        {
+            return { iterator(_leaf, _index, &m_tail), false };
+        }
+
+        // built before anything moves, so a throwing constructor leaves the map as it was
+        Key_t   _key(std::forward<K>(key));
+        Value_t _value(std::forward<Args>(args)...);
+
+        if (_leaf->count == leaf_capacity)
+        {
+            // appends past the last key leave the full leaf as it is and start a new one,
+            // so ascending loads fill every node
+            bool       _append = _leaf == m_tail && _index == leaf_capacity;
+            leaf_node* _right  = splitLeaf(_leaf, _append ? leaf_capacity : leaf_capacity / 2);
+            insertSeparator(_path, _leaf->keys[_leaf->count - 1], _right);
+
+            // the left half keeps the keys up to its last one
+            if (_index >= _leaf->count)
+            {
+                _index -= _leaf->count;
+                _leaf = _right;
+            }
+        }
+
+        std::move_backward(_leaf->keys + _index, _leaf->keys + _leaf->count, _leaf->keys + _leaf->count + 1);
+        std::move_backward(_leaf->values + _index, _leaf->values + _leaf->count, _leaf->values + _leaf->count + 1);
+        _leaf->keys[_index]   = std::move(_key);
+        _leaf->values[_index] = std::move(_value);
+        _leaf->count++;
+        m_size++;
+        return { iterator(_leaf, _index, &m_tail), true };
+    }
+
+    // moves the slots from keep on into a new leaf linked after this one
+    leaf_node* splitLeaf(leaf_node* leaf, std::size_t keep)
+    {
+        leaf_node*  _right = newLeaf();
+        std::size_t _keep  = keep;
+
+        std::move(leaf->keys + _keep, leaf->keys + leaf_capacity, _right->keys);
+        std::move(leaf->values + _keep, leaf->values + leaf_capacity, _right->values);
+        _right->count = std::uint16_t(leaf_capacity - _keep);
+        leaf->count   = std::uint16_t(_keep);
+
+        _right->prev = leaf;
+        _right->next = leaf->next;
+        if (leaf->next != nullptr)
+        {
+            leaf->next->prev = _right;
+        }
+        else
+        {
+            m_tail = _right;
+        }
+        leaf->next = _right;
+        return _right;
+    }
+
+    // right_child goes after the child the path took at the bottom inner level, with
+    // separator between them; full nodes split on the way up, a full root adds a level
+    void insertSeparator(path& path, Key_t separator, node_base* right_child)
+    {
+        // the nodes down the right edge, where appends split off a nearly empty node
+        std::size_t _right_edge = 0;
+        while (_right_edge < m_height && path.index[_right_edge] == path.nodes[_right_edge]->count)
+        {
+            _right_edge++;
+        }
+
+        for (std::size_t _level = m_height; _level-- > 0;)
+        {
+            inner_node* _node = path.nodes[_level];
+            std::size_t _at   = path.index[_level];
+            if (_node->count < inner_capacity)
+            {
+                insertEntry(_node, _at, std::move(separator), right_child);
+                return;
+            }
+
+            // keys left of the middle stay, the middle goes up, the rest move right
+            bool        _append = _level < _right_edge && _at == inner_capacity;
+            inner_node* _right  = newInner();
+            std::size_t _mid    = _append ? inner_capacity - 1 : inner_capacity / 2;
+            std::move(_node->keys + _mid + 1, _node->keys + inner_capacity, _right->keys);
+            std::copy(_node->children + _mid + 1, _node->children + inner_capacity + 1, _right->children);
+            _right->count = std::uint16_t(inner_capacity - _mid - 1);
+            _node->count  = std::uint16_t(_mid);
+            Key_t _up     = std::move(_node->keys[_mid]);
+
+            if (_at <= _mid)
+            {
+                insertEntry(_node, _at, std::move(separator), right_child);
+            }
+            else
+            {
+                insertEntry(_right, _at - _mid - 1, std::move(separator), right_child);
+            }
+
+            separator   = std::move(_up);
+            right_child = _right;
+        }
+
+        inner_node* _root  = newInner();
+        _root->count       = 1;
+        _root->keys[0]     = std::move(separator);
+        _root->children[0] = m_root;
+        _root->children[1] = right_child;
+        m_root             = _root;
+        m_height++;
+    }
+
+    // key at slot at, child right after it
+    static void insertEntry(inner_node* node, std::size_t at, Key_t&& key, node_base* child)
+    {
+        std::move_backward(node->keys + at, node->keys + node->count, node->keys + node->count + 1);
+        std::copy_backward(node->children + at + 1, node->children + node->count + 1, node->children + node->count + 2);
+        node->keys[at]         = std::move(key);
+        node->children[at + 1] = child;
+        node->count++;
+    }
+
+    // drops key at and the child after it
+    static void removeEntry(inner_node* node, std::size_t at)
+    {
+        std::move(node->keys + at + 1, node->keys + node->count, node->keys + at);
+        std::copy(node->children + at + 2, node->children + node->count + 1, node->children + at + 1);
+        node->count--;
+        node->keys[node->count] = Key_t();
+    }
+
+    static void removeSlot(leaf_node* leaf, std::size_t index)
+    {
+        std::move(leaf->keys + index + 1, leaf->keys + leaf->count, leaf->keys + index);
+        std::move(leaf->values + index + 1, leaf->values + leaf->count, leaf->values + index);
+        leaf->count--;
+        leaf->keys[leaf->count]   = Key_t();
+        leaf->values[leaf->count] = Value_t();
+    }
+
+    // erase ===========
+
+    // a leaf below half full borrows from a sibling with some to spare, else merges
+    // with it; the parent loses an entry then and may need the same
+    void rebalanceLeaf(leaf_node* leaf, path& path)
+    {
+        constexpr std::size_t _min = leaf_capacity / 2;
+
+        if (m_height == 0)
+        {
+            if (leaf->count == 0)
+            {
+                freeLeaf(leaf);
+                m_root = m_head = m_tail = nullptr;
+            }
+            return;
+        }
+        if (leaf->count >= _min)
+        {
+            return;
+        }
+
+        inner_node* _parent = path.nodes[m_height - 1];
+        std::size_t _at     = path.index[m_height - 1];
+        leaf_node*  _left   = _at > 0 ? static_cast<leaf_node*>(_parent->children[_at - 1]) : nullptr;
+        leaf_node*  _right  = _at < _parent->count ? static_cast<leaf_node*>(_parent->children[_at + 1]) : nullptr;
+
+        if (_left != nullptr && _left->count > _min)
+        {
+            std::move_backward(leaf->keys, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+            std::move_backward(leaf->values, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+            leaf->keys[0]   = std::move(_left->keys[_left->count - 1]);
+            leaf->values[0] = std::move(_left->values[_left->count - 1]);
+            leaf->count++;
+            removeSlot(_left, _left->count - 1);
+            _parent->keys[_at - 1] = _left->keys[_left->count - 1];
+            return;
+        }
+        if (_right != nullptr && _right->count > _min)
+        {
+            leaf->keys[leaf->count]   = std::move(_right->keys[0]);
+            leaf->values[leaf->count] = std::move(_right->values[0]);
+            leaf->count++;
+            removeSlot(_right, 0);
+            _parent->keys[_at] = leaf->keys[leaf->count - 1];
+            return;
+        }
+
+        if (_left != nullptr)
+        {
+            mergeLeaves(_left, leaf);
+            removeEntry(_parent, _at - 1);
+        }
+        else
+        {
+            mergeLeaves(leaf, _right);
+            removeEntry(_parent, _at);
+        }
+        rebalanceInner(path, m_height - 1);
+    }
+
+    // right joins left and goes away
+    void mergeLeaves(leaf_node* left, leaf_node* right)
+    {
+        std::move(right->keys, right->keys + right->count, left->keys + left->count);
+        std::move(right->values, right->values + right->count, left->values + left->count);
+        left->count = std::uint16_t(left->count + right->count);
+
+        left->next = right->next;
+        if (right->next != nullptr)
+        {
+            right->next->prev = left;
+        }
+        else
+        {
+            m_tail = left;
+        }
+        freeLeaf(right);
+    }
+
+    void rebalanceInner(path& path, std::size_t level)
+    {
+        constexpr std::size_t _min = (inner_capacity - 1) / 2;
+
+        for (;; level--)
+        {
+            inner_node* _node = path.nodes[level];
+            if (level == 0)
+            {
+                // a root left with one child hands the root to it
+                if (_node->count == 0)
+                {
+                    m_root = _node->children[0];
+                    freeInner(_node);
+                    m_height--;
+                }
+                return;
+            }
+            if (_node->count >= _min)
+            {
+                return;
+            }
+
+            inner_node* _parent = path.nodes[level - 1];
+            std::size_t _at     = path.index[level - 1];
+            inner_node* _left   = _at > 0 ? static_cast<inner_node*>(_parent->children[_at - 1]) : nullptr;
+            inner_node* _right  = _at < _parent->count ? static_cast<inner_node*>(_parent->children[_at + 1]) : nullptr;
+
+            // a borrow rotates through the parent's separator
+            if (_left != nullptr && _left->count > _min)
+            {
+                std::move_backward(_node->keys, _node->keys + _node->count, _node->keys + _node->count + 1);
+                std::copy_backward(_node->children, _node->children + _node->count + 1, _node->children + _node->count + 2);
+                _node->keys[0]         = std::move(_parent->keys[_at - 1]);
+                _node->children[0]     = _left->children[_left->count];
+                _parent->keys[_at - 1] = std::move(_left->keys[_left->count - 1]);
+                _node->count++;
+                _left->count--;
+                return;
+            }
+            if (_right != nullptr && _right->count > _min)
+            {
+                _node->keys[_node->count]         = std::move(_parent->keys[_at]);
+                _node->children[_node->count + 1] = _right->children[0];
+                _parent->keys[_at]                = std::move(_right->keys[0]);
+                std::move(_right->keys + 1, _right->keys + _right->count, _right->keys);
+                std::copy(_right->children + 1, _right->children + _right->count + 1, _right->children);
+                _node->count++;
+                _right->count--;
+                return;
+            }
+
+            // a merge pulls the separator down between the two
+            std::size_t _sep   = _left ? _at - 1 : _at;
+            inner_node* _into  = _left ? _left : _node;
+            inner_node* _from  = _left ? _node : _right;
+            std::size_t _count = _into->count;
+
+            _into->keys[_count] = std::move(_parent->keys[_sep]);
+            std::move(_from->keys, _from->keys + _from->count, _into->keys + _count + 1);
+            std::copy(_from->children, _from->children + _from->count + 1, _into->children + _count + 1);
+            _into->count = std::uint16_t(_count + 1 + _from->count);
+            freeInner(_from);
+            removeEntry(_parent, _sep);
+        }
+    }
+
+    // nodes ===========
+
+    leaf_node* newLeaf()
+    {
+        leaf_node* _leaf = new leaf_node;
+        m_leaves++;
+        return _leaf;
+    }
+
+    inner_node* newInner()
+    {
+        inner_node* _inner = new inner_node;
+        m_inners++;
+        return _inner;
+    }
+
+    void freeLeaf(leaf_node* leaf)
+    {
+        delete leaf;
+        m_leaves--;
+    }
+
+    void freeInner(inner_node* inner)
+    {
+        delete inner;
+        m_inners--;
+    }
+
+    void freeNode(node_base* node, std::size_t height)
+    {
+        if (height == 0)
+        {
+            freeLeaf(static_cast<leaf_node*>(node));
+            return;
+        }
+        inner_node* _inner = static_cast<inner_node*>(node);
+        for (std::size_t i = 0; i <= _inner->count; i++)
+        {
+            freeNode(_inner->children[i], height - 1);
+        }
+        freeInner(_inner);
+    }
+
+    // copies the subtree, linking its leaves after last in key order
+    node_base* cloneNode(const node_base* node, std::size_t height, leaf_node*& last)
+    {
+        if (height == 0)
+        {
+            const leaf_node* _leaf = static_cast<const leaf_node*>(node);
+            leaf_node*       _copy = newLeaf();
+            std::copy(_leaf->keys, _leaf->keys + _leaf->count, _copy->keys);
+            std::copy(_leaf->values, _leaf->values + _leaf->count, _copy->values);
+            _copy->count = _leaf->count;
+            _copy->prev  = last;
+            (last ? last->next : m_head) = _copy;
+            last                         = _copy;
+            return _copy;
+        }
+
+        const inner_node* _inner = static_cast<const inner_node*>(node);
+        inner_node*       _copy  = newInner();
+        std::copy(_inner->keys, _inner->keys + _inner->count, _copy->keys);
+        _copy->count = _inner->count;
+        for (std::size_t i = 0; i <= _inner->count; i++)
+        {
+            _copy->children[i] = cloneNode(_inner->children[i], height - 1, last);
+        }
+        return _copy;
+    }
+
+    Compare     m_comp   = Compare();
+    node_base*  m_root   = nullptr;
+    leaf_node*  m_head   = nullptr;
+    leaf_node*  m_tail   = nullptr;
+    std::size_t m_height = 0; // inner levels above the leaves
+    std::size_t m_size   = 0;
+    std::size_t m_leaves = 0;
+    std::size_t m_inners = 0;
+};
+
+} // namespace m_std
@@ -0,0 +1,524 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if defined(_WIN32)
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace m_std
+{
+
+enum class mapped_open
+{
+    open_or_create, // reopen what is there, or start an empty file
+    open_existing,  // throw if the file is missing
+    truncate        // always start empty
+};
+
+// the first bytes of every mapped_vector file. the elements follow at data_offset, so
+// reopening is mmap + a few header checks: nothing is read or converted up front, pages
+// fault in as they are touched. the bytes are the host's, the file is not portable
+// across endianness or ABI.
+struct mapped_vector_header
+{
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::size_t   data_offset     = 64;
+
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint64_t element_size;
+    std::uint64_t element_align;
+    std::uint64_t size;
+    std::uint64_t capacity;
+
+    static constexpr char expected_magic[8] = { 'm', '_', 's', 't', 'd', 'v', 'e', 'c' };
+};
+
+static_assert(sizeof(mapped_vector_header) <= mapped_vector_header::data_offset, "header must fit before the data");
+
+// m_std::vector whose buffer is a file. trivially copyable T only, since the bytes are
+// the storage. growth extends the file with ftruncate and remaps it (mremap on linux),
+// so element addresses change on growth just like vector's. flush() forces the pages
+// to disk; without it the kernel writes them back on its own schedule, and they
+// survive a crash of this process but not of the machine.
+template <typename T>
+class mapped_vector
+{
+    static_assert(std::is_trivially_copyable<T>::value, "mapped_vector stores the raw bytes of its elements");
+    static_assert(alignof(T) <= mapped_vector_header::data_offset, "element alignment exceeds the data offset");
+
+public:
+    using value_type = T;
+    using iterator   = T*;
+    using size_t     = std::size_t;
+
+    explicit mapped_vector(const std::string& path, mapped_open mode = mapped_open::open_or_create) :
+        m_path(path)
+    {
+        open_file(mode);
+        try
+        {
+            size_t _file_bytes = file_size();
+            if (_file_bytes == 0)
+            {
+                resize_file(header_bytes);
+                map(header_bytes);
+                init_header();
+            }
+            else
+            {
+                if (_file_bytes < header_bytes)
+                {
+                    throw std::runtime_error("mapped_vector: " + m_path + " is too short for a header");
+                }
+                map(_file_bytes);
+                check_header(_file_bytes);
+            }
+        }
+        catch (...)
+        {
+            unmap();
+            close_file();
+            throw;
+        }
+    }
+
+    mapped_vector(const mapped_vector&)            = delete;
+    mapped_vector& operator=(const mapped_vector&) = delete;
+
+    mapped_vector(mapped_vector&& other) noexcept
+    {
+        steal(other);
+    }
+
+    mapped_vector& operator=(mapped_vector&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            close_file();
+            steal(other);
+        }
+        return *this;
+    }
+
+    // unmapping hands the dirty pages to the kernel, nothing is lost by not flushing
+    ~mapped_vector()
+    {
+        unmap();
+        close_file();
+    }
+
+    iterator begin() { return m_data; }
+    iterator end() { return m_data + size(); }
+
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + size(); }
+
+    size_t size() const { return size_t(m_header->size); }
+    size_t capacity() const { return size_t(m_header->capacity); }
+    bool   empty() const { return size() == 0; }
+
+    T*       data() { return m_data; }
+    const T* data() const { return m_data; }
+
+    const std::string& path() const { return m_path; }
+
+    T& operator[](size_t index)
+    {
+        if (index >= size())
+        {
+            throw std::out_of_range("index out of range");
+        }
+        return m_data[index];
+    }
+
+    const T& operator[](size_t index) const
+    {
+        if (index >= size())
+        {
+            throw std::out_of_range("index out of range");
+        }
+        return m_data[index];
+    }
+
+    void reserve(size_t new_capacity)
+    {
+        if (new_capacity > capacity())
+        {
+            remap_capacity(new_capacity);
+        }
+    }
+
+    // shrinks the file to the elements in use
+    void shrink_to_fit()
+    {
+        if (size() < capacity())
+        {
+            remap_capacity(size());
+        }
+    }
+
+    void resize(size_t new_size, const T& value = T())
+    {
+        reserve(new_size);
+        for (size_t i = size(); i < new_size; i++)
+        {
+            m_data[i] = value;
+        }
+        m_header->size = new_size;
+    }
+
+    void clear() { m_header->size = 0; }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        T* _slot;
+        if (size() == capacity())
+        {
+            T _value(std::forward<Args>(args)...); // args may point into the mapping
+            remap_capacity(grown_capacity());
+            _slot = ::new (m_data + size()) T(_value);
+        }
+        else
+        {
+            _slot = ::new (m_data + size()) T(std::forward<Args>(args)...);
+        }
+        m_header->size++;
+        return *_slot;
+    }
+
+    void pop_back()
+    {
+        if (empty())
+        {
+            throw std::out_of_range("pop_back() on empty mapped_vector");
+        }
+        m_header->size--;
+    }
+
+    // blocks until header and elements are on disk
+    void flush()
+    {
+#if defined(_WIN32)
+        if (!::FlushViewOfFile(m_map, 0) || !::FlushFileBuffers(m_file))
+        {
+            throw_last_error("flush");
+        }
+#else
+        if (::msync(m_map, m_mapped_bytes, MS_SYNC) != 0)
+        {
+            throw_last_error("flush");
+        }
+#endif
+    }
+
+private:
+    static constexpr size_t header_bytes = mapped_vector_header::data_offset;
+
+    static size_t bytes_for(size_t capacity) { return header_bytes + capacity * sizeof(T); }
+
+    // the first growth fills the rest of the page the header sits in, then doubling
+    size_t grown_capacity() const
+    {
+        if (capacity() == 0)
+        {
+            size_t _first = (4096 - header_bytes) / sizeof(T);
+            return _first == 0 ? 1 : _first;
+        }
+        return capacity() * 2;
+    }
+
+    void init_header()
+    {
+        std::memcpy(m_header->magic, mapped_vector_header::expected_magic, sizeof(m_header->magic));
+        m_header->version       = mapped_vector_header::current_version;
+        m_header->header_size   = std::uint32_t(header_bytes);
+        m_header->element_size  = sizeof(T);
+        m_header->element_align = alignof(T);
+        m_header->size          = 0;
+        m_header->capacity      = 0;
+    }
+
+    void check_header(size_t file_bytes) const
+    {
+        if (std::memcmp(m_header->magic, mapped_vector_header::expected_magic, sizeof(m_header->magic)) != 0)
+        {
+            throw std::runtime_error("mapped_vector: " + m_path + " is not a mapped_vector file");
+        }
+        if (m_header->version != mapped_vector_header::current_version || m_header->header_size != header_bytes)
+        {
+            throw std::runtime_error("mapped_vector: " + m_path + " has an unsupported version");
+        }
+        if (m_header->element_size != sizeof(T) || m_header->element_align != alignof(T))
+        {
+            throw std::runtime_error("mapped_vector: " + m_path + " holds a different element type");
+        }
+        if (m_header->size > m_header->capacity || bytes_for(size_t(m_header->capacity)) > file_bytes)
+        {
+            throw std::runtime_error("mapped_vector: " + m_path + " is truncated");
+        }
+    }
+
+    void remap_capacity(size_t new_capacity)
+    {
+        size_t _bytes = bytes_for(new_capacity);
+        remap(_bytes);
+        m_header->capacity = new_capacity;
+    }
+
+    void steal(mapped_vector& other) noexcept
+    {
+        m_path         = std::move(other.m_path);
+        m_map          = other.m_map;
+        m_mapped_bytes = other.m_mapped_bytes;
+        m_header       = other.m_header;
+        m_data         = other.m_data;
+#if defined(_WIN32)
+        m_file          = other.m_file;
+        m_mapping       = other.m_mapping;
+        other.m_file    = INVALID_HANDLE_VALUE;
+        other.m_mapping = nullptr;
+#else
+        m_fd       = other.m_fd;
+        other.m_fd = -1;
+#endif
+        other.m_map          = nullptr;
+        other.m_mapped_bytes = 0;
+        other.m_header       = nullptr;
+        other.m_data         = nullptr;
+    }
+
+    void set_view(void* map, size_t bytes)
+    {
+        m_map          = map;
+        m_mapped_bytes = bytes;
+        m_header       = static_cast<mapped_vector_header*>(map);
+        m_data         = reinterpret_cast<T*>(static_cast<unsigned char*>(map) + header_bytes);
+    }
+
+    [[noreturn]] void throw_last_error(const char* what) const
+    {
+#if defined(_WIN32)
+        int _code = int(::GetLastError());
+        throw std::system_error(_code, std::system_category(), "mapped_vector: " + std::string(what) + " " + m_path);
+#else
+        throw std::system_error(errno, std::generic_category(), "mapped_vector: " + std::string(what) + " " + m_path);
+#endif
+    }
+
+    // platform ===========
+
+#if defined(_WIN32)
+    void open_file(mapped_open mode)
+    {
+        DWORD _disposition = mode == mapped_open::open_existing ? OPEN_EXISTING
+                           : mode == mapped_open::truncate      ? CREATE_ALWAYS
+                                                                : OPEN_ALWAYS;
+        m_file = ::CreateFileA(m_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, _disposition,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            throw_last_error("open");
+        }
+    }
+
+    size_t file_size() const
+    {
+        LARGE_INTEGER _size;
+        if (!::GetFileSizeEx(m_file, &_size))
+        {
+            throw_last_error("stat");
+        }
+        return size_t(_size.QuadPart);
+    }
+
+    void resize_file(size_t bytes)
+    {
+        LARGE_INTEGER _size;
+        _size.QuadPart = LONGLONG(bytes);
+        if (!::SetFilePointerEx(m_file, _size, nullptr, FILE_BEGIN) || !::SetEndOfFile(m_file))
+        {
+            throw_last_error("resize");
+        }
+    }
+
+    void map(size_t bytes)
+    {
+        m_mapping = ::CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, DWORD(std::uint64_t(bytes) >> 32), DWORD(bytes), nullptr);
+        if (m_mapping == nullptr)
+        {
+            throw_last_error("map");
+        }
+        void* _p = ::MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+        if (_p == nullptr)
+        {
+            throw_last_error("map");
+        }
+        set_view(_p, bytes);
+    }
+
+    void unmap()
+    {
+        if (m_map != nullptr)
+        {
+            ::UnmapViewOfFile(m_map);
+            m_map = nullptr;
+        }
+        if (m_mapping != nullptr)
+        {
+            ::CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+    }
+
+    // a view can't grow in place: drop it, resize the file, map again
+    void remap(size_t bytes)
+    {
+        unmap();
+        resize_file(bytes);
+        map(bytes);
+    }
+
+    void close_file()
+    {
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+    }
+#else
+    void open_file(mapped_open mode)
+    {
+        int _flags = O_RDWR;
+        if (mode == mapped_open::open_or_create)
+        {
+            _flags |= O_CREAT;
+        }
+        else if (mode == mapped_open::truncate)
+        {
+            _flags |= O_CREAT | O_TRUNC;
+        }
+
+        m_fd = ::open(m_path.c_str(), _flags, 0644);
+        if (m_fd < 0)
+        {
+            throw_last_error("open");
+        }
+    }
+
+    size_t file_size() const
+    {
+        struct stat _stat {};
+        if (::fstat(m_fd, &_stat) != 0)
+        {
+            throw_last_error("stat");
+        }
+        return size_t(_stat.st_size);
+    }
+
+    void resize_file(size_t bytes)
+    {
+        if (::ftruncate(m_fd, off_t(bytes)) != 0)
+        {
+            throw_last_error("resize");
+        }
+    }
+
+    void map(size_t bytes)
+    {
+        void* _p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (_p == MAP_FAILED)
+        {
+            throw_last_error("map");
+        }
+        set_view(_p, bytes);
+    }
+
+    void unmap()
+    {
+        if (m_map != nullptr)
+        {
+            ::munmap(m_map, m_mapped_bytes);
+            m_map = nullptr;
+        }
+    }
+
+    void remap(size_t bytes)
+    {
+        size_t _old_bytes = m_mapped_bytes;
+
+        // grow the file before the mapping can reach past its end
+        if (bytes > _old_bytes)
+        {
+            resize_file(bytes);
+        }
+#    if defined(__linux__)
+        void* _p = ::mremap(m_map, _old_bytes, bytes, MREMAP_MAYMOVE);
+        if (_p == MAP_FAILED)
+        {
+            throw_last_error("remap");
+        }
+        set_view(_p, bytes);
+#    else
+        unmap();
+        map(bytes);
+#    endif
+        if (bytes < _old_bytes)
+        {
+            resize_file(bytes);
+        }
+    }
+
+    void close_file()
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+#endif
+
+private:
+    std::string           m_path;
+    void*                 m_map          = nullptr;
+    size_t                m_mapped_bytes = 0;
+    mapped_vector_header* m_header       = nullptr;
+    T*                    m_data         = nullptr;
+
+#if defined(_WIN32)
+    HANDLE m_file    = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace m_std
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace m_std
+{
+
+// a type is trivially relocatable if moving it to a new address and dropping the
+// old object is the same as copying its bytes. true for trivially copyable types;
+// specialize it for types like owning handles that are safe to memcpy around.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T>
+{
+};
+
+// allocators may offer `T* reallocate(T* p, size_t old_n, size_t new_n)` that grows
+// or shrinks a block in place when it can (realloc, mremap, arena tail extension)
+template <typename Alloc, typename = void>
+struct has_reallocate : std::false_type
+{
+};
+
+template <typename Alloc>
+struct has_reallocate<Alloc,
+                      decltype((void)std::declval<Alloc&>().reallocate(
+                          std::declval<typename Alloc::value_type*>(), std::size_t(), std::size_t()))>
+    : std::true_type
+{
+};
+
+template <typename T>
+void destroy_n(T* first, std::size_t n) noexcept
+{
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        for (std::size_t i = 0; i < n; i++)
+        {
+            first[i].~T();
+        }
+    }
+}
+
+// copy-construct n elements into raw memory; on a throw, the already built ones are destroyed
+template <typename T>
+void uninitialized_copy_n(const T* src, std::size_t n, T* dest)
+{
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        if (n != 0)
+        {
+            std::memcpy(static_cast<void*>(dest), static_cast<const void*>(src), sizeof(T) * n);
+        }
+    }
+    else
+    {
+        std::size_t i = 0;
+        try
+        {
+            for (; i < n; i++)
+            {
+                ::new (dest + i) T(src[i]);
+            }
+        }
+        catch (...)
+        {
+            destroy_n(dest, i);
+            throw;
+        }
+    }
+}
+
+// move-construct n elements into raw memory, move_if_noexcept so that a throw leaves src
+// as it was; on a throw, the already built ones are destroyed. the sources stay alive
+template <typename T>
+void uninitialized_move_if_noexcept_n(T* src, std::size_t n, T* dest)
+{
+    std::size_t i = 0;
+    try
+    {
+        for (; i < n; i++)
+        {
+            ::new (dest + i) T(std::move_if_noexcept(src[i]));
+        }
+    }
+    catch (...)
+    {
+        destroy_n(dest, i);
+        throw;
+    }
+}
+
+// move n elements from src into raw memory at dest and end the lifetime of the sources.
+// bytes are copied when T is trivially relocatable, otherwise move_if_noexcept keeps the
+// strong guarantee: if a copy throws, dest is cleaned up and src is left untouched.
+template <typename T>
+void relocate_n(T* src, std::size_t n, T* dest)
+{
+    if constexpr (is_trivially_relocatable<T>::value)
+    {
+        if (n != 0)
+        {
+            std::memcpy(static_cast<void*>(dest), static_cast<const void*>(src), sizeof(T) * n);
+        }
+    }
+    else
+    {
+        uninitialized_move_if_noexcept_n(src, n, dest);
+        destroy_n(src, n);
+    }
+}
+
+} // namespace m_std
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#if defined(_WIN32)
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+#include "m_vector.hpp"
+
+namespace m_std
+{
+
+// allocator for very large buffers of trivially copyable T. memory comes straight
+// from anonymous page mappings, asks for transparent huge pages, and on Linux grows
+// with mremap: the kernel moves page table entries instead of copying the data, so
+// growth costs O(1) in the element count and never needs old + new buffers resident.
+// every allocation is rounded up to whole pages, so don't use it for small vectors.
+template <typename T>
+class mmap_allocator
+{
+    static_assert(std::is_trivially_copyable<T>::value, "mmap_allocator relocates elements by remapping their bytes");
+
+public:
+    using value_type = T;
+
+    // below this we don't bother asking for huge pages
+    static constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+    mmap_allocator() = default;
+    template <typename U>
+    mmap_allocator(const mmap_allocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        std::size_t _bytes = mapped_bytes(n);
+#if defined(_WIN32)
+        void* _p = ::VirtualAlloc(nullptr, _bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (_p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+#else
+        void* _p = ::mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (_p == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        advise_huge_pages(_p, _bytes);
+#endif
+        return static_cast<T*>(_p);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+#if defined(_WIN32)
+        (void)n;
+        ::VirtualFree(p, 0, MEM_RELEASE);
+#else
+        ::munmap(p, mapped_bytes(n));
+#endif
+    }
+
+    T* reallocate(T* p, std::size_t old_n, std::size_t new_n)
+    {
+        std::size_t _old_bytes = mapped_bytes(old_n);
+        std::size_t _new_bytes = mapped_bytes(new_n);
+        if (_old_bytes == _new_bytes)
+        {
+            return p;
+        }
+
+#if defined(__linux__)
+        void* _p = ::mremap(p, _old_bytes, _new_bytes, MREMAP_MAYMOVE);
+        if (_p == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        advise_huge_pages(_p, _new_bytes);
+        return static_cast<T*>(_p);
+#else
+        // no remap primitive: map, copy, unmap
+        T* _p = allocate(new_n);
+        std::memcpy(static_cast<void*>(_p), static_cast<const void*>(p), (_old_bytes < _new_bytes ? _old_bytes : _new_bytes));
+        deallocate(p, old_n);
+        return _p;
+#endif
+    }
+
+    friend bool operator==(const mmap_allocator&, const mmap_allocator&) { return true; }
+    friend bool operator!=(const mmap_allocator&, const mmap_allocator&) { return false; }
+
+private:
+    static std::size_t page_size()
+    {
+#if defined(_WIN32)
+        static const std::size_t _size = [] {
+            SYSTEM_INFO _info;
+            ::GetSystemInfo(&_info);
+            return std::size_t(_info.dwAllocationGranularity);
+        }();
+#else
+        static const std::size_t _size = std::size_t(::sysconf(_SC_PAGESIZE));
+#endif
+        return _size;
+    }
+
+    static std::size_t mapped_bytes(std::size_t n)
+    {
+        std::size_t _page = page_size();
+        return (sizeof(T) * n + _page - 1) / _page * _page;
+    }
+
+#if !defined(_WIN32)
+    static void advise_huge_pages(void* p, std::size_t bytes)
+    {
+#    if defined(MADV_HUGEPAGE)
+        if (bytes >= huge_page_size)
+        {
+            ::madvise(p, bytes, MADV_HUGEPAGE); // only a hint, failure is fine
+        }
+#    else
+        (void)p;
+        (void)bytes;
+#    endif
+    }
+#endif
+};
+
+// opt-in storage mode for multi-GB vectors of plain data
+template <typename T>
+using huge_vector = vector<T, mmap_allocator<T>>;
+
+} // namespace m_std
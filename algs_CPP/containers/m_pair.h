@@ -1,5 +1,6 @@
 #pragma once
 
+#include <type_traits>
 #include <utility>
 
 namespace m_std
@@ -13,9 +14,16 @@ struct pair
     pair() = default;
 
     // forwarding constructor
-    template <typename Key_t, typename Value_t>
-    pair(Key_t&& k, Value_t&& v) :
-        first(std::forward<Key_t>(k)), second(std::forward<Value_t>(v))
+    template <typename K, typename V, typename = typename std::enable_if<!std::is_same<typename std::decay<K>::type, std::piecewise_construct_t>::value>::type>
+    pair(K&& k, V&& v) :
+        first(std::forward<K>(k)), second(std::forward<V>(v))
+    {
+    }
+
+    // the key, then the arguments second is built from in place
+    template <typename K, typename... Args>
+    pair(std::piecewise_construct_t, K&& k, Args&&... args) :
+        first(std::forward<K>(k)), second(std::forward<Args>(args)...)
     {
     }
 
@@ -29,4 +37,21 @@ struct pair
     Key_t   first;
     Value_t second;
 };
+
+namespace detail
+{
+
+// a comparator, hasher or key equality marked is_transparent takes any key type it can
+// compare, so the associative containers can look up without building a Key_t
+template <typename T, typename = void>
+struct is_transparent : std::false_type
+{
+};
+
+template <typename T>
+struct is_transparent<T, std::void_t<typename T::is_transparent>> : std::true_type
+{
+};
+
+} // namespace detail
 } // namespace m_std
\ No newline at end of file
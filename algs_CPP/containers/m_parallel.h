@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "m_vector.hpp"
+
+// parallel versions of the bulk loops, over raw T* ranges (m_std::vector iterators).
+// each runs on a ThreadPool (the shared one unless given), cuts the range into about
+// eight chunks per thread so stealing can even out uneven chunks, and stays serial when
+// the range is small or the pool has a single thread.
+namespace m_std
+{
+namespace parallel
+{
+
+// below this many elements, waking threads costs more than it saves
+constexpr std::size_t serial_cutoff = std::size_t(1) << 14;
+
+// smallest chunk handed to a task
+constexpr std::size_t min_grain = std::size_t(1) << 11;
+
+namespace detail
+{
+
+inline bool run_serial(const ThreadPool& pool, std::size_t n)
+{
+    return n < serial_cutoff || pool.threadCount() == 1;
+}
+
+inline std::size_t grain_size(const ThreadPool& pool, std::size_t n)
+{
+    return std::max(min_grain, n / (pool.threadCount() * 8));
+}
+
+// body(begin, end) over [begin, end), halving the range until it fits in a grain;
+// every right half becomes a task the other workers can steal
+template <typename Body>
+void split(TaskGroup& group, std::size_t begin, std::size_t end, std::size_t grain, const Body& body)
+{
+    while (end - begin > grain)
+    {
+        std::size_t _mid = begin + (end - begin) / 2;
+        group.run([&group, _mid, end, grain, &body] { split(group, _mid, end, grain, body); });
+        end = _mid;
+    }
+    body(begin, end);
+}
+
+template <typename Body>
+void parallel_for(ThreadPool& pool, std::size_t n, std::size_t grain, const Body& body)
+{
+    TaskGroup _group(pool);
+    split(_group, 0, n, grain, body);
+    _group.wait();
+}
+
+// chunk c is [c * grain, min(n, (c + 1) * grain))
+inline std::size_t chunk_count(std::size_t n, std::size_t grain)
+{
+    return (n + grain - 1) / grain;
+}
+
+// out = merge of the sorted runs a and b, moved. the bigger run is cut at its middle,
+// the other at the matching bound, and the two halves merge independently
+template <typename T, typename Compare>
+void merge(ThreadPool& pool, T* a, std::size_t na, T* b, std::size_t nb, T* out, Compare& comp)
+{
+    if (na + nb <= serial_cutoff)
+    {
+        std::merge(std::make_move_iterator(a), std::make_move_iterator(a + na), std::make_move_iterator(b),
+                   std::make_move_iterator(b + nb), out, comp);
+        return;
+    }
+
+    std::size_t _cut_a, _cut_b;
+    if (na >= nb)
+    {
+        _cut_a = na / 2;
+        _cut_b = std::lower_bound(b, b + nb, a[_cut_a], comp) - b;
+    }
+    else
+    {
+        // equal keys from a stay ahead of those from b
+        _cut_b = nb / 2;
+        _cut_a = std::upper_bound(a, a + na, b[_cut_b], comp) - a;
+    }
+
+    TaskGroup _halves(pool);
+    _halves.run([&] { merge(pool, a, _cut_a, b, _cut_b, out, comp); });
+    merge(pool, a + _cut_a, na - _cut_a, b + _cut_b, nb - _cut_b, out + _cut_a + _cut_b, comp);
+    _halves.wait();
+}
+
+// sorts src[0, n). the result ends up in dst when into_dst, otherwise back in src;
+// the other array is the scratch space, and both hold live objects throughout
+template <typename T, typename Compare>
+void merge_sort(ThreadPool& pool, T* src, T* dst, std::size_t n, bool into_dst, std::size_t leaf, Compare& comp)
+{
+    if (n <= leaf)
+    {
+        std::sort(src, src + n, comp);
+        if (into_dst)
+        {
+            std::move(src, src + n, dst);
+        }
+        return;
+    }
+
+    std::size_t _mid = n / 2;
+    TaskGroup   _halves(pool);
+    _halves.run([&] { merge_sort(pool, src, dst, _mid, !into_dst, leaf, comp); });
+    merge_sort(pool, src + _mid, dst + _mid, n - _mid, !into_dst, leaf, comp);
+    _halves.wait();
+
+    // the sorted halves are in whichever array the result is not
+    T* _from = into_dst ? src : dst;
+    T* _to   = into_dst ? dst : src;
+    merge(pool, _from, _mid, _from + _mid, n - _mid, _to, comp);
+}
+
+} // namespace detail
+
+//================================================================================================
+
+template <typename T, typename Fn>
+void for_each(ThreadPool& pool, T* first, T* last, Fn fn)
+{
+    std::size_t _n = last - first;
+    if (detail::run_serial(pool, _n))
+    {
+        std::for_each(first, last, fn);
+        return;
+    }
+
+    detail::parallel_for(pool, _n, detail::grain_size(pool, _n), [first, &fn](std::size_t begin, std::size_t end) {
+        std::for_each(first + begin, first + end, fn);
+    });
+}
+
+// out[i] = fn(first[i]); out may be first
+template <typename T, typename U, typename Fn>
+U* transform(ThreadPool& pool, T* first, T* last, U* out, Fn fn)
+{
+    std::size_t _n = last - first;
+    if (detail::run_serial(pool, _n))
+    {
+        return std::transform(first, last, out, fn);
+    }
+
+    detail::parallel_for(pool, _n, detail::grain_size(pool, _n), [first, out, &fn](std::size_t begin, std::size_t end) {
+        std::transform(first + begin, first + end, out + begin, fn);
+    });
+    return out + _n;
+}
+
+// out[i] = fn(first1[i], first2[i])
+template <typename T1, typename T2, typename U, typename Fn>
+U* transform(ThreadPool& pool, T1* first1, T1* last1, T2* first2, U* out, Fn fn)
+{
+    std::size_t _n = last1 - first1;
+    if (detail::run_serial(pool, _n))
+    {
+        return std::transform(first1, last1, first2, out, fn);
+    }
+
+    detail::parallel_for(pool, _n, detail::grain_size(pool, _n), [first1, first2, out, &fn](std::size_t begin, std::size_t end) {
+        std::transform(first1 + begin, first1 + end, first2 + begin, out + begin, fn);
+    });
+    return out + _n;
+}
+
+// op must be associative; chunk results are combined left to right, so it need not commute
+template <typename T, typename Init, typename Op = std::plus<>>
+Init reduce(ThreadPool& pool, T* first, T* last, Init init, Op op = Op())
+{
+    std::size_t _n = last - first;
+    if (detail::run_serial(pool, _n))
+    {
+        return std::accumulate(first, last, std::move(init), op);
+    }
+
+    std::size_t       _grain  = detail::grain_size(pool, _n);
+    std::size_t       _chunks = detail::chunk_count(_n, _grain);
+    std::vector<Init> _partial(_chunks, init);
+
+    // each chunk starts from its own first element, so init is folded in exactly once
+    detail::parallel_for(pool, _chunks, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t c = begin; c < end; c++)
+        {
+            T*   _first = first + c * _grain;
+            T*   _last  = first + std::min(_n, (c + 1) * _grain);
+            Init _acc   = *_first;
+            for (T* p = _first + 1; p != _last; ++p)
+            {
+                _acc = op(std::move(_acc), *p);
+            }
+            _partial[c] = std::move(_acc);
+        }
+    });
+
+    for (std::size_t c = 0; c < _chunks; c++)
+    {
+        init = op(std::move(init), std::move(_partial[c]));
+    }
+    return init;
+}
+
+// out[i] = first[0] op ... op first[i]; out may be first. two passes: chunk totals in
+// parallel, a serial scan over the totals, then every chunk scans from its carry
+template <typename T, typename U, typename Op = std::plus<>>
+U* inclusive_scan(ThreadPool& pool, T* first, T* last, U* out, Op op = Op())
+{
+    std::size_t _n = last - first;
+    if (detail::run_serial(pool, _n))
+    {
+        return std::partial_sum(first, last, out, op);
+    }
+
+    std::size_t    _grain  = detail::grain_size(pool, _n);
+    std::size_t    _chunks = detail::chunk_count(_n, _grain);
+    std::vector<U> _carry(_chunks, U(*first));
+
+    detail::parallel_for(pool, _chunks - 1, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t c = begin; c < end; c++)
+        {
+            T* _first = first + c * _grain;
+            U  _acc   = *_first;
+            for (T* p = _first + 1; p != _first + _grain; ++p)
+            {
+                _acc = op(std::move(_acc), *p);
+            }
+            _carry[c + 1] = std::move(_acc);
+        }
+    });
+
+    // _carry[c] becomes the total of every chunk before c
+    for (std::size_t c = 2; c < _chunks; c++)
+    {
+        _carry[c] = op(_carry[c - 1], _carry[c]);
+    }
+
+    detail::parallel_for(pool, _chunks, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t c = begin; c < end; c++)
+        {
+            T* _first = first + c * _grain;
+            T* _last  = first + std::min(_n, (c + 1) * _grain);
+            U* _out   = out + c * _grain;
+            if (c == 0)
+            {
+                std::partial_sum(_first, _last, _out, op);
+                continue;
+            }
+
+            U _acc = _carry[c];
+            for (T* p = _first; p != _last; ++p, ++_out)
+            {
+                _acc  = op(std::move(_acc), *p);
+                *_out = _acc;
+            }
+        }
+    });
+    return out + _n;
+}
+
+// not stable. parallel merge sort: leaves use std::sort, merges split recursively;
+// needs one scratch copy of the range
+template <typename T, typename Compare = std::less<>>
+void sort(ThreadPool& pool, T* first, T* last, Compare comp = Compare())
+{
+    std::size_t _n = last - first;
+    if (detail::run_serial(pool, _n))
+    {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<T> _scratch(std::make_move_iterator(first), std::make_move_iterator(last));
+    detail::merge_sort(pool, _scratch.data(), first, _n, true, detail::grain_size(pool, _n), comp);
+}
+
+//================================================================================================
+// the same on the shared pool
+
+template <typename T, typename Fn>
+void for_each(T* first, T* last, Fn fn)
+{
+    for_each(ThreadPool::instance(), first, last, std::move(fn));
+}
+
+template <typename T, typename U, typename Fn>
+U* transform(T* first, T* last, U* out, Fn fn)
+{
+    return transform(ThreadPool::instance(), first, last, out, std::move(fn));
+}
+
+template <typename T1, typename T2, typename U, typename Fn>
+U* transform(T1* first1, T1* last1, T2* first2, U* out, Fn fn)
+{
+    return transform(ThreadPool::instance(), first1, last1, first2, out, std::move(fn));
+}
+
+template <typename T, typename Init, typename Op = std::plus<>>
+Init reduce(T* first, T* last, Init init, Op op = Op())
+{
+    return reduce(ThreadPool::instance(), first, last, std::move(init), std::move(op));
+}
+
+template <typename T, typename U, typename Op = std::plus<>>
+U* inclusive_scan(T* first, T* last, U* out, Op op = Op())
+{
+    return inclusive_scan(ThreadPool::instance(), first, last, out, std::move(op));
+}
+
+template <typename T, typename Compare = std::less<>>
+void sort(T* first, T* last, Compare comp = Compare())
+{
+    sort(ThreadPool::instance(), first, last, std::move(comp));
+}
+
+// whole vectors
+
+template <typename T, typename A, typename S, typename Fn>
+void for_each(vector<T, A, S>& v, Fn fn)
+{
+    for_each(v.begin(), v.end(), std::move(fn));
+}
+
+template <typename T, typename A, typename S, typename Init, typename Op = std::plus<>>
+Init reduce(const vector<T, A, S>& v, Init init, Op op = Op())
+{
+    return reduce(v.begin(), v.end(), std::move(init), std::move(op));
+}
+
+template <typename T, typename A, typename S, typename Compare = std::less<>>
+void sort(vector<T, A, S>& v, Compare comp = Compare())
+{
+    sort(v.begin(), v.end(), std::move(comp));
+}
+
+} // namespace parallel
+} // namespace m_std
@@ -0,0 +1,475 @@
+#pragma once
+
+#include "m_pair.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+namespace m_std
+{
+
+namespace detail
+{
+
+// an AVL node shared between versions. left, right and the pair never change once a
+// second version holds the node; refs counts the parents and handles holding it
+template <typename Key_t, typename Value_t>
+struct persistent_node
+{
+    template <typename K, typename V>
+    persistent_node(K&& key, V&& value) :
+        kv(std::forward<K>(key), std::forward<V>(value))
+    {
+    }
+
+    persistent_node(const persistent_node& other) :
+        kv(other.kv), left(other.left), right(other.right), height(other.height)
+    {
+    }
+
+    pair<Key_t, Value_t>       kv;
+    persistent_node*           left   = nullptr;
+    persistent_node*           right  = nullptr;
+    int                        height = 1;
+    std::atomic<std::uint32_t> refs{ 1 };
+};
+
+template <typename Node>
+void retain(Node* n)
+{
+    if (n != nullptr)
+    {
+        n->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// the last handle frees the node and lets go of its children
+template <typename Node>
+void release(Node* n)
+{
+    while (n != nullptr && n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        release(n->left);
+        Node* _right = n->right;
+        delete n;
+        n = _right;
+    }
+}
+
+// in key order over a frozen tree, with the path down kept on a fixed stack: an AVL
+// tree of height 64 would need more nodes than memory holds
+template <typename Node>
+class persistent_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = decltype(Node::kv);
+    using difference_type   = std::ptrdiff_t;
+    using reference         = const value_type&;
+    using pointer           = const value_type*;
+
+    persistent_iterator() = default;
+
+    explicit persistent_iterator(const Node* root) { pushLeft(root); }
+
+    reference operator*() const { return m_stack[m_depth - 1]->kv; }
+    pointer   operator->() const { return &m_stack[m_depth - 1]->kv; }
+
+    persistent_iterator& operator++()
+    {
+        const Node* _node = m_stack[--m_depth];
+        pushLeft(_node->right);
+        return *this;
+    }
+
+    persistent_iterator operator++(int)
+    {
+        persistent_iterator _tmp = *this;
+        ++*this;
+        return _tmp;
+    }
+
+    friend bool operator==(const persistent_iterator& a, const persistent_iterator& b)
+    {
+        return a.m_depth == b.m_depth && (a.m_depth == 0 || a.m_stack[a.m_depth - 1] == b.m_stack[b.m_depth - 1]);
+    }
+
+    friend bool operator!=(const persistent_iterator& a, const persistent_iterator& b) { return !(a == b); }
+
+private:
+    void pushLeft(const Node* n)
+    {
+        for (; n != nullptr; n = n->left)
+        {
+            m_stack[m_depth++] = n;
+        }
+    }
+
+    const Node* m_stack[64];
+    int         m_depth = 0;
+};
+
+} // namespace detail
+
+// an AVL map whose versions share structure. a write copies the nodes on its root-to-leaf
+// path that an older version still holds and links the copies to the untouched subtrees,
+// so snapshot() is one reference count on the root and a snapshot never changes. nodes
+// only the current version holds are changed in place, as in AVLTree, so a map nobody
+// snapshots pays for the reference counts and nothing else.
+//
+// writers and snapshot() share one mutex; a write holds it for its O(log n) path, a
+// snapshot for the root handoff. readers of a snapshot take no lock, from any thread,
+// while writers go on. nodes are freed by the last version that holds them.
+template <typename Key_t, typename Value_t, typename Compare = std::less<Key_t>>
+class persistent_map
+{
+    using node = detail::persistent_node<Key_t, Value_t>;
+
+public:
+    using key_type       = Key_t;
+    using mapped_type    = Value_t;
+    using key_compare    = Compare;
+    using pair_type      = pair<Key_t, Value_t>;
+    using const_iterator = detail::persistent_iterator<node>;
+
+    // a frozen version of the map
+    class snapshot_type
+    {
+    public:
+        snapshot_type() = default;
+
+        snapshot_type(const snapshot_type& other) :
+            m_root(other.m_root), m_size(other.m_size), m_comp(other.m_comp)
+        {
+            detail::retain(m_root);
+        }
+
+        snapshot_type(snapshot_type&& other) noexcept :
+            m_root(other.m_root), m_size(other.m_size), m_comp(other.m_comp)
+        {
+            other.m_root = nullptr;
+            other.m_size = 0;
+        }
+
+        snapshot_type& operator=(snapshot_type other) noexcept
+        {
+            std::swap(m_root, other.m_root);
+            std::swap(m_size, other.m_size);
+            std::swap(m_comp, other.m_comp);
+            return *this;
+        }
+
+        ~snapshot_type() { detail::release(m_root); }
+
+        std::size_t size() const { return m_size; }
+        bool        empty() const { return m_size == 0; }
+
+        // null if absent; valid as long as this snapshot (or a copy) lives
+        const Value_t* find(const Key_t& key) const
+        {
+            const node* _node = findNode(m_root, key, m_comp);
+            return _node == nullptr ? nullptr : &_node->kv.second;
+        }
+
+        bool contains(const Key_t& key) const { return findNode(m_root, key, m_comp) != nullptr; }
+
+        const_iterator begin() const { return const_iterator(m_root); }
+        const_iterator end() const { return const_iterator(); }
+
+    private:
+        friend class persistent_map;
+
+        snapshot_type(node* root, std::size_t size, const Compare& comp) :
+            m_root(root), m_size(size), m_comp(comp)
+        {
+        }
+
+        node*       m_root = nullptr;
+        std::size_t m_size = 0;
+        Compare     m_comp = Compare();
+    };
+
+    persistent_map() = default;
+
+    explicit persistent_map(const Compare& comp) :
+        m_comp(comp)
+    {
+    }
+
+    // O(1): the copy shares every node until one side writes
+    persistent_map(const persistent_map& other)
+    {
+        std::lock_guard<std::mutex> _guard(other.m_lock);
+        m_root = other.m_root;
+        m_size = other.m_size;
+        m_comp = other.m_comp;
+        detail::retain(m_root);
+    }
+
+    persistent_map& operator=(const persistent_map& other)
+    {
+        if (this != &other)
+        {
+            snapshot_type _other = other.snapshot();
+            std::lock_guard<std::mutex> _guard(m_lock);
+            std::swap(m_root, _other.m_root);
+            std::swap(m_size, _other.m_size);
+            m_comp = _other.m_comp;
+        }
+        return *this;
+    }
+
+    ~persistent_map() { detail::release(m_root); }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> _guard(m_lock);
+        return m_size;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // the current version, O(1)
+    snapshot_type snapshot() const
+    {
+        std::lock_guard<std::mutex> _guard(m_lock);
+        detail::retain(m_root);
+        return snapshot_type(m_root, m_size, m_comp);
+    }
+
+    // lookups on the current version copy the value out under the lock; scans and
+    // repeated reads belong on a snapshot
+    bool find(const Key_t& key, Value_t& out) const
+    {
+        std::lock_guard<std::mutex> _guard(m_lock);
+        const node*                 _node = findNode(m_root, key, m_comp);
+        if (_node == nullptr)
+        {
+            return false;
+        }
+        out = _node->kv.second;
+        return true;
+    }
+
+    bool contains(const Key_t& key) const
+    {
+        std::lock_guard<std::mutex> _guard(m_lock);
+        return findNode(m_root, key, m_comp) != nullptr;
+    }
+
+    // returns false, and changes nothing, if the key is there
+    bool insert(const Key_t& key, const Value_t& value)
+    {
+        std::lock_guard<std::mutex> _guard(m_lock);
+        if (findNode(m_root, key, m_comp) != nullptr)
+        {
+            return false;
+        }
+        bool _added = false;
+        m_root      = insertAt(m_root, key, value, _added);
+        m_size++;
+        return true;
+    }
+
+    // returns true if the key was new
+    bool insert_or_assign(const Key_t& key, const Value_t& value)
+    {
+        std::lock_guard<std::mutex> _guard(m_lock);
+        bool                        _added = false;
+        m_root                             = insertAt(m_root, key, value, _added);
+        m_size += _added;
+        return _added;
+    }
+
+    // returns true if the key was there
+    bool erase(const Key_t& key)
+    {
+        std::lock_guard<std::mutex> _guard(m_lock);
+        if (findNode(m_root, key, m_comp) == nullptr)
+        {
+            return false;
+        }
+        m_root = eraseAt(m_root, key);
+        m_size--;
+        return true;
+    }
+
+    void clear()
+    {
+        node* _root = nullptr;
+        {
+            std::lock_guard<std::mutex> _guard(m_lock);
+            std::swap(_root, m_root);
+            m_size = 0;
+        }
+        detail::release(_root);
+    }
+
+private:
+    static const node* findNode(const node* n, const Key_t& key, const Compare& comp)
+    {
+        while (n != nullptr)
+        {
+            if (comp(key, n->kv.first))
+            {
+                n = n->left;
+            }
+            else if (comp(n->kv.first, key))
+            {
+                n = n->right;
+            }
+            else
+            {
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    // the writes below take over the caller's handle on n and hand back one on the result
+
+    // n itself if no other version holds it, otherwise a copy that holds its children
+    static node* own(node* n)
+    {
+        if (n->refs.load(std::memory_order_acquire) == 1)
+        {
+            return n;
+        }
+        node* _copy = new node(*n);
+        detail::retain(_copy->left);
+        detail::retain(_copy->right);
+        detail::release(n);
+        return _copy;
+    }
+
+    node* insertAt(node* n, const Key_t& key, const Value_t& value, bool& added)
+    {
+        if (n == nullptr)
+        {
+            added = true;
+            return new node(key, value);
+        }
+        n = own(n);
+        if (m_comp(key, n->kv.first))
+        {
+            n->left = insertAt(n->left, key, value, added);
+        }
+        else if (m_comp(n->kv.first, key))
+        {
+            n->right = insertAt(n->right, key, value, added);
+        }
+        else
+        {
+            n->kv.second = value;
+            return n;
+        }
+        return added ? rebalance(n) : n;
+    }
+
+    // the key is in the subtree
+    node* eraseAt(node* n, const Key_t& key)
+    {
+        n = own(n);
+        if (m_comp(key, n->kv.first))
+        {
+            n->left = eraseAt(n->left, key);
+            return rebalance(n);
+        }
+        if (m_comp(n->kv.first, key))
+        {
+            n->right = eraseAt(n->right, key);
+            return rebalance(n);
+        }
+
+        node* _left  = n->left;
+        node* _right = n->right;
+        n->left = n->right = nullptr;
+        detail::release(n);
+        if (_left == nullptr || _right == nullptr)
+        {
+            return _left != nullptr ? _left : _right;
+        }
+        // the successor takes n's place
+        node* _successor   = nullptr;
+        _right             = removeMin(_right, _successor);
+        _successor->left  = _left;
+        _successor->right = _right;
+        return rebalance(_successor);
+    }
+
+    // detaches the leftmost node of the subtree as min, owned and childless
+    node* removeMin(node* n, node*& min)
+    {
+        n = own(n);
+        if (n->left == nullptr)
+        {
+            node* _right = n->right;
+            n->right     = nullptr;
+            min          = n;
+            return _right;
+        }
+        n->left = removeMin(n->left, min);
+        return rebalance(n);
+    }
+
+    static int heightOf(const node* n) { return n == nullptr ? 0 : n->height; }
+
+    static void updateHeight(node* n) { n->height = 1 + std::max(heightOf(n->left), heightOf(n->right)); }
+
+    // n owned; a rotation owns the child it lifts
+    static node* rotateRight(node* n)
+    {
+        node* _left = own(n->left);
+        n->left     = _left->right;
+        _left->right = n;
+        updateHeight(n);
+        updateHeight(_left);
+        return _left;
+    }
+
+    static node* rotateLeft(node* n)
+    {
+        node* _right = own(n->right);
+        n->right     = _right->left;
+        _right->left = n;
+        updateHeight(n);
+        updateHeight(_right);
+        return _right;
+    }
+
+    static node* rebalance(node* n)
+    {
+        updateHeight(n);
+        int _balance = heightOf(n->left) - heightOf(n->right);
+        if (_balance > 1)
+        {
+            if (heightOf(n->left->left) < heightOf(n->left->right))
+            {
+                n->left = rotateLeft(own(n->left));
+            }
+            return rotateRight(n);
+        }
+        if (_balance < -1)
+        {
+            if (heightOf(n->right->right) < heightOf(n->right->left))
+            {
+                n->right = rotateRight(own(n->right));
+            }
+            return rotateLeft(n);
+        }
+        return n;
+    }
+
+    node*              m_root = nullptr;
+    std::size_t        m_size = 0;
+    Compare            m_comp = Compare();
+    mutable std::mutex m_lock;
+};
+
+} // namespace m_std
@@ -0,0 +1,459 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "m_AVLTree.h"
+#include "m_pair.h"
+#include "m_vector.hpp"
+
+// binary snapshots of containers. a snapshot is a fixed header followed by the
+// elements in iteration order:
+//
+//   magic "mstd"  u16 version  u16 container kind  u32 key bytes  u32 value bytes  u64 count
+//
+// key / value bytes are sizeof the type, with the top bit set when it goes through a
+// serializer instead of raw bytes, so a snapshot is never read back as a different
+// layout. integers are in host byte order. trees are written in key order, which lets
+// restore rebuild them balanced in O(n).
+//
+// a corrupt count or length must not size an allocation: counts are checked against the
+// bytes left when the stream can seek, and strings and vectors grow in bounded steps as
+// their bytes arrive.
+namespace m_std
+{
+
+// buffers small writes and passes large ones straight through
+class binary_writer
+{
+public:
+    explicit binary_writer(std::ostream& os, std::size_t buffer_size = std::size_t(1) << 16) :
+        m_os(os), m_buffer(buffer_size)
+    {
+    }
+
+    binary_writer(const binary_writer&)            = delete;
+    binary_writer& operator=(const binary_writer&) = delete;
+
+    // call flush() to see write errors, a destructor can't report them
+    ~binary_writer()
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    void write_bytes(const void* p, std::size_t n)
+    {
+        if (m_used + n > m_buffer.size())
+        {
+            flush();
+            if (n >= m_buffer.size())
+            {
+                put(p, n);
+                return;
+            }
+        }
+        std::memcpy(m_buffer.data() + m_used, p, n);
+        m_used += n;
+    }
+
+    template <typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "write() copies raw bytes, use a serializer");
+        write_bytes(&value, sizeof(T));
+    }
+
+    void flush()
+    {
+        if (m_used != 0)
+        {
+            std::size_t _used = m_used;
+            m_used            = 0;
+            put(m_buffer.data(), _used);
+        }
+        m_os.flush();
+    }
+
+private:
+    void put(const void* p, std::size_t n)
+    {
+        m_os.write(static_cast<const char*>(p), std::streamsize(n));
+        if (!m_os)
+        {
+            throw std::runtime_error("binary_writer: write failed");
+        }
+    }
+
+private:
+    std::ostream& m_os;
+    vector<char>  m_buffer;
+    std::size_t   m_used = 0;
+};
+
+class binary_reader
+{
+public:
+    explicit binary_reader(std::istream& is, std::size_t buffer_size = std::size_t(1) << 16) :
+        m_is(is), m_buffer(buffer_size)
+    {
+    }
+
+    binary_reader(const binary_reader&)            = delete;
+    binary_reader& operator=(const binary_reader&) = delete;
+
+    // throws std::runtime_error when the stream ends first
+    void read_bytes(void* p, std::size_t n)
+    {
+        char*       _out      = static_cast<char*>(p);
+        std::size_t _buffered = std::min(n, m_end - m_begin);
+        std::memcpy(_out, m_buffer.data() + m_begin, _buffered);
+        m_begin += _buffered;
+        _out += _buffered;
+        n -= _buffered;
+
+        if (n >= m_buffer.size())
+        {
+            get(_out, n, n);
+            return;
+        }
+        if (n != 0)
+        {
+            m_begin = 0;
+            m_end   = get(m_buffer.data(), n, m_buffer.size());
+            std::memcpy(_out, m_buffer.data(), n);
+            m_begin = n;
+        }
+    }
+
+    template <typename T>
+    T read()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "read() copies raw bytes, use a serializer");
+        T _value;
+        read_bytes(&_value, sizeof(T));
+        return _value;
+    }
+
+    // bytes left to read, UINT64_MAX when the stream can't seek to tell
+    std::uint64_t remaining()
+    {
+        std::istream::pos_type _at = m_is.tellg();
+        if (_at == std::istream::pos_type(-1))
+        {
+            m_is.clear(m_is.rdstate() & ~std::ios::failbit);
+            return std::uint64_t(-1);
+        }
+        m_is.seekg(0, std::ios::end);
+        std::istream::pos_type _end = m_is.tellg();
+        m_is.seekg(_at);
+        if (_end == std::istream::pos_type(-1) || !m_is)
+        {
+            m_is.clear(m_is.rdstate() & ~std::ios::failbit);
+            return std::uint64_t(-1);
+        }
+        return std::uint64_t(m_end - m_begin) + std::uint64_t(_end - _at);
+    }
+
+    // elements of elem_bytes each to take in one step out of count, so a step never
+    // allocates much ahead of the bytes that back it
+    static std::size_t step(std::uint64_t count, std::size_t elem_bytes)
+    {
+        std::uint64_t _max = std::max<std::uint64_t>(1, step_bytes / std::max<std::size_t>(1, elem_bytes));
+        return std::size_t(std::min(count, _max));
+    }
+
+    static constexpr std::size_t step_bytes = std::size_t(1) << 20;
+
+private:
+    // at least min_n bytes, up to max_n
+    std::size_t get(char* p, std::size_t min_n, std::size_t max_n)
+    {
+        std::size_t _got = 0;
+        while (_got < min_n)
+        {
+            m_is.read(p + _got, std::streamsize(max_n - _got));
+            std::size_t _n = std::size_t(m_is.gcount());
+            if (_n == 0)
+            {
+                throw std::runtime_error("binary_reader: unexpected end of stream");
+            }
+            _got += _n;
+        }
+        m_is.clear(m_is.rdstate() & ~std::ios::failbit & ~std::ios::eofbit);
+        return _got;
+    }
+
+private:
+    std::istream& m_is;
+    vector<char>  m_buffer;
+    std::size_t   m_begin = 0;
+    std::size_t   m_end   = 0;
+};
+
+//================================================================================================
+// how one value is written. the primary template stores trivially copyable types as raw
+// bytes; specialize it for anything else:
+//
+//   template <> struct serializer<Widget>
+//   {
+//       static constexpr bool raw = false;
+//       static void   write(binary_writer& w, const Widget& value);
+//       static Widget read(binary_reader& r);
+//   };
+template <typename T, typename = void>
+struct serializer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "no serializer<T> for this type");
+
+    static constexpr bool raw = true;
+
+    static void write(binary_writer& w, const T& value) { w.write(value); }
+    static T    read(binary_reader& r) { return r.read<T>(); }
+};
+
+namespace detail
+{
+
+// the fewest stream bytes one T takes: sizeof for raw types, otherwise the serializer's
+// min_bytes, 0 (no bound) when it declares none
+template <typename T, typename = void>
+struct min_bytes_of : std::integral_constant<std::uint64_t, serializer<T>::raw ? sizeof(T) : 0>
+{
+};
+
+template <typename T>
+struct min_bytes_of<T, std::void_t<decltype(serializer<T>::min_bytes)>> : std::integral_constant<std::uint64_t, serializer<T>::min_bytes>
+{
+};
+
+} // namespace detail
+
+// u64 length, then the characters
+template <typename Char, typename Traits, typename Alloc>
+struct serializer<std::basic_string<Char, Traits, Alloc>>
+{
+    using string_type = std::basic_string<Char, Traits, Alloc>;
+
+    static constexpr bool          raw       = false;
+    static constexpr std::uint64_t min_bytes = sizeof(std::uint64_t);
+
+    static void write(binary_writer& w, const string_type& value)
+    {
+        w.write(std::uint64_t(value.size()));
+        w.write_bytes(value.data(), value.size() * sizeof(Char));
+    }
+
+    static string_type read(binary_reader& r)
+    {
+        std::uint64_t _length = r.read<std::uint64_t>();
+        string_type   _value;
+        while (_value.size() < _length)
+        {
+            std::size_t _at = _value.size();
+            std::size_t _n  = binary_reader::step(_length - _at, sizeof(Char));
+            _value.resize(_at + _n);
+            r.read_bytes(&_value[_at], _n * sizeof(Char));
+        }
+        return _value;
+    }
+};
+
+// field by field; a trivially copyable pair takes the raw path instead
+template <typename Key_t, typename Value_t>
+struct serializer<pair<Key_t, Value_t>, typename std::enable_if<!std::is_trivially_copyable<pair<Key_t, Value_t>>::value>::type>
+{
+    static constexpr bool          raw       = false;
+    static constexpr std::uint64_t min_bytes = detail::min_bytes_of<Key_t>::value + detail::min_bytes_of<Value_t>::value;
+
+    static void write(binary_writer& w, const pair<Key_t, Value_t>& value)
+    {
+        serializer<Key_t>::write(w, value.first);
+        serializer<Value_t>::write(w, value.second);
+    }
+
+    static pair<Key_t, Value_t> read(binary_reader& r)
+    {
+        Key_t _key = serializer<Key_t>::read(r); // sequenced: key bytes come first
+        return pair<Key_t, Value_t>(std::move(_key), serializer<Value_t>::read(r));
+    }
+};
+
+//================================================================================================
+
+namespace detail
+{
+
+constexpr char          snapshot_magic[4] = { 'm', 's', 't', 'd' };
+constexpr std::uint16_t snapshot_version  = 2;
+
+enum class snapshot_kind : std::uint16_t
+{
+    vector   = 1,
+    avl_tree = 2
+};
+
+constexpr std::uint32_t serialized_layout = std::uint32_t(1) << 31;
+
+template <typename T>
+constexpr std::uint32_t stored_size()
+{
+    return std::uint32_t(sizeof(T)) | (serializer<T>::raw ? 0 : serialized_layout);
+}
+
+inline void write_header(binary_writer& w, snapshot_kind kind, std::uint32_t key_bytes, std::uint32_t value_bytes, std::uint64_t count)
+{
+    w.write_bytes(snapshot_magic, sizeof(snapshot_magic));
+    w.write(snapshot_version);
+    w.write(std::uint16_t(kind));
+    w.write(key_bytes);
+    w.write(value_bytes);
+    w.write(count);
+}
+
+// returns the element count, after checking that count elements of at least
+// min_element_bytes each fit in what is left of the stream
+inline std::uint64_t read_header(binary_reader& r, snapshot_kind kind, std::uint32_t key_bytes, std::uint32_t value_bytes,
+                                 std::uint64_t min_element_bytes)
+{
+    char _magic[4];
+    r.read_bytes(_magic, sizeof(_magic));
+    if (std::memcmp(_magic, snapshot_magic, sizeof(_magic)) != 0)
+    {
+        throw std::runtime_error("snapshot: bad magic");
+    }
+    if (r.read<std::uint16_t>() != snapshot_version)
+    {
+        throw std::runtime_error("snapshot: unsupported version");
+    }
+    if (r.read<std::uint16_t>() != std::uint16_t(kind))
+    {
+        throw std::runtime_error("snapshot: written by another container");
+    }
+    std::uint32_t _key_bytes   = r.read<std::uint32_t>();
+    std::uint32_t _value_bytes = r.read<std::uint32_t>();
+    if (_key_bytes != key_bytes || _value_bytes != value_bytes)
+    {
+        throw std::runtime_error("snapshot: element layout differs");
+    }
+    std::uint64_t _count = r.read<std::uint64_t>();
+    if (min_element_bytes != 0 && _count > r.remaining() / min_element_bytes)
+    {
+        throw std::runtime_error("snapshot: count runs past the end of the stream");
+    }
+    return _count;
+}
+
+} // namespace detail
+
+// vector ===========
+
+template <typename T, typename A, typename S>
+void serialize(binary_writer& w, const vector<T, A, S>& v)
+{
+    detail::write_header(w, detail::snapshot_kind::vector, detail::stored_size<T>(), 0, v.size());
+    if constexpr (serializer<T>::raw)
+    {
+        w.write_bytes(v.data(), v.size() * sizeof(T)); // one block, no per-element calls
+    }
+    else
+    {
+        for (const T& value : v)
+        {
+            serializer<T>::write(w, value);
+        }
+    }
+}
+
+template <typename T, typename A, typename S>
+void deserialize(binary_reader& r, vector<T, A, S>& v)
+{
+    std::size_t _count =
+        std::size_t(detail::read_header(r, detail::snapshot_kind::vector, detail::stored_size<T>(), 0, detail::min_bytes_of<T>::value));
+    v.clear();
+    if constexpr (serializer<T>::raw)
+    {
+        while (v.size() < _count)
+        {
+            std::size_t _at = v.size();
+            std::size_t _n  = binary_reader::step(_count - _at, sizeof(T));
+            v.resize(_at + _n);
+            r.read_bytes(v.data() + _at, _n * sizeof(T));
+        }
+    }
+    else
+    {
+        v.reserve(binary_reader::step(_count, sizeof(T)));
+        for (std::size_t i = 0; i < _count; i++)
+        {
+            v.push_back(serializer<T>::read(r));
+        }
+    }
+}
+
+// AVLTree ===========
+
+template <typename Key_t, typename Value_t, typename C, typename A, typename N, typename S>
+void serialize(binary_writer& w, const AVLTree<Key_t, Value_t, C, A, N, S>& tree)
+{
+    detail::write_header(w, detail::snapshot_kind::avl_tree, detail::stored_size<Key_t>(), detail::stored_size<Value_t>(), tree.size());
+    for (const auto& kv : tree)
+    {
+        serializer<Key_t>::write(w, kv.first);
+        serializer<Value_t>::write(w, kv.second);
+    }
+}
+
+// pairs arrive sorted, so the tree is rebuilt in O(n) without comparing keys
+template <typename Key_t, typename Value_t, typename C, typename A, typename N, typename S>
+void deserialize(binary_reader& r, AVLTree<Key_t, Value_t, C, A, N, S>& tree)
+{
+    std::uint64_t _count = detail::read_header(r, detail::snapshot_kind::avl_tree, detail::stored_size<Key_t>(), detail::stored_size<Value_t>(),
+                                               detail::min_bytes_of<Key_t>::value + detail::min_bytes_of<Value_t>::value);
+    tree.assign_sorted(std::size_t(_count), [&r] {
+        Key_t _key = serializer<Key_t>::read(r);
+        return pair<Key_t, Value_t>(std::move(_key), serializer<Value_t>::read(r));
+    });
+}
+
+// whole files ===========
+
+template <typename Container>
+void save_snapshot(const std::string& path, const Container& c)
+{
+    std::ofstream _file(path, std::ios::binary | std::ios::trunc);
+    if (!_file)
+    {
+        throw std::runtime_error("snapshot: can't create " + path);
+    }
+    binary_writer _writer(_file);
+    serialize(_writer, c);
+    _writer.flush();
+}
+
+template <typename Container>
+void load_snapshot(const std::string& path, Container& c)
+{
+    std::ifstream _file(path, std::ios::binary);
+    if (!_file)
+    {
+        throw std::runtime_error("snapshot: can't open " + path);
+    }
+    binary_reader _reader(_file);
+    deserialize(_reader, c);
+}
+
+} // namespace m_std
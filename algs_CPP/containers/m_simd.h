@@ -0,0 +1,696 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "m_span.h"
+#include "m_vector.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    define M_SIMD_X86 1
+#    include <immintrin.h>
+#    if defined(_MSC_VER) && !defined(__clang__)
+#        include <intrin.h>
+#    endif
+#else
+#    define M_SIMD_X86 0
+#endif
+
+// compile the code between BEGIN/END for one instruction set without enabling it for
+// the whole translation unit. msvc emits any intrinsic anywhere, so it needs nothing.
+#define M_SIMD_PRAGMA(x) _Pragma(#x)
+#if defined(__clang__)
+#    define M_SIMD_TARGET_BEGIN(isa_string) M_SIMD_PRAGMA(clang attribute push(__attribute__((target(isa_string))), apply_to = function))
+#    define M_SIMD_TARGET_END               M_SIMD_PRAGMA(clang attribute pop)
+#elif defined(__GNUC__)
+#    define M_SIMD_TARGET_BEGIN(isa_string) M_SIMD_PRAGMA(GCC push_options) M_SIMD_PRAGMA(GCC target(isa_string))
+#    define M_SIMD_TARGET_END               M_SIMD_PRAGMA(GCC pop_options)
+#else
+#    define M_SIMD_TARGET_BEGIN(isa_string)
+#    define M_SIMD_TARGET_END
+#endif
+
+// bulk kernels for arithmetic buffers: fill, count, find, lower_bound, min/max, sum, dot
+// and element-wise transform. float, double and int32_t get sse2 / avx2 / avx-512 code
+// picked at runtime; every other arithmetic type, and every non-x86 target, runs the
+// scalar loop. inputs are assumed NaN-free, and float sums are reassociated.
+namespace m_std
+{
+namespace simd
+{
+
+enum class isa
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+// element-wise operations transform() has vector kernels for
+struct plus
+{
+    template <typename T>
+    T operator()(T a, T b) const { return a + b; }
+};
+
+struct minus
+{
+    template <typename T>
+    T operator()(T a, T b) const { return a - b; }
+};
+
+struct multiplies
+{
+    template <typename T>
+    T operator()(T a, T b) const { return a * b; }
+};
+
+namespace detail
+{
+
+inline unsigned popcount(std::uint64_t mask)
+{
+    unsigned _count = 0;
+    for (; mask != 0; mask &= mask - 1)
+    {
+        _count++;
+    }
+    return _count;
+}
+
+// mask != 0
+inline unsigned count_trailing_zeros(std::uint64_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long _index;
+    _BitScanForward64(&_index, mask);
+    return unsigned(_index);
+#else
+    return unsigned(__builtin_ctzll(mask));
+#endif
+}
+
+inline isa detect_isa()
+{
+#if !M_SIMD_X86
+    return isa::scalar;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int _regs[4];
+    __cpuid(_regs, 0);
+    int _max_leaf = _regs[0];
+
+    __cpuid(_regs, 1);
+    bool _sse2    = (_regs[3] & (1 << 26)) != 0;
+    bool _osxsave = (_regs[2] & (1 << 27)) != 0;
+    if (!_sse2)
+    {
+        return isa::scalar;
+    }
+    if (!_osxsave || _max_leaf < 7)
+    {
+        return isa::sse2;
+    }
+
+    // the os must save the ymm / zmm state for us
+    unsigned long long _xcr0 = _xgetbv(0);
+    __cpuidex(_regs, 7, 0);
+    bool _avx2   = (_regs[1] & (1 << 5)) != 0 && (_xcr0 & 0x6) == 0x6;
+    bool _avx512 = (_regs[1] & (1 << 16)) != 0 && (_xcr0 & 0xE6) == 0xE6;
+    return _avx512 ? isa::avx512 : _avx2 ? isa::avx2 : isa::sse2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return isa::avx2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return isa::sse2;
+    }
+    return isa::scalar;
+#endif
+}
+
+inline isa& forced_isa()
+{
+    static isa _forced = detect_isa();
+    return _forced;
+}
+
+template <typename T>
+struct has_simd_ops : std::integral_constant<bool,
+                                             M_SIMD_X86
+                                                 && (std::is_same<T, float>::value
+                                                     || std::is_same<T, double>::value
+                                                     || std::is_same<T, std::int32_t>::value)>
+{
+};
+
+// the operations the vector kernels have an instruction for
+template <typename Op>
+struct is_vector_op : std::integral_constant<bool, std::is_same<Op, plus>::value || std::is_same<Op, minus>::value
+                                                       || std::is_same<Op, multiplies>::value>
+{
+};
+
+//================================================================================================
+// plain loops: the fallback, and the reference the vector kernels are measured against
+namespace scalar
+{
+
+template <typename T>
+void fill(T* p, std::size_t n, T value)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        p[i] = value;
+    }
+}
+
+template <typename T>
+std::size_t count(const T* p, std::size_t n, T value)
+{
+    std::size_t _count = 0;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        _count += (p[i] == value);
+    }
+    return _count;
+}
+
+template <typename T>
+std::size_t find(const T* p, std::size_t n, T value)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        if (p[i] == value)
+        {
+            return i;
+        }
+    }
+    return n;
+}
+
+template <typename T>
+std::size_t lower_bound(const T* p, std::size_t n, T value)
+{
+    std::size_t i = 0;
+    for (; i < n && p[i] < value; i++)
+    {
+    }
+    return i;
+}
+
+template <typename T>
+T min_value(const T* p, std::size_t n)
+{
+    T _result = p[0];
+    for (std::size_t i = 1; i < n; i++)
+    {
+        _result = p[i] < _result ? p[i] : _result;
+    }
+    return _result;
+}
+
+template <typename T>
+T max_value(const T* p, std::size_t n)
+{
+    T _result = p[0];
+    for (std::size_t i = 1; i < n; i++)
+    {
+        _result = p[i] > _result ? p[i] : _result;
+    }
+    return _result;
+}
+
+template <typename T>
+T sum(const T* p, std::size_t n)
+{
+    T _result = T();
+    for (std::size_t i = 0; i < n; i++)
+    {
+        _result += p[i];
+    }
+    return _result;
+}
+
+template <typename T>
+T dot(const T* a, const T* b, std::size_t n)
+{
+    T _result = T();
+    for (std::size_t i = 0; i < n; i++)
+    {
+        _result += a[i] * b[i];
+    }
+    return _result;
+}
+
+template <typename T, typename Op>
+void transform(const T* a, const T* b, T* out, std::size_t n, Op op)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        out[i] = op(a[i], b[i]);
+    }
+}
+
+} // namespace scalar
+
+#if M_SIMD_X86
+
+//================================================================================================
+M_SIMD_TARGET_BEGIN("sse2")
+namespace sse2
+{
+
+template <typename T>
+struct ops;
+
+template <>
+struct ops<float>
+{
+    using reg                          = __m128;
+    static constexpr std::size_t width = 4;
+
+    static reg      load(const float* p) { return _mm_loadu_ps(p); }
+    static void     store(float* p, reg v) { _mm_storeu_ps(p, v); }
+    static reg      set1(float v) { return _mm_set1_ps(v); }
+    static reg      zero() { return _mm_setzero_ps(); }
+    static reg      add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg      sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg      mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg      min(reg a, reg b) { return _mm_min_ps(a, b); }
+    static reg      max(reg a, reg b) { return _mm_max_ps(a, b); }
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm_movemask_ps(_mm_cmpeq_ps(a, b))); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm_movemask_ps(_mm_cmplt_ps(a, b))); }
+};
+
+template <>
+struct ops<double>
+{
+    using reg                          = __m128d;
+    static constexpr std::size_t width = 2;
+
+    static reg      load(const double* p) { return _mm_loadu_pd(p); }
+    static void     store(double* p, reg v) { _mm_storeu_pd(p, v); }
+    static reg      set1(double v) { return _mm_set1_pd(v); }
+    static reg      zero() { return _mm_setzero_pd(); }
+    static reg      add(reg a, reg b) { return _mm_add_pd(a, b); }
+    static reg      sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+    static reg      mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+    static reg      min(reg a, reg b) { return _mm_min_pd(a, b); }
+    static reg      max(reg a, reg b) { return _mm_max_pd(a, b); }
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm_movemask_pd(_mm_cmpeq_pd(a, b))); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm_movemask_pd(_mm_cmplt_pd(a, b))); }
+};
+
+// sse2 has no 32-bit min/max/mullo, they're built from compares and 64-bit multiplies
+template <>
+struct ops<std::int32_t>
+{
+    using reg                          = __m128i;
+    static constexpr std::size_t width = 4;
+
+    static reg  load(const std::int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(std::int32_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static reg  set1(std::int32_t v) { return _mm_set1_epi32(v); }
+    static reg  zero() { return _mm_setzero_si128(); }
+    static reg  add(reg a, reg b) { return _mm_add_epi32(a, b); }
+    static reg  sub(reg a, reg b) { return _mm_sub_epi32(a, b); }
+
+    static reg mul(reg a, reg b)
+    {
+        __m128i _even = _mm_mul_epu32(a, b);
+        __m128i _odd  = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(_even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(_odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+
+    static reg min(reg a, reg b)
+    {
+        __m128i _a_greater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(_a_greater, b), _mm_andnot_si128(_a_greater, a));
+    }
+
+    static reg max(reg a, reg b)
+    {
+        __m128i _a_greater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(_a_greater, a), _mm_andnot_si128(_a_greater, b));
+    }
+
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(b, a)))); }
+};
+
+#    include "m_simd_kernels.inl"
+
+} // namespace sse2
+M_SIMD_TARGET_END
+
+//================================================================================================
+M_SIMD_TARGET_BEGIN("avx2")
+namespace avx2
+{
+
+template <typename T>
+struct ops;
+
+template <>
+struct ops<float>
+{
+    using reg                          = __m256;
+    static constexpr std::size_t width = 8;
+
+    static reg      load(const float* p) { return _mm256_loadu_ps(p); }
+    static void     store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+    static reg      set1(float v) { return _mm256_set1_ps(v); }
+    static reg      zero() { return _mm256_setzero_ps(); }
+    static reg      add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg      sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg      mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg      min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    static reg      max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ))); }
+};
+
+template <>
+struct ops<double>
+{
+    using reg                          = __m256d;
+    static constexpr std::size_t width = 4;
+
+    static reg      load(const double* p) { return _mm256_loadu_pd(p); }
+    static void     store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+    static reg      set1(double v) { return _mm256_set1_pd(v); }
+    static reg      zero() { return _mm256_setzero_pd(); }
+    static reg      add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static reg      sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    static reg      mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static reg      min(reg a, reg b) { return _mm256_min_pd(a, b); }
+    static reg      max(reg a, reg b) { return _mm256_max_pd(a, b); }
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ))); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ))); }
+};
+
+template <>
+struct ops<std::int32_t>
+{
+    using reg                          = __m256i;
+    static constexpr std::size_t width = 8;
+
+    static reg      load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void     store(std::int32_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static reg      set1(std::int32_t v) { return _mm256_set1_epi32(v); }
+    static reg      zero() { return _mm256_setzero_si256(); }
+    static reg      add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    static reg      sub(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+    static reg      mul(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+    static reg      min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+    static reg      max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)))); }
+};
+
+#    include "m_simd_kernels.inl"
+
+} // namespace avx2
+M_SIMD_TARGET_END
+
+//================================================================================================
+M_SIMD_TARGET_BEGIN("avx512f")
+namespace avx512
+{
+
+template <typename T>
+struct ops;
+
+// min / max use the all-lanes masked forms: the unmasked ones pass gcc an
+// undefined source register and trip -Wmaybe-uninitialized once inlined
+template <>
+struct ops<float>
+{
+    using reg                          = __m512;
+    static constexpr std::size_t width = 16;
+
+    static reg      load(const float* p) { return _mm512_loadu_ps(p); }
+    static void     store(float* p, reg v) { _mm512_storeu_ps(p, v); }
+    static reg      set1(float v) { return _mm512_set1_ps(v); }
+    static reg      zero() { return _mm512_setzero_ps(); }
+    static reg      add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg      sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg      mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg      min(reg a, reg b) { return _mm512_mask_min_ps(a, 0xFFFF, a, b); }
+    static reg      max(reg a, reg b) { return _mm512_mask_max_ps(a, 0xFFFF, a, b); }
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ)); }
+};
+
+template <>
+struct ops<double>
+{
+    using reg                          = __m512d;
+    static constexpr std::size_t width = 8;
+
+    static reg      load(const double* p) { return _mm512_loadu_pd(p); }
+    static void     store(double* p, reg v) { _mm512_storeu_pd(p, v); }
+    static reg      set1(double v) { return _mm512_set1_pd(v); }
+    static reg      zero() { return _mm512_setzero_pd(); }
+    static reg      add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static reg      sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    static reg      mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static reg      min(reg a, reg b) { return _mm512_mask_min_pd(a, 0xFF, a, b); }
+    static reg      max(reg a, reg b) { return _mm512_mask_max_pd(a, 0xFF, a, b); }
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ)); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ)); }
+};
+
+template <>
+struct ops<std::int32_t>
+{
+    using reg                          = __m512i;
+    static constexpr std::size_t width = 16;
+
+    static reg      load(const std::int32_t* p) { return _mm512_loadu_si512(p); }
+    static void     store(std::int32_t* p, reg v) { _mm512_storeu_si512(p, v); }
+    static reg      set1(std::int32_t v) { return _mm512_set1_epi32(v); }
+    static reg      zero() { return _mm512_setzero_si512(); }
+    static reg      add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    static reg      sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+    static reg      mul(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+    static reg      min(reg a, reg b) { return _mm512_mask_min_epi32(a, 0xFFFF, a, b); }
+    static reg      max(reg a, reg b) { return _mm512_mask_max_epi32(a, 0xFFFF, a, b); }
+    static unsigned eq_mask(reg a, reg b) { return unsigned(_mm512_cmpeq_epi32_mask(a, b)); }
+    static unsigned lt_mask(reg a, reg b) { return unsigned(_mm512_cmplt_epi32_mask(a, b)); }
+};
+
+#    include "m_simd_kernels.inl"
+
+} // namespace avx512
+M_SIMD_TARGET_END
+
+#endif // M_SIMD_X86
+
+} // namespace detail
+
+//================================================================================================
+
+// what the cpu (and os) supports
+inline isa detected_isa()
+{
+    static const isa _isa = detail::detect_isa();
+    return _isa;
+}
+
+// what the kernels use right now
+inline isa active_isa()
+{
+    return detail::forced_isa();
+}
+
+// pin the kernels to a lower instruction set, e.g. to compare them in a benchmark.
+// requests above what the cpu supports are clamped.
+inline void force_isa(isa level)
+{
+    detail::forced_isa() = level < detected_isa() ? level : detected_isa();
+}
+
+inline const char* isa_name(isa level)
+{
+    switch (level)
+    {
+        case isa::sse2: return "sse2";
+        case isa::avx2: return "avx2";
+        case isa::avx512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+#if M_SIMD_X86
+#    define M_SIMD_DISPATCH(T, kernel, ...)                                 \
+        if constexpr (detail::has_simd_ops<T>::value)                       \
+        {                                                                   \
+            switch (active_isa())                                           \
+            {                                                               \
+                case isa::avx512: return detail::avx512::kernel(__VA_ARGS__); \
+                case isa::avx2: return detail::avx2::kernel(__VA_ARGS__);   \
+                case isa::sse2: return detail::sse2::kernel(__VA_ARGS__);   \
+                default: break;                                             \
+            }                                                               \
+        }                                                                   \
+        return detail::scalar::kernel(__VA_ARGS__);
+#else
+#    define M_SIMD_DISPATCH(T, kernel, ...) return detail::scalar::kernel(__VA_ARGS__);
+#endif
+
+template <typename T>
+void fill(T* p, std::size_t n, T value)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    M_SIMD_DISPATCH(T, fill, p, n, value)
+}
+
+template <typename T>
+std::size_t count(const T* p, std::size_t n, T value)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    M_SIMD_DISPATCH(T, count, p, n, value)
+}
+
+// index of the first match, n if there is none
+template <typename T>
+std::size_t find(const T* p, std::size_t n, T value)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    M_SIMD_DISPATCH(T, find, p, n, value)
+}
+
+// p sorted ascending: the index of the first element not less than value, n if none
+template <typename T>
+std::size_t lower_bound(const T* p, std::size_t n, T value)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    M_SIMD_DISPATCH(T, lower_bound, p, n, value)
+}
+
+template <typename T>
+T min(const T* p, std::size_t n)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    if (n == 0)
+    {
+        throw std::out_of_range("min() of an empty range");
+    }
+    M_SIMD_DISPATCH(T, min_value, p, n)
+}
+
+template <typename T>
+T max(const T* p, std::size_t n)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    if (n == 0)
+    {
+        throw std::out_of_range("max() of an empty range");
+    }
+    M_SIMD_DISPATCH(T, max_value, p, n)
+}
+
+template <typename T>
+T sum(const T* p, std::size_t n)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    M_SIMD_DISPATCH(T, sum, p, n)
+}
+
+template <typename T>
+T dot(const T* a, const T* b, std::size_t n)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    M_SIMD_DISPATCH(T, dot, a, b, n)
+}
+
+// out[i] = op(a[i], b[i]). plus / minus / multiplies run the vector kernels, any other
+// callable a plain loop, which the compiler may still vectorize
+template <typename T, typename Op>
+void transform(const T* a, const T* b, T* out, std::size_t n, Op op)
+{
+    static_assert(std::is_arithmetic<T>::value, "simd kernels work on arithmetic types");
+    if constexpr (!detail::is_vector_op<Op>::value)
+    {
+        detail::scalar::transform(a, b, out, n, op);
+    }
+    else
+    {
+        M_SIMD_DISPATCH(T, transform, a, b, out, n, op)
+    }
+}
+
+#undef M_SIMD_DISPATCH
+
+// m_std::vector overloads ===========
+
+template <typename T, typename A, typename S>
+void fill(vector<T, A, S>& v, T value) { fill(v.data(), v.size(), value); }
+
+template <typename T, typename A, typename S>
+std::size_t count(const vector<T, A, S>& v, T value) { return count(v.data(), v.size(), value); }
+
+template <typename T, typename A, typename S>
+T* find(vector<T, A, S>& v, T value) { return v.data() + find(v.data(), v.size(), value); }
+
+template <typename T, typename A, typename S>
+T min(const vector<T, A, S>& v) { return min(v.data(), v.size()); }
+
+template <typename T, typename A, typename S>
+T max(const vector<T, A, S>& v) { return max(v.data(), v.size()); }
+
+template <typename T, typename A, typename S>
+T sum(const vector<T, A, S>& v) { return sum(v.data(), v.size()); }
+
+template <typename T, typename A, typename SA, typename B, typename SB>
+T dot(const vector<T, A, SA>& a, const vector<T, B, SB>& b)
+{
+    if (a.size() != b.size())
+    {
+        throw std::invalid_argument("dot() of vectors with different sizes");
+    }
+    return dot(a.data(), b.data(), a.size());
+}
+
+template <typename T, typename A, typename SA, typename B, typename SB, typename Op>
+void transform(const vector<T, A, SA>& a, const vector<T, B, SB>& b, vector<T, A, SA>& out, Op op)
+{
+    if (a.size() != b.size())
+    {
+        throw std::invalid_argument("transform() of vectors with different sizes");
+    }
+    out.resize(a.size());
+    transform(a.data(), b.data(), out.data(), a.size(), op);
+}
+
+// span overloads, e.g. one column of an soa_vector ===========
+
+template <typename T>
+std::size_t count(span<T> s, typename std::remove_const<T>::type value) { return count<typename std::remove_const<T>::type>(s.data(), s.size(), value); }
+
+template <typename T>
+std::size_t find(span<T> s, typename std::remove_const<T>::type value) { return find<typename std::remove_const<T>::type>(s.data(), s.size(), value); }
+
+template <typename T>
+typename std::remove_const<T>::type min(span<T> s) { return min<typename std::remove_const<T>::type>(s.data(), s.size()); }
+
+template <typename T>
+typename std::remove_const<T>::type max(span<T> s) { return max<typename std::remove_const<T>::type>(s.data(), s.size()); }
+
+template <typename T>
+typename std::remove_const<T>::type sum(span<T> s) { return sum<typename std::remove_const<T>::type>(s.data(), s.size()); }
+
+} // namespace simd
+} // namespace m_std
@@ -0,0 +1,266 @@
+// bulk kernels written once against ops<T>: width, load/store, set1, arithmetic, eq_mask.
+// no include guard on purpose: m_simd.h includes this once per instruction set, inside
+// that set's namespace and target region, so every kernel is compiled for that set.
+
+template <typename T>
+T reduce_sum(typename ops<T>::reg r)
+{
+    alignas(64) T _lanes[ops<T>::width];
+    ops<T>::store(_lanes, r);
+    T _acc = _lanes[0];
+    for (std::size_t i = 1; i < ops<T>::width; i++)
+    {
+        _acc += _lanes[i];
+    }
+    return _acc;
+}
+
+template <typename T>
+T reduce_min(typename ops<T>::reg r)
+{
+    alignas(64) T _lanes[ops<T>::width];
+    ops<T>::store(_lanes, r);
+    T _acc = _lanes[0];
+    for (std::size_t i = 1; i < ops<T>::width; i++)
+    {
+        _acc = _lanes[i] < _acc ? _lanes[i] : _acc;
+    }
+    return _acc;
+}
+
+template <typename T>
+T reduce_max(typename ops<T>::reg r)
+{
+    alignas(64) T _lanes[ops<T>::width];
+    ops<T>::store(_lanes, r);
+    T _acc = _lanes[0];
+    for (std::size_t i = 1; i < ops<T>::width; i++)
+    {
+        _acc = _lanes[i] > _acc ? _lanes[i] : _acc;
+    }
+    return _acc;
+}
+
+template <typename T>
+void fill(T* p, std::size_t n, T value)
+{
+    using V = ops<T>;
+
+    auto        _v = V::set1(value);
+    std::size_t i  = 0;
+    for (; i + V::width <= n; i += V::width)
+    {
+        V::store(p + i, _v);
+    }
+    for (; i < n; i++)
+    {
+        p[i] = value;
+    }
+}
+
+template <typename T>
+std::size_t count(const T* p, std::size_t n, T value)
+{
+    using V = ops<T>;
+
+    auto        _v     = V::set1(value);
+    std::size_t _count = 0;
+    std::size_t i      = 0;
+    for (; i + V::width <= n; i += V::width)
+    {
+        _count += popcount(V::eq_mask(V::load(p + i), _v));
+    }
+    for (; i < n; i++)
+    {
+        _count += (p[i] == value);
+    }
+    return _count;
+}
+
+template <typename T>
+std::size_t find(const T* p, std::size_t n, T value)
+{
+    using V = ops<T>;
+
+    auto        _v = V::set1(value);
+    std::size_t i  = 0;
+    for (; i + V::width <= n; i += V::width)
+    {
+        auto _mask = V::eq_mask(V::load(p + i), _v);
+        if (_mask != 0)
+        {
+            return i + count_trailing_zeros(_mask);
+        }
+    }
+    for (; i < n; i++)
+    {
+        if (p[i] == value)
+        {
+            return i;
+        }
+    }
+    return n;
+}
+
+// p sorted ascending: the less-than lanes form a prefix, the first lane missing from it
+// is the answer
+template <typename T>
+std::size_t lower_bound(const T* p, std::size_t n, T value)
+{
+    using V = ops<T>;
+
+    constexpr unsigned _all_less = unsigned((std::uint64_t(1) << V::width) - 1);
+
+    auto        _v = V::set1(value);
+    std::size_t i  = 0;
+    for (; i + V::width <= n; i += V::width)
+    {
+        unsigned _mask = V::lt_mask(V::load(p + i), _v);
+        if (_mask != _all_less)
+        {
+            return i + count_trailing_zeros(~_mask);
+        }
+    }
+    for (; i < n && p[i] < value; i++)
+    {
+    }
+    return i;
+}
+
+// n >= 1
+template <typename T>
+T min_value(const T* p, std::size_t n)
+{
+    using V = ops<T>;
+
+    T           _result = p[0];
+    std::size_t i       = 0;
+    if (n >= V::width)
+    {
+        auto _acc = V::load(p);
+        for (i = V::width; i + V::width <= n; i += V::width)
+        {
+            _acc = V::min(_acc, V::load(p + i));
+        }
+        _result = reduce_min<T>(_acc);
+    }
+    for (; i < n; i++)
+    {
+        _result = p[i] < _result ? p[i] : _result;
+    }
+    return _result;
+}
+
+// n >= 1
+template <typename T>
+T max_value(const T* p, std::size_t n)
+{
+    using V = ops<T>;
+
+    T           _result = p[0];
+    std::size_t i       = 0;
+    if (n >= V::width)
+    {
+        auto _acc = V::load(p);
+        for (i = V::width; i + V::width <= n; i += V::width)
+        {
+            _acc = V::max(_acc, V::load(p + i));
+        }
+        _result = reduce_max<T>(_acc);
+    }
+    for (; i < n; i++)
+    {
+        _result = p[i] > _result ? p[i] : _result;
+    }
+    return _result;
+}
+
+// four independent accumulators hide the add latency
+template <typename T>
+T sum(const T* p, std::size_t n)
+{
+    using V  = ops<T>;
+    auto _a0 = V::zero(), _a1 = V::zero(), _a2 = V::zero(), _a3 = V::zero();
+
+    std::size_t i = 0;
+    for (; i + 4 * V::width <= n; i += 4 * V::width)
+    {
+        _a0 = V::add(_a0, V::load(p + i));
+        _a1 = V::add(_a1, V::load(p + i + V::width));
+        _a2 = V::add(_a2, V::load(p + i + 2 * V::width));
+        _a3 = V::add(_a3, V::load(p + i + 3 * V::width));
+    }
+    auto _acc = V::add(V::add(_a0, _a1), V::add(_a2, _a3));
+    for (; i + V::width <= n; i += V::width)
+    {
+        _acc = V::add(_acc, V::load(p + i));
+    }
+
+    T _result = reduce_sum<T>(_acc);
+    for (; i < n; i++)
+    {
+        _result += p[i];
+    }
+    return _result;
+}
+
+template <typename T>
+T dot(const T* a, const T* b, std::size_t n)
+{
+    using V  = ops<T>;
+    auto _a0 = V::zero(), _a1 = V::zero();
+
+    std::size_t i = 0;
+    for (; i + 2 * V::width <= n; i += 2 * V::width)
+    {
+        _a0 = V::add(_a0, V::mul(V::load(a + i), V::load(b + i)));
+        _a1 = V::add(_a1, V::mul(V::load(a + i + V::width), V::load(b + i + V::width)));
+    }
+    auto _acc = V::add(_a0, _a1);
+    for (; i + V::width <= n; i += V::width)
+    {
+        _acc = V::add(_acc, V::mul(V::load(a + i), V::load(b + i)));
+    }
+
+    T _result = reduce_sum<T>(_acc);
+    for (; i < n; i++)
+    {
+        _result += a[i] * b[i];
+    }
+    return _result;
+}
+
+template <typename T>
+typename ops<T>::reg apply(simd::plus, typename ops<T>::reg a, typename ops<T>::reg b)
+{
+    return ops<T>::add(a, b);
+}
+
+template <typename T>
+typename ops<T>::reg apply(simd::minus, typename ops<T>::reg a, typename ops<T>::reg b)
+{
+    return ops<T>::sub(a, b);
+}
+
+template <typename T>
+typename ops<T>::reg apply(simd::multiplies, typename ops<T>::reg a, typename ops<T>::reg b)
+{
+    return ops<T>::mul(a, b);
+}
+
+// out[i] = op(a[i], b[i]); out may alias a or b
+template <typename T, typename Op>
+void transform(const T* a, const T* b, T* out, std::size_t n, Op op)
+{
+    using V = ops<T>;
+
+    std::size_t i = 0;
+    for (; i + V::width <= n; i += V::width)
+    {
+        V::store(out + i, apply<T>(op, V::load(a + i), V::load(b + i)));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = op(a[i], b[i]);
+    }
+}
@@ -0,0 +1,411 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+#include "m_allocator.h"
+#include "m_memory.h"
+
+namespace m_std
+{
+
+// vector that keeps up to N elements inline and only goes to the allocator past that.
+// growth, move and iterator semantics follow m_std::vector: doubling, relocation via
+// memcpy / move_if_noexcept, raw pointer iterators (invalidated by growth and by moves
+// of an inline small_vector). the rest of the interface takes vector's arguments;
+// insert appends and rotates, so it is meant for short vectors.
+template <typename T, std::size_t N, typename Allocator = allocator<T>>
+class small_vector
+{
+    static_assert(N > 0, "use m_std::vector when no inline storage is wanted");
+
+public:
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using iterator       = T*;
+    using const_iterator = const T*;
+    using size_t         = std::size_t;
+
+    static constexpr size_t inline_capacity = N;
+
+    iterator begin() { return m_data; }
+    iterator end() { return m_data + m_size; }
+
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    template <typename It>
+    using is_forward_iterator = std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>;
+
+    template <typename It>
+    using require_input_iterator = typename std::enable_if<
+        std::is_base_of<std::input_iterator_tag, typename std::iterator_traits<It>::iterator_category>::value>::type;
+
+    T*        m_data;
+    size_t    m_size     = 0;
+    size_t    m_capacity = N;
+    Allocator m_alloc;
+
+    alignas(T) unsigned char m_inline[sizeof(T) * N];
+
+public:
+    ~small_vector()
+    {
+        release();
+    }
+
+    small_vector() :
+        small_vector(Allocator())
+    {
+    }
+
+    explicit small_vector(const Allocator& alloc) :
+        m_data(inline_data()), m_alloc(alloc)
+    {
+    }
+
+    small_vector(size_t size, const T& value, const Allocator& alloc = Allocator()) :
+        small_vector(alloc)
+    {
+        reallocate(size);
+        for (; m_size < size; m_size++)
+        {
+            ::new (m_data + m_size) T(value);
+        }
+    }
+
+    // copy constructor
+    small_vector(const small_vector& other) :
+        small_vector(alloc_traits::select_on_container_copy_construction(other.m_alloc))
+    {
+        reallocate(other.m_size);
+        uninitialized_copy_n(other.m_data, other.m_size, m_data);
+        m_size = other.m_size;
+    }
+
+    // copy assignment
+    small_vector& operator=(const small_vector& other)
+    {
+        if (this != &other)
+        {
+            destroy_n(m_data, m_size);
+            m_size = 0;
+            if (other.m_size > m_capacity)
+            {
+                reallocate(other.m_size);
+            }
+            uninitialized_copy_n(other.m_data, other.m_size, m_data);
+            m_size = other.m_size;
+        }
+        return *this;
+    }
+
+    // move constructor: a heap buffer changes hands, inline elements are relocated
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) :
+        small_vector(std::move(other.m_alloc))
+    {
+        take(other, true);
+    }
+
+    // move assignment
+    small_vector& operator=(small_vector&& other)
+    {
+        if (this != &other)
+        {
+            release();
+            if (alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                m_alloc = std::move(other.m_alloc);
+            }
+            take(other, alloc_traits::propagate_on_container_move_assignment::value || m_alloc == other.m_alloc);
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return m_alloc; }
+
+    bool is_inline() const { return m_data == inline_data(); }
+
+    // bytes owned: the object, inline buffer included, plus any heap buffer
+    size_t memory_usage() const { return sizeof(*this) + (is_inline() ? 0 : m_capacity * sizeof(T)); }
+
+private:
+    T* inline_data() { return reinterpret_cast<T*>(m_inline); }
+
+    const T* inline_data() const { return reinterpret_cast<const T*>(m_inline); }
+
+    // destruct all and fall back to the inline buffer
+    void release()
+    {
+        destroy_n(m_data, m_size);
+        if (!is_inline())
+        {
+            alloc_traits::deallocate(m_alloc, m_data, m_capacity);
+        }
+
+        m_data     = inline_data();
+        m_size     = 0;
+        m_capacity = N;
+    }
+
+    // expects an empty, inline *this
+    void take(small_vector& other, bool can_steal_buffer)
+    {
+        if (!other.is_inline() && can_steal_buffer)
+        {
+            m_data     = other.m_data;
+            m_size     = other.m_size;
+            m_capacity = other.m_capacity;
+        }
+        else
+        {
+            reallocate(other.m_size);
+            for (; m_size < other.m_size; m_size++)
+            {
+                ::new (m_data + m_size) T(std::move(other.m_data[m_size]));
+            }
+            destroy_n(other.m_data, other.m_size);
+            if (!other.is_inline())
+            {
+                alloc_traits::deallocate(other.m_alloc, other.m_data, other.m_capacity);
+            }
+        }
+
+        other.m_data     = other.inline_data();
+        other.m_size     = 0;
+        other.m_capacity = N;
+    }
+
+    template <typename Fn>
+    void resize_impl(size_t count, Fn construct)
+    {
+        if (count <= m_size)
+        {
+            destroy_n(m_data + count, m_size - count);
+            m_size = count;
+            return;
+        }
+
+        if (count > m_capacity)
+        {
+            reallocate(count > m_capacity * 2 ? count : m_capacity * 2);
+        }
+        for (; m_size < count; m_size++)
+        {
+            construct(m_data + m_size);
+        }
+    }
+
+    // grow to at least new_capacity, never shrinks back to inline
+    void reallocate(size_t new_capacity)
+    {
+        if (new_capacity <= m_capacity)
+        {
+            return;
+        }
+
+        if constexpr (is_trivially_relocatable<T>::value && has_reallocate<Allocator>::value)
+        {
+            if (!is_inline())
+            {
+                m_data     = m_alloc.reallocate(m_data, m_capacity, new_capacity);
+                m_capacity = new_capacity;
+                return;
+            }
+        }
+
+        T* new_data = alloc_traits::allocate(m_alloc, new_capacity);
+        try
+        {
+            relocate_n(m_data, m_size, new_data);
+        }
+        catch (...)
+        {
+            alloc_traits::deallocate(m_alloc, new_data, new_capacity);
+            throw;
+        }
+
+        if (!is_inline())
+        {
+            alloc_traits::deallocate(m_alloc, m_data, m_capacity);
+        }
+        m_data     = new_data;
+        m_capacity = new_capacity;
+    }
+
+public:
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool   empty() const { return m_size == 0; }
+
+    T*       data() { return m_data; }
+    const T* data() const { return m_data; }
+
+    T& operator[](size_t index)
+    {
+        if (index >= m_size)
+        {
+            throw std::out_of_range("index out of range");
+        }
+        return m_data[index];
+    }
+
+    const T& operator[](size_t index) const
+    {
+        if (index >= m_size)
+        {
+            throw std::out_of_range("index out of range");
+        }
+        return m_data[index];
+    }
+
+    // capacity management ===========
+
+    // never leaves the heap for the inline buffer again
+    void reserve(size_t new_capacity)
+    {
+        reallocate(new_capacity);
+    }
+
+    void resize(size_t count)
+    {
+        resize_impl(count, [](T* slot) { ::new (slot) T(); });
+    }
+
+    void resize(size_t count, const T& value)
+    {
+        // value may live in our own storage
+        T _value(value);
+        resize_impl(count, [&_value](T* slot) { ::new (slot) T(_value); });
+    }
+
+    // keeps the capacity, a heap buffer included
+    void clear()
+    {
+        destroy_n(m_data, m_size);
+        m_size = 0;
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        T* _slot;
+        if (m_size == m_capacity)
+        {
+            // args may refer into our own storage, build the element before relocating
+            T _tmp(std::forward<Args>(args)...);
+            reallocate(m_capacity * 2);
+            _slot = ::new (m_data + m_size) T(std::move(_tmp));
+        }
+        else
+        {
+            _slot = ::new (m_data + m_size) T(std::forward<Args>(args)...);
+        }
+        m_size++;
+        return *_slot;
+    }
+
+    void pop_back()
+    {
+        if (m_size > 0)
+        {
+            m_data[m_size - 1].~T();
+            m_size--;
+        }
+        else
+        {
+            throw std::out_of_range("pop_back() on empty small_vector");
+        }
+    }
+
+    // the range is appended, then rotated into place. a throw while appending
+    // leaves the elements as they were, one while rotating only their order
+    template <typename InputIt, typename = require_input_iterator<InputIt>>
+    iterator insert(const T* pos, InputIt first, InputIt last)
+    {
+        size_t _index = static_cast<size_t>(pos - m_data);
+        if (_index > m_size)
+        {
+            throw std::out_of_range("insert position out of range");
+        }
+
+        size_t _old_size = m_size;
+        if constexpr (is_forward_iterator<InputIt>::value)
+        {
+            size_t _n = static_cast<size_t>(std::distance(first, last));
+            if (m_size + _n > m_capacity)
+            {
+                reallocate(m_size + _n > m_capacity * 2 ? m_size + _n : m_capacity * 2);
+            }
+        }
+
+        try
+        {
+            for (; first != last; ++first)
+            {
+                emplace_back(*first);
+            }
+        }
+        catch (...)
+        {
+            destroy_n(m_data + _old_size, m_size - _old_size);
+            m_size = _old_size;
+            throw;
+        }
+        std::rotate(m_data + _index, m_data + _old_size, m_data + m_size);
+        return m_data + _index;
+    }
+
+    iterator insert(const T* pos, const T& value)
+    {
+        T _value(value); // value may live in our own storage
+        return insert(pos, std::make_move_iterator(&_value), std::make_move_iterator(&_value + 1));
+    }
+
+    iterator erase(const T* pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    // close the gap with one shift of the tail
+    iterator erase(const T* first, const T* last)
+    {
+        size_t _first = static_cast<size_t>(first - m_data);
+        size_t _last  = static_cast<size_t>(last - m_data);
+        if (_first > _last || _last > m_size)
+        {
+            throw std::out_of_range("erase range out of range");
+        }
+
+        size_t _n = _last - _first;
+        if constexpr (std::is_trivially_copyable<T>::value)
+        {
+            std::memmove(static_cast<void*>(m_data + _first), static_cast<const void*>(m_data + _last), sizeof(T) * (m_size - _last));
+        }
+        else
+        {
+            std::move(m_data + _last, m_data + m_size, m_data + _first);
+            destroy_n(m_data + m_size - _n, _n);
+        }
+        m_size -= _n;
+        return m_data + _first;
+    }
+};
+
+} // namespace m_std
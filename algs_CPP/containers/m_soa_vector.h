@@ -0,0 +1,329 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "m_allocator.h"
+#include "m_pair.h"
+#include "m_span.h"
+#include "m_vector.hpp"
+
+namespace m_std
+{
+
+// how a record splits into columns. a specialization provides
+//   columns            std::tuple of the field types, one column per field
+//   reference          what dereferencing an iterator yields: references into every column
+//   const_reference
+//   get<I>(record)     field I of a record, keeping its value category
+template <typename Record>
+struct soa_traits;
+
+template <typename Key_t, typename Value_t>
+struct soa_traits<pair<Key_t, Value_t>>
+{
+    using columns         = std::tuple<Key_t, Value_t>;
+    using reference       = pair<Key_t&, Value_t&>;
+    using const_reference = pair<const Key_t&, const Value_t&>;
+
+    template <std::size_t I, typename R>
+    static decltype(auto) get(R&& record)
+    {
+        if constexpr (I == 0)
+        {
+            return (std::forward<R>(record).first);
+        }
+        else
+        {
+            return (std::forward<R>(record).second);
+        }
+    }
+};
+
+// structure-of-arrays vector: every field of Record lives in its own contiguous
+// m_std::vector, so a scan over one field only pulls that field through the cache.
+// iterators are proxies: *it is a Record-shaped bundle of references (pair<K&, V&> for
+// pairs), and column<I>() exposes a field as a span for the simd kernels.
+template <typename Record, typename Allocator = allocator<Record>>
+class soa_vector
+{
+    using traits = soa_traits<Record>;
+
+    template <typename T>
+    using column_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+    template <typename Tuple>
+    struct column_storage;
+
+    template <typename... Ts>
+    struct column_storage<std::tuple<Ts...>>
+    {
+        using type = std::tuple<vector<Ts, column_allocator<Ts>>...>;
+
+        static type make(const Allocator& alloc) { return type(column_allocator<Ts>(alloc)...); }
+    };
+
+    using storage_type = column_storage<typename traits::columns>;
+
+public:
+    using value_type      = Record;
+    using reference       = typename traits::reference;
+    using const_reference = typename traits::const_reference;
+    using size_t          = std::size_t;
+
+    static constexpr size_t column_count = std::tuple_size<typename traits::columns>::value;
+
+    template <size_t I>
+    using column_type = typename std::tuple_element<I, typename traits::columns>::type;
+
+    // iterator ===========
+
+    template <bool IsConst>
+    class basic_iterator
+    {
+        using owner_type = typename std::conditional<IsConst, const soa_vector, soa_vector>::type;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = Record;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = typename std::conditional<IsConst, const_reference, typename traits::reference>::type;
+
+        // operator-> needs an address, so the proxy reference is kept alive in here
+        struct pointer
+        {
+            reference ref;
+            reference* operator->() { return &ref; }
+        };
+
+        basic_iterator() = default;
+        basic_iterator(owner_type* owner, size_t index) :
+            m_owner(owner), m_index(index) { }
+
+        // iterator -> const_iterator
+        template <bool OtherConst, typename = typename std::enable_if<IsConst && !OtherConst>::type>
+        basic_iterator(const basic_iterator<OtherConst>& other) :
+            m_owner(other.owner()), m_index(other.index())
+        {
+        }
+
+        reference operator*() const { return m_owner->at_unchecked(m_index); }
+        pointer   operator->() const { return pointer{ **this }; }
+        reference operator[](difference_type n) const { return m_owner->at_unchecked(m_index + n); }
+
+        basic_iterator& operator++()
+        {
+            m_index++;
+            return *this;
+        }
+
+        basic_iterator operator++(int)
+        {
+            basic_iterator _tmp = *this;
+            m_index++;
+            return _tmp;
+        }
+
+        basic_iterator& operator--()
+        {
+            m_index--;
+            return *this;
+        }
+
+        basic_iterator operator--(int)
+        {
+            basic_iterator _tmp = *this;
+            m_index--;
+            return _tmp;
+        }
+
+        basic_iterator& operator+=(difference_type n)
+        {
+            m_index += n;
+            return *this;
+        }
+
+        basic_iterator& operator-=(difference_type n)
+        {
+            m_index -= n;
+            return *this;
+        }
+
+        friend basic_iterator operator+(basic_iterator it, difference_type n) { return it += n; }
+        friend basic_iterator operator+(difference_type n, basic_iterator it) { return it += n; }
+        friend basic_iterator operator-(basic_iterator it, difference_type n) { return it -= n; }
+
+        friend difference_type operator-(const basic_iterator& a, const basic_iterator& b)
+        {
+            return difference_type(a.m_index) - difference_type(b.m_index);
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.m_index == b.m_index; }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return !(a == b); }
+        friend bool operator<(const basic_iterator& a, const basic_iterator& b) { return a.m_index < b.m_index; }
+        friend bool operator>(const basic_iterator& a, const basic_iterator& b) { return b < a; }
+        friend bool operator<=(const basic_iterator& a, const basic_iterator& b) { return !(b < a); }
+        friend bool operator>=(const basic_iterator& a, const basic_iterator& b) { return !(a < b); }
+
+        owner_type* owner() const { return m_owner; }
+        size_t      index() const { return m_index; }
+
+    private:
+        owner_type* m_owner = nullptr;
+        size_t      m_index = 0;
+    };
+
+    using iterator       = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    iterator       begin() { return iterator(this, 0); }
+    iterator       end() { return iterator(this, size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+public:
+    soa_vector() :
+        soa_vector(Allocator())
+    {
+    }
+
+    explicit soa_vector(const Allocator& alloc) :
+        m_columns(storage_type::make(alloc))
+    {
+    }
+
+    size_t size() const { return std::get<0>(m_columns).size(); }
+    bool   empty() const { return size() == 0; }
+
+    // bytes owned: the object plus every column's buffer
+    size_t memory_usage() const
+    {
+        return std::apply([](const auto&... columns) { return sizeof(soa_vector) + ((columns.memory_usage() - sizeof(columns)) + ...); },
+                          m_columns);
+    }
+
+    void reserve(size_t new_capacity)
+    {
+        for_each_column([new_capacity](auto& column) { column.reserve(new_capacity); });
+    }
+
+    void clear()
+    {
+        for_each_column([](auto& column) { column.clear(); });
+    }
+
+    void push_back(const Record& record)
+    {
+        push_back_impl(record, column_indices());
+    }
+
+    void push_back(Record&& record)
+    {
+        push_back_impl(std::move(record), column_indices());
+    }
+
+    // one constructor argument per column, e.g. emplace_back(key, value)
+    template <typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        static_assert(sizeof...(Args) == column_count, "emplace_back takes one argument per column");
+        emplace_back_impl(column_indices(), std::forward<Args>(args)...);
+        return at_unchecked(size() - 1);
+    }
+
+    void pop_back()
+    {
+        if (empty())
+        {
+            throw std::out_of_range("pop_back() on empty soa_vector");
+        }
+        for_each_column([](auto& column) { column.pop_back(); });
+    }
+
+    reference operator[](size_t index)
+    {
+        if (index >= size())
+        {
+            throw std::out_of_range("index out of range");
+        }
+        return at_unchecked(index);
+    }
+
+    const_reference operator[](size_t index) const
+    {
+        if (index >= size())
+        {
+            throw std::out_of_range("index out of range");
+        }
+        return at_unchecked(index);
+    }
+
+    // one field as a contiguous array
+    template <size_t I>
+    span<column_type<I>> column()
+    {
+        return span<column_type<I>>(std::get<I>(m_columns).data(), size());
+    }
+
+    template <size_t I>
+    span<const column_type<I>> column() const
+    {
+        return span<const column_type<I>>(std::get<I>(m_columns).data(), size());
+    }
+
+private:
+    using column_indices = std::make_index_sequence<column_count>;
+
+    template <typename Fn>
+    void for_each_column(Fn fn)
+    {
+        std::apply([&fn](auto&... columns) { (fn(columns), ...); }, m_columns);
+    }
+
+    reference at_unchecked(size_t index)
+    {
+        return at_unchecked_impl<reference>(*this, index, column_indices());
+    }
+
+    const_reference at_unchecked(size_t index) const
+    {
+        return at_unchecked_impl<const_reference>(*this, index, column_indices());
+    }
+
+    template <typename Ref, typename Self, size_t... Is>
+    static Ref at_unchecked_impl(Self& self, size_t index, std::index_sequence<Is...>)
+    {
+        return Ref(std::get<Is>(self.m_columns).data()[index]...);
+    }
+
+    template <typename R, size_t... Is>
+    void push_back_impl(R&& record, std::index_sequence<Is...>)
+    {
+        emplace_back_impl(column_indices(), traits::template get<Is>(std::forward<R>(record))...);
+    }
+
+    // all columns grow or none do
+    template <size_t... Is, typename... Args>
+    void emplace_back_impl(std::index_sequence<Is...>, Args&&... args)
+    {
+        size_t _pushed = 0;
+        try
+        {
+            ((std::get<Is>(m_columns).emplace_back(std::forward<Args>(args)), ++_pushed), ...);
+        }
+        catch (...)
+        {
+            ((Is < _pushed ? std::get<Is>(m_columns).pop_back() : void()), ...);
+            throw;
+        }
+    }
+
+private:
+    typename storage_type::type m_columns;
+};
+
+} // namespace m_std
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+
+namespace m_std
+{
+
+// non-owning view of a contiguous run of T, what a container hands out when callers
+// only need pointer + length (simd kernels, scans)
+template <typename T>
+class span
+{
+public:
+    using value_type = T;
+    using iterator   = T*;
+    using size_t     = std::size_t;
+
+    span() = default;
+    span(T* data, size_t size) :
+        m_data(data), m_size(size) { }
+
+    // span<T> -> span<const T>
+    template <typename U>
+    span(const span<U>& other) :
+        m_data(other.data()), m_size(other.size())
+    {
+    }
+
+    T*     data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+
+    iterator begin() const { return m_data; }
+    iterator end() const { return m_data + m_size; }
+
+    T& operator[](size_t index) const
+    {
+        if (index >= m_size)
+        {
+            throw std::out_of_range("index out of range");
+        }
+        return m_data[index];
+    }
+
+    span subspan(size_t offset, size_t count) const
+    {
+        if (offset > m_size || count > m_size - offset)
+        {
+            throw std::out_of_range("subspan out of range");
+        }
+        return span(m_data + offset, count);
+    }
+
+private:
+    T*     m_data = nullptr;
+    size_t m_size = 0;
+};
+
+} // namespace m_std
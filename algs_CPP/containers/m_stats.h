@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+
+// instrumentation policies. a container takes one as its last template parameter and
+// calls its hooks on copies, moves, allocations, regrows and tree restructuring.
+//
+// no_stats is the default: every hook is an empty inline function and the policy is an
+// empty base, so an uninstrumented container is the same size and code as before.
+// container_stats counts. define M_STD_CONTAINER_STATS before including any container
+// to make it the default for the whole build, or name it for a single container:
+//
+//   m_std::vector<int, m_std::allocator<int>, m_std::container_stats> v;
+//   ...
+//   v.stats().print(std::cerr);
+//
+// counters live in each container instance; a policy with static members can pool them.
+namespace m_std
+{
+
+struct no_stats
+{
+    static constexpr bool enabled = false;
+
+    void on_copy() { }
+    void on_move() { }
+    void on_allocate(std::size_t /*bytes*/) { }
+    void on_deallocate(std::size_t /*bytes*/) { }
+    void on_reallocate() { }
+    void on_rotation() { }
+    void on_shape(std::size_t /*nodes*/, int /*height*/) { }
+};
+
+struct container_stats
+{
+    static constexpr bool enabled = true;
+
+    std::size_t copies          = 0; // container copy construct / assign
+    std::size_t moves           = 0; // container move construct / assign
+    std::size_t allocations     = 0;
+    std::size_t reallocations   = 0; // buffer regrows and shrinks
+    std::size_t bytes_allocated = 0; // total over the lifetime
+    std::size_t bytes_live      = 0;
+    std::size_t bytes_peak      = 0;
+    std::size_t rotations       = 0;
+    std::size_t nodes           = 0;
+    int         height          = -1;
+    int         height_peak     = -1;
+
+    void on_copy() { copies++; }
+    void on_move() { moves++; }
+
+    void on_allocate(std::size_t bytes)
+    {
+        allocations++;
+        bytes_allocated += bytes;
+        bytes_live += bytes;
+        bytes_peak = std::max(bytes_peak, bytes_live);
+    }
+
+    void on_deallocate(std::size_t bytes) { bytes_live -= bytes; }
+    void on_reallocate() { reallocations++; }
+    void on_rotation() { rotations++; }
+
+    void on_shape(std::size_t node_count, int tree_height)
+    {
+        nodes       = node_count;
+        height      = tree_height;
+        height_peak = std::max(height_peak, tree_height);
+    }
+
+    void reset() { *this = container_stats(); }
+
+    void print(std::ostream& os) const
+    {
+        os << "copies " << copies << ", moves " << moves << ", allocations " << allocations << ", reallocations "
+           << reallocations << ", bytes allocated " << bytes_allocated << " (live " << bytes_live << ", peak " << bytes_peak
+           << ")";
+        if (nodes != 0 || rotations != 0)
+        {
+            os << ", nodes " << nodes << ", height " << height << " (peak " << height_peak << "), rotations " << rotations;
+        }
+        os << '\n';
+    }
+};
+
+#if defined(M_STD_CONTAINER_STATS)
+using default_stats = container_stats;
+#else
+using default_stats = no_stats;
+#endif
+
+} // namespace m_std
@@ -0,0 +1,677 @@
+#pragma once
+
+#include "m_allocator.h"
+#include "m_memory.h"
+#include "m_pair.h"
+#include "m_simd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define M_HASH_SSE2 1
+#else
+#    define M_HASH_SSE2 0
+#endif
+
+namespace m_std
+{
+
+namespace detail
+{
+
+// control byte of a slot: a full slot keeps 7 bits of its hash, the free states have the
+// high bit set so one movemask finds them
+constexpr std::int8_t ctrl_empty   = -128;
+constexpr std::int8_t ctrl_pending = -2; // only while rehashing: an element not yet placed
+
+constexpr std::size_t ctrl_width = 16;
+
+// bit i set when byte i of the 16 at ctrl equals tag
+inline std::uint32_t match_tag(const std::int8_t* ctrl, std::int8_t tag)
+{
+#if M_HASH_SSE2
+    __m128i _bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_bytes, _mm_set1_epi8(tag))));
+#else
+    std::uint32_t _mask = 0;
+    for (std::size_t i = 0; i < ctrl_width; i++)
+    {
+        _mask |= std::uint32_t(ctrl[i] == tag) << i;
+    }
+    return _mask;
+#endif
+}
+
+// empty or pending
+inline std::uint32_t match_free(const std::int8_t* ctrl)
+{
+#if M_HASH_SSE2
+    return std::uint32_t(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))));
+#else
+    std::uint32_t _mask = 0;
+    for (std::size_t i = 0; i < ctrl_width; i++)
+    {
+        _mask |= std::uint32_t(ctrl[i] < 0) << i;
+    }
+    return _mask;
+#endif
+}
+
+// std::hash of an integer is the integer; spread it so both the slot and the tag bits vary
+inline std::size_t mix_hash(std::size_t h)
+{
+    std::uint64_t _h = std::uint64_t(h);
+    _h ^= _h >> 32;
+    _h *= 0x9E3779B97F4A7C15ull;
+    _h ^= _h >> 29;
+    return std::size_t(_h);
+}
+
+// walks the slots, skipping the free ones
+template <typename Pair, bool IsConst>
+class hash_iterator
+{
+    using slot_type = typename std::conditional<IsConst, const Pair, Pair>::type;
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Pair;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = slot_type&;
+    using pointer           = slot_type*;
+
+    hash_iterator() = default;
+    hash_iterator(const std::int8_t* ctrl, const std::int8_t* end, slot_type* slot) :
+        m_ctrl(ctrl), m_end(end), m_slot(slot)
+    {
+        skipFree();
+    }
+
+    // iterator -> const_iterator
+    template <bool OtherConst, typename = typename std::enable_if<IsConst && !OtherConst>::type>
+    hash_iterator(const hash_iterator<Pair, OtherConst>& other) :
+        m_ctrl(other.ctrl()), m_end(other.ctrlEnd()), m_slot(other.slot())
+    {
+    }
+
+    const std::int8_t* ctrl() const { return m_ctrl; }
+    const std::int8_t* ctrlEnd() const { return m_end; }
+    slot_type*         slot() const { return m_slot; }
+
+    reference operator*() const { return *m_slot; }
+    pointer   operator->() const { return m_slot; }
+
+    hash_iterator& operator++()
+    {
+        ++m_ctrl;
+        ++m_slot;
+        skipFree();
+        return *this;
+    }
+
+    hash_iterator operator++(int)
+    {
+        hash_iterator _tmp = *this;
+        ++*this;
+        return _tmp;
+    }
+
+    friend bool operator==(const hash_iterator& a, const hash_iterator& b) { return a.m_slot == b.m_slot; }
+    friend bool operator!=(const hash_iterator& a, const hash_iterator& b) { return a.m_slot != b.m_slot; }
+
+private:
+    void skipFree()
+    {
+        while (m_ctrl != m_end && *m_ctrl < 0)
+        {
+            ++m_ctrl;
+            ++m_slot;
+        }
+    }
+
+    const std::int8_t* m_ctrl = nullptr;
+    const std::int8_t* m_end  = nullptr;
+    slot_type*         m_slot = nullptr;
+};
+
+} // namespace detail
+
+// open addressing over one array of pair slots, Swiss-table style: a byte of control per
+// slot holds 7 bits of the key's hash, and a probe compares 16 of them at once (sse2, or
+// a scalar loop), so most misses never touch a slot. probing is linear by slot from the
+// key's home; the control array repeats its first 15 bytes past the end so a 16-byte
+// window can start at any slot.
+//
+// erase shifts the following run back over the hole instead of leaving a tombstone, so
+// lookups never slow down under churn. growth reallocates the arrays in place (realloc
+// for trivially relocatable pairs) and moves every element to its new home within them,
+// without a second table. the load factor stays under 7/8.
+//
+// iterators and references are invalidated by every insert that grows and every erase
+template <typename Key_t, typename Value_t, typename Hash = std::hash<Key_t>, typename KeyEqual = std::equal_to<Key_t>>
+class unordered_map
+{
+public:
+    using key_type       = Key_t;
+    using mapped_type    = Value_t;
+    using hasher         = Hash;
+    using key_equal      = KeyEqual;
+    using pair_type      = pair<Key_t, Value_t>;
+    using iterator       = detail::hash_iterator<pair_type, false>;
+    using const_iterator = detail::hash_iterator<pair_type, true>;
+
+private:
+    // heterogeneous lookup needs both Hash and KeyEqual to opt in
+    template <typename K>
+    using if_transparent = typename std::enable_if<detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value &&
+                                                   !std::is_same<K, Key_t>::value &&
+                                                   !std::is_convertible<const K&, const_iterator>::value>::type;
+
+public:
+    unordered_map() = default;
+
+    explicit unordered_map(std::size_t expected, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual()) :
+        m_hash(hash), m_equal(equal)
+    {
+        reserve(expected);
+    }
+
+    unordered_map(const unordered_map& other) :
+        m_hash(other.m_hash), m_equal(other.m_equal)
+    {
+        if (other.m_capacity == 0)
+        {
+            return;
+        }
+        m_ctrl = m_ctrl_alloc.allocate(ctrlBytes(other.m_capacity));
+        try
+        {
+            m_slots = m_slot_alloc.allocate(other.m_capacity);
+        }
+        catch (...)
+        {
+            m_ctrl_alloc.deallocate(m_ctrl, ctrlBytes(other.m_capacity));
+            throw;
+        }
+        std::memcpy(m_ctrl, other.m_ctrl, ctrlBytes(other.m_capacity));
+        m_capacity = other.m_capacity;
+        std::size_t i = 0;
+        try
+        {
+            for (; i < m_capacity; i++)
+            {
+                if (m_ctrl[i] >= 0)
+                {
+                    ::new (m_slots + i) pair_type(other.m_slots[i]);
+                }
+            }
+        }
+        catch (...)
+        {
+            // slots from i on were never built
+            for (std::size_t j = i; j < m_capacity; j++)
+            {
+                m_ctrl[j] = detail::ctrl_empty;
+            }
+            destroyAll();
+            throw;
+        }
+        m_size = other.m_size;
+    }
+
+    unordered_map(unordered_map&& other) noexcept :
+        m_hash(std::move(other.m_hash)), m_equal(std::move(other.m_equal))
+    {
+        swapStorage(other);
+    }
+
+    unordered_map& operator=(const unordered_map& other)
+    {
+        if (this != &other)
+        {
+            unordered_map _copy(other);
+            swap(_copy);
+        }
+        return *this;
+    }
+
+    unordered_map& operator=(unordered_map&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroyAll();
+            m_hash  = std::move(other.m_hash);
+            m_equal = std::move(other.m_equal);
+            swapStorage(other);
+        }
+        return *this;
+    }
+
+    ~unordered_map() { destroyAll(); }
+
+    void swap(unordered_map& other) noexcept
+    {
+        using std::swap;
+        swap(m_hash, other.m_hash);
+        swap(m_equal, other.m_equal);
+        swapStorage(other);
+    }
+
+    std::size_t size() const { return m_size; }
+    bool        empty() const { return m_size == 0; }
+    std::size_t capacity() const { return m_capacity; }
+    float       load_factor() const { return m_capacity == 0 ? 0.0f : float(m_size) / float(m_capacity); }
+
+    const Hash&     hash_function() const { return m_hash; }
+    const KeyEqual& key_eq() const { return m_equal; }
+
+    // bytes owned by this map: the object, the slots and the control bytes
+    std::size_t memory_usage() const
+    {
+        return sizeof(*this) + (m_capacity == 0 ? 0 : m_capacity * sizeof(pair_type) + ctrlBytes(m_capacity));
+    }
+
+    // room for count elements without another rehash: one growth up front instead of
+    // a doubling every time the load crosses 7/8
+    void reserve(std::size_t count)
+    {
+        std::size_t _capacity = m_capacity == 0 ? min_capacity : m_capacity;
+        while (maxLoad(_capacity) < count)
+        {
+            _capacity *= 2;
+        }
+        if (_capacity > m_capacity)
+        {
+            rehashTo(_capacity);
+        }
+    }
+
+    // destroys every element, keeps the slots
+    void clear()
+    {
+        destroyElements();
+        if (m_capacity != 0)
+        {
+            std::memset(m_ctrl, detail::ctrl_empty, ctrlBytes(m_capacity));
+        }
+        m_size = 0;
+    }
+
+    // insert ===========
+
+    // does nothing if the key is already there; returns where it is and whether it was added
+    std::pair<iterator, bool> insert(const Key_t& key, const Value_t& value) { return emplaceKey(key, value); }
+    std::pair<iterator, bool> insert(Key_t&& key, Value_t&& value) { return emplaceKey(std::move(key), std::move(value)); }
+
+    // builds the value from args only when the key is new
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key_t& key, Args&&... args)
+    {
+        return emplaceKey(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(Key_t&& key, Args&&... args)
+    {
+        return emplaceKey(std::move(key), std::forward<Args>(args)...);
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key_t& key, V&& value)
+    {
+        auto _result = emplaceKey(key, std::forward<V>(value));
+        if (!_result.second)
+        {
+            _result.first->second = std::forward<V>(value);
+        }
+        return _result;
+    }
+
+    Value_t& operator[](const Key_t& key) { return emplaceKey(key).first->second; }
+    Value_t& operator[](Key_t&& key) { return emplaceKey(std::move(key)).first->second; }
+
+    // lookup ===========
+
+    // with a transparent Hash and KeyEqual, any K they accept finds without building a
+    // Key_t, e.g. a std::string_view into a map of std::string. Hash must give K and the
+    // equal Key_t the same hash
+    iterator find(const Key_t& key) { return iteratorAt(findSlot(key)); }
+    const_iterator find(const Key_t& key) const { return iteratorAt(findSlot(key)); }
+
+    template <typename K, typename = if_transparent<K>>
+    iterator find(const K& key)
+    {
+        return iteratorAt(findSlot(key));
+    }
+
+    template <typename K, typename = if_transparent<K>>
+    const_iterator find(const K& key) const
+    {
+        return iteratorAt(findSlot(key));
+    }
+
+    bool        contains(const Key_t& key) const { return findSlot(key) != npos; }
+    std::size_t count(const Key_t& key) const { return contains(key) ? 1 : 0; }
+
+    template <typename K, typename = if_transparent<K>>
+    bool contains(const K& key) const
+    {
+        return findSlot(key) != npos;
+    }
+
+    // erase ===========
+
+    // returns how many were removed, 0 or 1
+    std::size_t erase(const Key_t& key) { return eraseKey(key); }
+
+    template <typename K, typename = if_transparent<K>>
+    std::size_t erase(const K& key)
+    {
+        return eraseKey(key);
+    }
+
+    // the elements after pos may move, so this hands back no iterator
+    void erase(const_iterator pos) { eraseSlot(std::size_t(pos.slot() - m_slots)); }
+
+    // iteration, in no particular order ===========
+
+    iterator       begin() { return iterator(m_ctrl, m_ctrl + m_capacity, m_slots); }
+    iterator       end() { return iterator(m_ctrl + m_capacity, m_ctrl + m_capacity, m_slots + m_capacity); }
+    const_iterator begin() const { return const_iterator(m_ctrl, m_ctrl + m_capacity, m_slots); }
+    const_iterator end() const { return const_iterator(m_ctrl + m_capacity, m_ctrl + m_capacity, m_slots + m_capacity); }
+
+private:
+    static constexpr std::size_t npos         = std::size_t(-1);
+    static constexpr std::size_t min_capacity = 16;
+
+    static std::size_t maxLoad(std::size_t capacity) { return capacity - capacity / 8; }
+    static std::size_t ctrlBytes(std::size_t capacity) { return capacity + detail::ctrl_width - 1; }
+
+    // the low 7 bits tag the slot, the rest pick the home
+    template <typename K>
+    std::size_t hashOf(const K& key) const
+    {
+        return detail::mix_hash(m_hash(key));
+    }
+
+    std::size_t  homeOf(std::size_t h) const { return (h >> 7) & (m_capacity - 1); }
+    static std::int8_t tagOf(std::size_t h) { return std::int8_t(h & 0x7F); }
+
+    // the mirror keeps a window that runs past the last slot reading the first ones
+    void setCtrl(std::size_t i, std::int8_t ctrl)
+    {
+        m_ctrl[i] = ctrl;
+        if (i < detail::ctrl_width - 1)
+        {
+            m_ctrl[m_capacity + i] = ctrl;
+        }
+    }
+
+    iterator iteratorAt(std::size_t i)
+    {
+        return i == npos ? end() : iterator(m_ctrl + i, m_ctrl + m_capacity, m_slots + i);
+    }
+
+    const_iterator iteratorAt(std::size_t i) const
+    {
+        return i == npos ? end() : const_iterator(m_ctrl + i, m_ctrl + m_capacity, m_slots + i);
+    }
+
+    // every slot from an element's home up to the element is full, so the first window
+    // with an empty byte ends the search
+    template <typename K>
+    std::size_t findSlot(const K& key) const
+    {
+        if (m_capacity == 0)
+        {
+            return npos;
+        }
+        std::size_t _h    = hashOf(key);
+        std::size_t _mask = m_capacity - 1;
+        std::size_t _pos  = homeOf(_h);
+        for (;;)
+        {
+            const std::int8_t* _window = m_ctrl + _pos;
+            for (std::uint32_t _match = detail::match_tag(_window, tagOf(_h)); _match != 0; _match &= _match - 1)
+            {
+                std::size_t _i = (_pos + simd::detail::count_trailing_zeros(_match)) & _mask;
+                if (m_equal(m_slots[_i].first, key))
+                {
+                    return _i;
+                }
+            }
+            if (detail::match_tag(_window, detail::ctrl_empty) != 0)
+            {
+                return npos;
+            }
+            _pos = (_pos + detail::ctrl_width) & _mask;
+        }
+    }
+
+    // the first empty (or, while rehashing, pending) slot from the home on
+    std::size_t firstFree(std::size_t h) const
+    {
+        std::size_t _mask = m_capacity - 1;
+        std::size_t _pos  = homeOf(h);
+        for (;;)
+        {
+            std::uint32_t _free = detail::match_free(m_ctrl + _pos);
+            if (_free != 0)
+            {
+                return (_pos + simd::detail::count_trailing_zeros(_free)) & _mask;
+            }
+            _pos = (_pos + detail::ctrl_width) & _mask;
+        }
+    }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplaceKey(K&& key, Args&&... args)
+    {
+        std::size_t _i = findSlot(key);
+        if (_i != npos)
+        {
+            return { iteratorAt(_i), false };
+        }
+        if (m_size >= maxLoad(m_capacity))
+        {
+            rehashTo(m_capacity == 0 ? min_capacity : m_capacity * 2);
+        }
+        std::size_t _h = hashOf(key);
+        _i             = firstFree(_h);
+        ::new (m_slots + _i) pair_type(std::piecewise_construct, std::forward<K>(key), std::forward<Args>(args)...);
+        setCtrl(_i, tagOf(_h));
+        m_size++;
+        return { iteratorAt(_i), true };
+    }
+
+    template <typename K>
+    std::size_t eraseKey(const K& key)
+    {
+        std::size_t _i = findSlot(key);
+        if (_i == npos)
+        {
+            return 0;
+        }
+        eraseSlot(_i);
+        return 1;
+    }
+
+    // backward shift: walk the run after the hole and pull back every element whose
+    // probe path crosses the hole; the hole ends where the run does
+    void eraseSlot(std::size_t i)
+    {
+        std::size_t _mask = m_capacity - 1;
+        std::size_t _hole = i;
+        m_slots[_hole].~pair_type();
+        for (std::size_t _j = (i + 1) & _mask; m_ctrl[_j] != detail::ctrl_empty; _j = (_j + 1) & _mask)
+        {
+            std::size_t _home = homeOf(hashOf(m_slots[_j].first));
+            if (((_j - _home) & _mask) >= ((_j - _hole) & _mask))
+            {
+                ::new (m_slots + _hole) pair_type(std::move(m_slots[_j]));
+                m_slots[_j].~pair_type();
+                setCtrl(_hole, m_ctrl[_j]);
+                _hole = _j;
+            }
+        }
+        setCtrl(_hole, detail::ctrl_empty);
+        m_size--;
+    }
+
+    // grows both arrays keeping every element at its index, marks the elements pending and
+    // places them one by one: an element goes to the first free slot of its probe path,
+    // and if another pending element sits there the two swap and the displaced one goes
+    // next. a placed element only ever has full slots before it on its path
+    void rehashTo(std::size_t capacity)
+    {
+        // both buffers exist before either is committed, a throw leaves the old table
+        std::size_t  _old  = m_capacity;
+        std::int8_t* _ctrl = m_ctrl_alloc.allocate(ctrlBytes(capacity));
+        try
+        {
+            growSlots(capacity);
+        }
+        catch (...)
+        {
+            m_ctrl_alloc.deallocate(_ctrl, ctrlBytes(capacity));
+            throw;
+        }
+
+        for (std::size_t i = 0; i < _old; i++)
+        {
+            _ctrl[i] = m_ctrl[i] >= 0 ? detail::ctrl_pending : detail::ctrl_empty;
+        }
+        if (_old != 0)
+        {
+            m_ctrl_alloc.deallocate(m_ctrl, ctrlBytes(_old));
+        }
+        std::memset(_ctrl + _old, detail::ctrl_empty, ctrlBytes(capacity) - _old);
+        std::memcpy(_ctrl + capacity, _ctrl, detail::ctrl_width - 1);
+        m_ctrl     = _ctrl;
+        m_capacity = capacity;
+
+        for (std::size_t i = 0; i < _old; i++)
+        {
+            while (m_ctrl[i] == detail::ctrl_pending)
+            {
+                std::size_t _h      = hashOf(m_slots[i].first);
+                std::size_t _target = firstFree(_h);
+                if (_target == i)
+                {
+                    setCtrl(i, tagOf(_h));
+                }
+                else if (m_ctrl[_target] == detail::ctrl_empty)
+                {
+                    ::new (m_slots + _target) pair_type(std::move(m_slots[i]));
+                    m_slots[i].~pair_type();
+                    setCtrl(_target, tagOf(_h));
+                    setCtrl(i, detail::ctrl_empty);
+                }
+                else
+                {
+                    using std::swap;
+                    swap(m_slots[i], m_slots[_target]);
+                    setCtrl(_target, tagOf(_h));
+                }
+            }
+        }
+    }
+
+    // the slots grow in place when realloc can move the pairs' bytes, otherwise every
+    // element is moved across to the same index of a new block
+    void growSlots(std::size_t capacity)
+    {
+        if (m_slots == nullptr)
+        {
+            m_slots = m_slot_alloc.allocate(capacity);
+            return;
+        }
+        if constexpr (is_trivially_relocatable<pair_type>::value)
+        {
+            m_slots = m_slot_alloc.reallocate(m_slots, m_capacity, capacity);
+        }
+        else
+        {
+            pair_type*  _slots = m_slot_alloc.allocate(capacity);
+            std::size_t i      = 0;
+            try
+            {
+                for (; i < m_capacity; i++)
+                {
+                    if (m_ctrl[i] >= 0)
+                    {
+                        ::new (_slots + i) pair_type(std::move_if_noexcept(m_slots[i]));
+                    }
+                }
+            }
+            catch (...)
+            {
+                for (std::size_t j = 0; j < i; j++)
+                {
+                    if (m_ctrl[j] >= 0)
+                    {
+                        _slots[j].~pair_type();
+                    }
+                }
+                m_slot_alloc.deallocate(_slots, capacity);
+                throw;
+            }
+            destroyElements();
+            m_slot_alloc.deallocate(m_slots, m_capacity);
+            m_slots = _slots;
+        }
+    }
+
+    void destroyElements()
+    {
+        if constexpr (!std::is_trivially_destructible<pair_type>::value)
+        {
+            for (std::size_t i = 0; i < m_capacity; i++)
+            {
+                if (m_ctrl[i] >= 0)
+                {
+                    m_slots[i].~pair_type();
+                }
+            }
+        }
+    }
+
+    void destroyAll()
+    {
+        if (m_capacity != 0)
+        {
+            destroyElements();
+            m_slot_alloc.deallocate(m_slots, m_capacity);
+            m_ctrl_alloc.deallocate(m_ctrl, ctrlBytes(m_capacity));
+        }
+        m_slots    = nullptr;
+        m_ctrl     = nullptr;
+        m_capacity = 0;
+        m_size     = 0;
+    }
+
+    void swapStorage(unordered_map& other) noexcept
+    {
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+    }
+
+    Hash                     m_hash  = Hash();
+    KeyEqual                 m_equal = KeyEqual();
+    allocator<pair_type>     m_slot_alloc;
+    allocator<std::int8_t>   m_ctrl_alloc;
+    pair_type*               m_slots    = nullptr;
+    std::int8_t*             m_ctrl     = nullptr;
+    std::size_t              m_capacity = 0;
+    std::size_t              m_size     = 0;
+};
+
+} // namespace m_std
@@ -1,80 +1,100 @@
+#pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 
-#include <iostream>
+#include "m_allocator.h"
+#include "m_memory.h"
+#include "m_stats.h"
 // allocator is exception safe ,but we use placement new ;
 
 namespace m_std
 {
 
-template <typename T>
-class vector
+// Stats is an instrumentation policy (m_stats.h), a no-op unless asked for
+template <typename T, typename Allocator = allocator<T>, typename Stats = default_stats>
+class vector : private Stats
 {
 public:
-    using value_type = T;
-    using iterator   = T*;
-    using size_t     = std::size_t;
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using stats_type     = Stats;
+    using iterator       = T*;
+    using size_t         = std::size_t;
 
     iterator begin() { return m_data; }
     iterator end() { return m_data + m_size; }
 
 private:
-    T*     m_data     = nullptr;
-    size_t m_size     = 0;
-    size_t m_capacity = 0;
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    template <typename It>
+    using is_forward_iterator = std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>;
+
+    template <typename It>
+    using require_input_iterator = typename std::enable_if<
+        std::is_base_of<std::input_iterator_tag, typename std::iterator_traits<It>::iterator_category>::value>::type;
+
+    T*        m_data     = nullptr;
+    size_t    m_size     = 0;
+    size_t    m_capacity = 0;
+    Allocator m_alloc;
 
 public:
     ~vector()
     {
-        for (size_t i = 0; i < m_size; i++)
-        {
-            m_data[i].~T();
-        }
-        ::operator delete(m_data);
-
-        std::cout << "destructor called" << std::endl;
+        release();
     }
-    vector()
+    vector() :
+        vector(Allocator())
     {
-        // initial capacity with ,say 4
-        resize(4);
     }
 
-    vector(size_t size)
+    // no allocation until the first push_back
+    explicit vector(const Allocator& alloc) :
+        m_alloc(alloc)
     {
-        m_size     = size;
+    }
+
+    vector(size_t size, const Allocator& alloc = Allocator()) :
+        m_alloc(alloc)
+    {
+        m_data     = allocate(size);
         m_capacity = size;
-        m_data     = (T*)::operator new(sizeof(T) * m_capacity);
-        for (size_t i = 0; i < m_size; i++)
+        for (; m_size < size; m_size++)
         {
-            new (m_data + i) T();
+            new (m_data + m_size) T();
         }
     }
 
-    vector(size_t size, const T& value)
+    vector(size_t size, const T& value, const Allocator& alloc = Allocator()) :
+        m_alloc(alloc)
     {
-        m_size     = size;
+        m_data     = allocate(size);
         m_capacity = size;
-        m_data     = (T*)::operator new(sizeof(T) * m_capacity);
-        for (size_t i = 0; i < m_size; i++)
+        for (; m_size < size; m_size++)
         {
-            new (m_data + i) T(value);
+            new (m_data + m_size) T(value);
         }
     }
 
-    // copy constructor
-    vector(const vector& other)
+    // one allocation for forward ranges
+    template <typename InputIt, typename = require_input_iterator<InputIt>>
+    vector(InputIt first, InputIt last, const Allocator& alloc = Allocator()) :
+        m_alloc(alloc)
     {
-        m_size     = other.m_size;
-        m_capacity = other.m_capacity;
-        m_data     = (T*)::operator new(sizeof(T) * m_capacity);
-        for (size_t i = 0; i < m_size; i++)
-        {
-            new (m_data + i) T(other.m_data[i]); // construct
-        }
+        assign(first, last);
+    }
 
-        std::cout << "copy constructor called" << std::endl;
+    // copy constructor
+    vector(const vector& other) :
+        m_alloc(alloc_traits::select_on_container_copy_construction(other.m_alloc))
+    {
+        copy_from(other);
+        stats_ref().on_copy();
     }
 
     // copy assignment
@@ -82,85 +102,188 @@ public:
     {
         if (this != &other) // self assignment
         {
-            for (size_t i = 0; i < m_size; i++)
+            if (alloc_traits::propagate_on_container_copy_assignment::value && m_alloc != other.m_alloc)
             {
-                m_data[i].~T(); // destruct
+                release();
+                m_alloc = other.m_alloc;
+                copy_from(other);
             }
-            ::operator delete(m_data);
-
-            m_size     = other.m_size;
-            m_capacity = other.m_capacity;
-            m_data     = (T*)::operator new(sizeof(T) * m_capacity);
-            for (size_t i = 0; i < m_size; i++)
+            else if (other.m_size <= m_capacity)
+            {
+                // reuse the buffer we already own
+                destroy_n(m_data, m_size);
+                m_size = 0;
+                uninitialized_copy_n(other.m_data, other.m_size, m_data);
+                m_size = other.m_size;
+            }
+            else
             {
-                ::new (m_data + i) T(other.m_data[i]); // construct
+                release();
+                copy_from(other);
             }
         }
 
-        std::cout << "copy assignment called" << std::endl;
+        stats_ref().on_copy();
         return *this;
     }
 
     // move constructor
-    vector(vector&& other) noexcept
+    vector(vector&& other) noexcept :
+        m_alloc(std::move(other.m_alloc))
     {
-        m_size           = other.m_size;
-        m_capacity       = other.m_capacity;
-        m_data           = other.m_data;
-        other.m_data     = nullptr;
-        other.m_size     = 0;
-        other.m_capacity = 0;
-
-        std::cout << "move constructor called" << std::endl;
+        steal(other);
+        stats_ref().on_move();
     }
 
     // move assignment
-    vector& operator=(vector&& other) noexcept
+    vector& operator=(vector&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value
+                                               || alloc_traits::is_always_equal::value)
     {
         if (this == &other) // self assignment
         {
             return *this;
         }
-        for (size_t i = 0; i < m_size; i++)
+        release();
+
+        if (alloc_traits::propagate_on_container_move_assignment::value)
+        {
+            m_alloc = std::move(other.m_alloc);
+            steal(other);
+        }
+        else if (m_alloc == other.m_alloc)
+        {
+            steal(other);
+        }
+        else
+        {
+            // different arenas: the buffer can't change hands, move element-wise
+            m_data     = allocate(other.m_size);
+            m_capacity = other.m_size;
+            for (; m_size < other.m_size; m_size++)
+            {
+                ::new (m_data + m_size) T(std::move(other.m_data[m_size]));
+            }
+        }
+
+        stats_ref().on_move();
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return m_alloc; }
+
+    const Stats& stats() const { return *this; }
+
+    // bytes owned by this vector: the object plus its whole buffer
+    size_t memory_usage() const { return sizeof(*this) + m_capacity * sizeof(T); }
+
+private:
+    Stats& stats_ref() { return *this; }
+
+    T* allocate(size_t n)
+    {
+        if (n == 0)
+        {
+            return nullptr;
+        }
+        T* _p = alloc_traits::allocate(m_alloc, n);
+        stats_ref().on_allocate(n * sizeof(T));
+        return _p;
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if (p != nullptr)
         {
-            m_data[i].~T(); // destruct
+            alloc_traits::deallocate(m_alloc, p, n);
+            stats_ref().on_deallocate(n * sizeof(T));
         }
-        ::operator delete(m_data);
+    }
+
+    // destruct all and give the buffer back, leaves an empty vector
+    void release()
+    {
+        destroy_n(m_data, m_size);
+        deallocate(m_data, m_capacity);
+
+        m_data     = nullptr;
+        m_size     = 0;
+        m_capacity = 0;
+    }
+
+    // expects an empty vector with no buffer
+    void copy_from(const vector& other)
+    {
+        m_data     = allocate(other.m_capacity);
+        m_capacity = other.m_capacity;
+        uninitialized_copy_n(other.m_data, other.m_size, m_data); // bulk memcpy for trivial types
+        m_size = other.m_size;
+    }
 
+    void steal(vector& other) noexcept
+    {
         m_size           = other.m_size;
         m_capacity       = other.m_capacity;
         m_data           = other.m_data;
         other.m_data     = nullptr;
         other.m_size     = 0;
         other.m_capacity = 0;
+    }
 
-        std::cout << "move assignment called" << std::endl;
-        return *this;
+    // initial capacity with ,say 4, then doubling
+    size_t grown_capacity() const
+    {
+        return m_capacity == 0 ? 4 : m_capacity * 2;
     }
 
-private:
-    void resize(size_t new_capacity)
+    void reallocate(size_t new_capacity)
     {
-        T* new_data = (T*)::operator new(sizeof(T) * new_capacity);
+        if (m_data != nullptr)
+        {
+            stats_ref().on_reallocate();
+        }
 
         // case when it's a shrink
         if (new_capacity < m_size)
         {
             // destruct the elements that are truncated
-            for (size_t i = new_capacity; i < m_size; i++)
+            destroy_n(m_data + new_capacity, m_size - new_capacity);
+            m_size = new_capacity;
+        }
+
+        if constexpr (is_trivially_relocatable<T>::value && has_reallocate<Allocator>::value)
+        {
+            // the allocator moves the bytes itself, in place when it can
+            if (new_capacity == 0)
             {
-                m_data[i].~T();
+                deallocate(m_data, m_capacity);
+                m_data = nullptr;
             }
-            m_size = new_capacity;
+            else if (m_data == nullptr)
+            {
+                m_data = allocate(new_capacity);
+            }
+            else
+            {
+                m_data = m_alloc.reallocate(m_data, m_capacity, new_capacity);
+                stats_ref().on_deallocate(m_capacity * sizeof(T));
+                stats_ref().on_allocate(new_capacity * sizeof(T));
+            }
+            m_capacity = new_capacity;
+            return;
         }
 
-        for (size_t i = 0; i < m_size; i++)
+        T* new_data = allocate(new_capacity);
+        try
+        {
+            relocate_n(m_data, m_size, new_data); // memcpy or move_if_noexcept
+        }
+        catch (...)
         {
-            ::new (new_data + i) T(std::move(m_data[i])); // move construct
-            m_data[i].~T();
+            deallocate(new_data, new_capacity);
+            throw;
         }
 
-        ::operator delete(m_data);
+        deallocate(m_data, m_capacity);
 
         m_data     = new_data;
         m_capacity = new_capacity;
@@ -171,6 +294,12 @@ public:
     size_t capacity() const { return m_capacity; }
     bool   empty() const { return m_size == 0; }
 
+    T*       data() { return m_data; }
+    const T* data() const { return m_data; }
+
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+
     T& operator[](size_t index)
     {
         if (index >= m_size)
@@ -179,34 +308,82 @@ public:
         }
         return m_data[index];
     }
-    void push_back(const T& value)
+
+    const T& operator[](size_t index) const
     {
-        if (m_size == m_capacity)
+        if (index >= m_size)
         {
-            resize(m_capacity * 2);
+            throw std::out_of_range("index out of range");
         }
-        ::new (m_data + m_size) T(value); // dont use assignment for unconstruted memory
-        m_size++;
+        return m_data[index];
     }
 
-    void push_back(T&& value) // move semantics for optimization
+    // capacity management ===========
+
+    void reserve(size_t new_capacity)
     {
-        if (m_size == m_capacity)
+        if (new_capacity > m_capacity)
         {
-            resize(m_capacity * 2);
+            reallocate(new_capacity);
         }
-        ::new (m_data + m_size) T(std::move(value)); // move construct
-        m_size++;
     }
 
-    void emplace_back(T&& value)
+    void shrink_to_fit()
+    {
+        if (m_capacity > m_size)
+        {
+            reallocate(m_size);
+        }
+    }
+
+    void resize(size_t count)
+    {
+        resize_impl(count, [](T* slot) { ::new (slot) T(); });
+    }
+
+    void resize(size_t count, const T& value)
+    {
+        // value may live in our own storage
+        T _value(value);
+        resize_impl(count, [&_value](T* slot) { ::new (slot) T(_value); });
+    }
+
+    void clear()
+    {
+        destroy_n(m_data, m_size);
+        m_size = 0;
+    }
+
+    // single element ===========
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) // move semantics for optimization
     {
+        emplace_back(std::move(value));
+    }
+
+    // construct in place from the arguments, no temporary unless we must regrow
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        T* _slot;
         if (m_size == m_capacity)
         {
-            resize(m_capacity * 2);
+            // args may refer into our own storage, build the element before relocating
+            T _tmp(std::forward<Args>(args)...);
+            reallocate(grown_capacity());
+            _slot = ::new (m_data + m_size) T(std::move(_tmp)); // dont use assignment for unconstruted memory
+        }
+        else
+        {
+            _slot = ::new (m_data + m_size) T(std::forward<Args>(args)...);
         }
-        ::new (m_data + m_size) T(std::move(value)); // move construct
         m_size++;
+        return *_slot;
     }
 
     void pop_back()
@@ -221,6 +398,279 @@ public:
             throw std::out_of_range("pop_back() on empty vector");
         }
     }
+
+    // ranges ===========
+    // forward ranges are measured first so that we allocate at most once
+
+    template <typename InputIt, typename = require_input_iterator<InputIt>>
+    void assign(InputIt first, InputIt last)
+    {
+        if constexpr (is_forward_iterator<InputIt>::value)
+        {
+            size_t _n = static_cast<size_t>(std::distance(first, last));
+            clear();
+            if (_n > m_capacity)
+            {
+                // nothing to keep, so no point relocating: drop the buffer and take an exact one
+                deallocate(m_data, m_capacity);
+                m_data     = nullptr;
+                m_capacity = 0;
+
+                m_data     = allocate(_n);
+                m_capacity = _n;
+            }
+            construct_range(first, _n, m_data);
+            m_size = _n;
+        }
+        else
+        {
+            clear();
+            for (; first != last; ++first)
+            {
+                emplace_back(*first);
+            }
+        }
+    }
+
+    template <typename InputIt, typename = require_input_iterator<InputIt>>
+    void append(InputIt first, InputIt last)
+    {
+        insert(end(), first, last);
+    }
+
+    template <typename InputIt, typename = require_input_iterator<InputIt>>
+    iterator insert(const T* pos, InputIt first, InputIt last)
+    {
+        size_t _index = static_cast<size_t>(pos - m_data);
+        if (_index > m_size)
+        {
+            throw std::out_of_range("insert position out of range");
+        }
+
+        if constexpr (!is_forward_iterator<InputIt>::value)
+        {
+            // single pass: collect first, then it's a forward range
+            vector _buffer(m_alloc);
+            for (; first != last; ++first)
+            {
+                _buffer.emplace_back(*first);
+            }
+            return insert(m_data + _index, std::make_move_iterator(_buffer.begin()), std::make_move_iterator(_buffer.end()));
+        }
+        else
+        {
+            size_t _n = static_cast<size_t>(std::distance(first, last));
+            if (_n == 0)
+            {
+                return m_data + _index;
+            }
+
+            if (m_size + _n > m_capacity)
+            {
+                insert_reallocating(_index, first, _n);
+            }
+            else
+            {
+                insert_in_place(_index, first, _n);
+            }
+            return m_data + _index;
+        }
+    }
+
+    iterator insert(const T* pos, const T& value)
+    {
+        T _value(value); // value may live in our own storage
+        return insert(pos, std::make_move_iterator(&_value), std::make_move_iterator(&_value + 1));
+    }
+
+    iterator erase(const T* pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    // close the gap with one shift of the tail
+    iterator erase(const T* first, const T* last)
+    {
+        size_t _first = static_cast<size_t>(first - m_data);
+        size_t _last  = static_cast<size_t>(last - m_data);
+        if (_first > _last || _last > m_size)
+        {
+            throw std::out_of_range("erase range out of range");
+        }
+
+        size_t _n = _last - _first;
+        if (_n == 0)
+        {
+            return m_data + _first;
+        }
+
+        if constexpr (std::is_trivially_copyable<T>::value)
+        {
+            std::memmove(static_cast<void*>(m_data + _first), static_cast<const void*>(m_data + _last), sizeof(T) * (m_size - _last));
+        }
+        else
+        {
+            std::move(m_data + _last, m_data + m_size, m_data + _first);
+            destroy_n(m_data + m_size - _n, _n);
+        }
+        m_size -= _n;
+        return m_data + _first;
+    }
+
+private:
+    template <typename ForwardIt>
+    static void construct_range(ForwardIt first, size_t n, T* dest)
+    {
+        if constexpr (std::is_pointer<ForwardIt>::value
+                      && std::is_same<typename std::remove_cv<typename std::remove_pointer<ForwardIt>::type>::type, T>::value)
+        {
+            uninitialized_copy_n(first, n, dest); // memcpy for trivial types
+        }
+        else
+        {
+            size_t i = 0;
+            try
+            {
+                for (; i < n; ++i, ++first)
+                {
+                    ::new (dest + i) T(*first);
+                }
+            }
+            catch (...)
+            {
+                destroy_n(dest, i);
+                throw;
+            }
+        }
+    }
+
+    template <typename Fn>
+    void resize_impl(size_t count, Fn construct)
+    {
+        if (count <= m_size)
+        {
+            destroy_n(m_data + count, m_size - count);
+            m_size = count;
+            return;
+        }
+
+        if (count > m_capacity)
+        {
+            size_t _grown = grown_capacity();
+            reallocate(count > _grown ? count : _grown);
+        }
+        for (; m_size < count; m_size++)
+        {
+            construct(m_data + m_size);
+        }
+    }
+
+    // new buffer sized once: [prefix][range][suffix]
+    template <typename ForwardIt>
+    void insert_reallocating(size_t index, ForwardIt first, size_t n)
+    {
+        size_t _grown        = grown_capacity();
+        size_t _new_capacity = m_size + n > _grown ? m_size + n : _grown;
+        T*     _new_data     = allocate(_new_capacity);
+
+        try
+        {
+            construct_range(first, n, _new_data + index);
+        }
+        catch (...)
+        {
+            deallocate(_new_data, _new_capacity);
+            throw;
+        }
+
+        if constexpr (is_trivially_relocatable<T>::value)
+        {
+            relocate_n(m_data, index, _new_data);
+            relocate_n(m_data + index, m_size - index, _new_data + index + n);
+        }
+        else
+        {
+            // both halves are built before any source goes, so a throw leaves this as it was
+            size_t _built = 0;
+            try
+            {
+                uninitialized_move_if_noexcept_n(m_data, index, _new_data);
+                _built = index;
+                uninitialized_move_if_noexcept_n(m_data + index, m_size - index, _new_data + index + n);
+            }
+            catch (...)
+            {
+                destroy_n(_new_data, _built);
+                destroy_n(_new_data + index, n);
+                deallocate(_new_data, _new_capacity);
+                throw;
+            }
+            destroy_n(m_data, m_size);
+        }
+
+        deallocate(m_data, m_capacity);
+        m_data     = _new_data;
+        m_capacity = _new_capacity;
+        m_size += n;
+    }
+
+    template <typename ForwardIt>
+    void insert_in_place(size_t index, ForwardIt first, size_t n)
+    {
+        T*     _pos  = m_data + index;
+        T*     _end  = m_data + m_size;
+        size_t _tail = m_size - index;
+
+        if constexpr (std::is_trivially_copyable<T>::value)
+        {
+            std::memmove(static_cast<void*>(_pos + n), static_cast<const void*>(_pos), sizeof(T) * _tail);
+            try
+            {
+                construct_range(first, n, _pos);
+            }
+            catch (...)
+            {
+                std::memmove(static_cast<void*>(_pos), static_cast<const void*>(_pos + n), sizeof(T) * _tail);
+                throw;
+            }
+            m_size += n;
+        }
+        else if (n < _tail)
+        {
+            // the last n elements move into raw memory, the rest shift by assignment
+            for (size_t i = 0; i < n; i++)
+            {
+                ::new (_end + i) T(std::move(*(_end - n + i)));
+                m_size++;
+            }
+            std::move_backward(_pos, _end - n, _end);
+            for (size_t i = 0; i < n; ++i, ++first)
+            {
+                _pos[i] = *first;
+            }
+        }
+        else
+        {
+            // part of the range lands in raw memory, the whole tail moves behind it
+            ForwardIt _mid = first;
+            std::advance(_mid, _tail);
+            construct_range(_mid, n - _tail, _end);
+            m_size += n - _tail;
+            for (size_t i = 0; i < _tail; i++)
+            {
+                ::new (_end + (n - _tail) + i) T(std::move(_pos[i]));
+                m_size++;
+            }
+            for (size_t i = 0; i < _tail; ++i, ++first)
+            {
+                _pos[i] = *first;
+            }
+        }
+    }
 };
 
-} // namespace m_std
\ No newline at end of file
+// vector whose buffer starts on an Alignment-byte boundary, for the simd kernels
+template <typename T, std::size_t Alignment = 64>
+using aligned_vector = vector<T, aligned_allocator<T, Alignment>>;
+
+} // namespace m_std
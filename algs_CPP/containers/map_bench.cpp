@@ -0,0 +1,126 @@
+#include "m_AVLTree.h"
+#include "m_map.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace m_std;
+
+// the three maps behind one face: insert, find, an in-order scan and erase
+template <typename Map>
+struct ops;
+
+template <typename K, typename V, typename C, std::size_t B>
+struct ops<m_std::map<K, V, C, B>>
+{
+    static void insert(m_std::map<K, V, C, B>& m, K k, V v) { m.insert(k, v); }
+    static bool find(m_std::map<K, V, C, B>& m, K k) { return m.find(k) != m.end(); }
+    static void erase(m_std::map<K, V, C, B>& m, K k) { m.erase(k); }
+};
+
+template <typename K, typename V>
+struct ops<AVLTree<K, V>>
+{
+    static void insert(AVLTree<K, V>& m, K k, V v) { m.insert(k, v); }
+    static bool find(AVLTree<K, V>& m, K k) { return m.find(k) != nullptr; }
+    static void erase(AVLTree<K, V>& m, K k) { m.erase(m.find(k)); }
+};
+
+template <typename K, typename V>
+struct ops<std::map<K, V>>
+{
+    static void insert(std::map<K, V>& m, K k, V v) { m.emplace(k, v); }
+    static bool find(std::map<K, V>& m, K k) { return m.find(k) != m.end(); }
+    static void erase(std::map<K, V>& m, K k) { m.erase(k); }
+};
+
+// small maps are built and probed many times over, so every size does about as much work
+template <typename Map>
+void run(const char* name, const std::vector<int>& keys, const std::vector<int>& probes)
+{
+    using O = ops<Map>;
+
+    std::size_t n       = keys.size();
+    std::size_t repeats = n < 1000000 ? 1000000 / n : 1;
+
+    double insert_ms = 0, find_ms = 0, scan_ms = 0, erase_ms = 0;
+    long long sink   = 0;
+    for (std::size_t r = 0; r < repeats; r++)
+    {
+        Map m;
+        insert_ms += time_ms([&] {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                O::insert(m, keys[i], int(i));
+            }
+        });
+        if (r == 0)
+        {
+            find_ms = time_ms([&] {
+                for (int key : probes)
+                {
+                    sink += O::find(m, key);
+                }
+            });
+            scan_ms = time_ms([&] {
+                for (auto it = m.begin(); it != m.end(); ++it)
+                {
+                    sink += (*it).second;
+                }
+            });
+        }
+        erase_ms += time_ms([&] {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                O::erase(m, keys[i]);
+            }
+        });
+    }
+
+    double per_op = 1e6 / double(n * repeats);
+    std::printf("  %-22s insert %7.1f  find %7.1f  scan %6.2f  erase %7.1f   (ns/op)%s\n", name, insert_ms * per_op,
+                find_ms * 1e6 / double(probes.size()), scan_ms * 1e6 / double(n), erase_ms * per_op, sink == 42 ? " " : "");
+}
+
+int main(int argc, char** argv)
+{
+    // sizes on the command line, e.g. 1000 100000 100000000; std::map and AVLTree need
+    // 40-48 bytes a key, so the largest runs want the memory for that
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        sizes.push_back(std::size_t(std::atoll(argv[i])));
+    }
+    if (sizes.empty())
+    {
+        sizes = { 1000, 100000, 1000000, 10000000 };
+    }
+
+    for (std::size_t n : sizes)
+    {
+        // 0..n-1 shuffled, and two million lookups of random present keys
+        std::mt19937     rng(7);
+        std::vector<int> keys(n), probes(2000000);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            keys[i] = int(i);
+        }
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (int& key : probes)
+        {
+            key = int(rng() % n);
+        }
+
+        std::printf("%zu int keys\n", n);
+        run<m_std::map<int, int, std::less<int>, 256>>("m_std::map (256 B)", keys, probes);
+        run<m_std::map<int, int>>("m_std::map (512 B)", keys, probes);
+        run<AVLTree<int, int>>("AVLTree", keys, probes);
+        run<std::map<int, int>>("std::map", keys, probes);
+    }
+    return 0;
+}
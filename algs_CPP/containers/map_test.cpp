@@ -1,14 +1,345 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
 
 #include "m_pair.h"
 #include "m_AVLTree.h"
+#include "m_map.h"
+#include "m_flat_map.h"
+#include "m_unordered_map.h"
 
+#include <cassert>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 using namespace m_std;
 
+template <typename Map, typename Reference>
+void check_same(const Map& m, const Reference& reference)
+{
+    assert(m.size() == reference.size());
+    auto it = reference.begin();
+    for (auto kv : m)
+    {
+        assert(it != reference.end() && kv.first == it->first && kv.second == it->second);
+        ++it;
+    }
+    assert(it == reference.end());
+
+    // and backwards over the leaf links
+    auto rit = reference.rbegin();
+    for (auto mit = m.end(); mit != m.begin();)
+    {
+        --mit;
+        assert(mit->first == rit->first);
+        ++rit;
+    }
+}
+
+// random inserts, lookups and erases against std::map; small nodes make deep trees and
+// split and merge at every level
+template <typename Key, typename Compare, std::size_t NodeBytes, typename MakeKey>
+void btree_ops(MakeKey make_key)
+{
+    using map_type = m_std::map<Key, int, Compare, NodeBytes>;
+
+    std::mt19937              rng(21);
+    map_type                  m;
+    std::map<Key, int, Compare> reference;
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < 20000; i++)
+        {
+            Key key = make_key(int(rng() % 30000));
+            if (rng() % 3 == 0)
+            {
+                assert(m.erase(key) == reference.erase(key));
+            }
+            else
+            {
+                auto result = m.insert(key, i);
+                assert(result.second == reference.emplace(key, i).second);
+                assert(result.first->first == key && result.first->second == reference[key]);
+            }
+        }
+        check_same(m, reference);
+
+        for (int i = 0; i < 2000; i++)
+        {
+            Key  key   = make_key(int(rng() % 31000) - 500);
+            auto found = m.find(key);
+            assert((found != m.end()) == (reference.count(key) == 1));
+            auto lower = m.lower_bound(key);
+            auto upper = m.upper_bound(key);
+            assert(lower == m.end() ? reference.lower_bound(key) == reference.end() : lower->first == reference.lower_bound(key)->first);
+            assert(upper == m.end() ? reference.upper_bound(key) == reference.end() : upper->first == reference.upper_bound(key)->first);
+
+            // the const overloads land on the same slots
+            const map_type& cm = m;
+            assert(cm.find(key) == found && cm.lower_bound(key) == lower && cm.upper_bound(key) == upper);
+        }
+
+        // drain most of it, merging leaves and collapsing levels
+        for (int i = 0; i < 25000; i++)
+        {
+            Key key = make_key(int(rng() % 30000));
+            assert(m.erase(key) == reference.erase(key));
+        }
+        check_same(m, reference);
+    }
+
+    // erase by position returns the next one
+    while (reference.size() > 10)
+    {
+        auto next = m.erase(m.find(reference.begin()->first));
+        reference.erase(reference.begin());
+        assert(next->first == reference.begin()->first);
+    }
+
+    map_type copy(m), moved;
+    moved = std::move(m);
+    assert(m.empty() && m.begin() == m.end());
+    check_same(copy, reference);
+    check_same(moved, reference);
+    while (!reference.empty())
+    {
+        assert(copy.erase(reference.begin()->first) == 1);
+        reference.erase(reference.begin());
+    }
+    assert(copy.empty() && copy.depth() == 0 && copy.memory_usage() == sizeof(copy));
+    copy[make_key(1)] = 5;
+    assert(copy.find(make_key(1))->second == 5 && copy.depth() == 1);
+}
+
+// batches of inserts, assigns and erases against std::map, with and without the index;
+// a batch names each key several times so the order inside a key's group matters
+template <typename Key, typename Compare, typename MakeKey>
+void flat_map_ops(bool indexed, MakeKey make_key)
+{
+    std::mt19937                       rng(indexed ? 5 : 6);
+    m_std::flat_map<Key, int, Compare> m;
+    std::map<Key, int, Compare>        reference;
+    m.use_index(indexed);
+    for (int round = 0; round < 12; round++)
+    {
+        int batch = round < 4 ? 1 << (2 * round) : 3000;
+        for (int i = 0; i < batch; i++)
+        {
+            Key      key = make_key(int(rng() % 5000));
+            unsigned op  = rng() % 4;
+            if (op == 0)
+            {
+                m.erase(key);
+                reference.erase(key);
+            }
+            else if (op == 1)
+            {
+                m.insert_or_assign(key, i);
+                reference[key] = i;
+            }
+            else
+            {
+                m.insert(key, i);
+                reference.emplace(key, i);
+            }
+        }
+
+        // nothing shows until the commit
+        assert(m.pending() == std::size_t(batch));
+        m.commit();
+        assert(m.pending() == 0 && m.indexed() == (indexed && !m.empty()));
+        assert(m.size() == reference.size());
+        auto it = reference.begin();
+        for (const auto& kv : m)
+        {
+            assert(kv.first == it->first && kv.second == it->second);
+            ++it;
+        }
+
+        for (int i = 0; i < 2000; i++)
+        {
+            Key  key   = make_key(int(rng() % 5200) - 100);
+            auto found = m.find(key);
+            auto lower = m.lower_bound(key);
+            auto ref   = reference.lower_bound(key);
+            assert((found != m.end()) == (reference.count(key) == 1) && m.contains(key) == (found != m.end()));
+            assert(lower == m.end() ? ref == reference.end() : lower->first == ref->first);
+        }
+    }
+
+    // every size from empty up, so the implicit tree ends on every shape of last level
+    m_std::flat_map<Key, int, Compare> small;
+    small.use_index(indexed);
+    std::map<Key, int, Compare> small_reference;
+    for (int n = 0; n < 70; n++)
+    {
+        for (int i = -1; i <= 2 * n + 1; i++)
+        {
+            auto lower = small.lower_bound(make_key(i));
+            auto ref   = small_reference.lower_bound(make_key(i));
+            assert(lower == small.end() ? ref == small_reference.end() : lower->first == ref->first);
+        }
+        small.insert(make_key(2 * n), n);
+        small_reference.emplace(make_key(2 * n), n);
+        small.commit();
+    }
+}
+
+// a hash that piles keys onto a few homes, so the runs are long and wrap the table end
+struct clumped_hash
+{
+    std::size_t operator()(int k) const { return std::size_t(k % 7) * 0x2545F4914F6CDD1Dull; }
+};
+
+struct string_hash
+{
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+
+// random inserts and erases against std::unordered_map: growth, backward-shift erase and
+// lookups of absent keys
+template <typename Key, typename Hash, typename MakeKey>
+void hash_ops(MakeKey make_key, int key_range)
+{
+    std::mt19937                                   rng(22);
+    m_std::unordered_map<Key, int, Hash>           m;
+    std::unordered_map<Key, int, std::hash<Key>>   reference;
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < 20000; i++)
+        {
+            Key key = make_key(int(rng() % key_range));
+            if (rng() % 3 == 0)
+            {
+                assert(m.erase(key) == reference.erase(key));
+            }
+            else
+            {
+                auto result = m.insert(key, i);
+                assert(result.second == reference.emplace(key, i).second);
+                assert(result.first->first == key && result.first->second == reference[key]);
+            }
+        }
+        assert(m.size() == reference.size() && m.load_factor() <= 0.875f);
+        std::size_t seen = 0;
+        for (const auto& kv : m)
+        {
+            assert(reference.at(kv.first) == kv.second);
+            seen++;
+        }
+        assert(seen == reference.size());
+        for (int i = 0; i < 3000; i++)
+        {
+            Key key = make_key(int(rng() % (key_range + 500)));
+            assert(m.contains(key) == (reference.count(key) == 1));
+        }
+
+        // drain most of it through iterators and keys
+        while (m.size() > reference.size() / 4 + 1)
+        {
+            auto it = m.begin();
+            reference.erase(it->first);
+            m.erase(it);
+        }
+        for (const auto& kv : reference)
+        {
+            assert(m.find(kv.first)->second == kv.second);
+        }
+    }
+
+    m_std::unordered_map<Key, int, Hash> copy(m), moved;
+    moved = std::move(m);
+    assert(m.empty() && m.begin() == m.end() && m.find(make_key(1)) == m.end());
+    assert(copy.size() == reference.size() && moved.size() == reference.size());
+    for (const auto& kv : reference)
+    {
+        assert(copy.find(kv.first)->second == kv.second && moved.contains(kv.first));
+    }
+    copy.clear();
+    assert(copy.empty() && copy.begin() == copy.end() && copy.capacity() != 0);
+    copy[make_key(3)] += 2;
+    assert(copy.find(make_key(3))->second == 2);
+}
+
 int main()
 {
+    // int keys go through the simd search, strings through the binary search
+    btree_ops<int, std::less<int>, 64>([](int k) { return k; });
+    btree_ops<int, std::greater<int>, 64>([](int k) { return k; });
+    btree_ops<double, std::less<double>, 128>([](int k) { return k * 0.5; });
+    btree_ops<std::string, std::less<std::string>, 256>([](int k) { return "key-" + std::to_string(k); });
+    btree_ops<int, std::less<int>, 256>([](int k) { return k; });
+
+    for (bool indexed : { false, true })
+    {
+        flat_map_ops<int, std::less<int>>(indexed, [](int k) { return k; });
+        flat_map_ops<int, std::greater<int>>(indexed, [](int k) { return k; });
+        flat_map_ops<std::string, std::less<std::string>>(indexed, [](int k) { return "key-" + std::to_string(k); });
+    }
+
+    hash_ops<int, std::hash<int>>([](int k) { return k; }, 30000);
+    hash_ops<int, clumped_hash>([](int k) { return k; }, 3000);
+    hash_ops<std::string, std::hash<std::string>>([](int k) { return "key-" + std::to_string(k); }, 30000);
+
+    {
+        // reserve sizes the table once
+        m_std::unordered_map<int, int> m(100000);
+        std::size_t                    capacity = m.capacity();
+        for (int i = 0; i < 100000; i++)
+        {
+            m.insert(i, i);
+        }
+        assert(m.capacity() == capacity && capacity <= 262144);
+
+        // string_view lookups into string keys, and values that only move
+        m_std::unordered_map<std::string, std::unique_ptr<int>, string_hash, std::equal_to<>> names;
+        names.try_emplace("apple", new int(1));
+        names.try_emplace(std::string("banana"), new int(2));
+        std::string_view key = "a banana";
+        assert(*names.find(key.substr(2))->second == 2 && names.contains(std::string_view("apple")));
+        assert(!names.contains(key) && names.erase(std::string_view("apple")) == 1 && names.size() == 1);
+        for (int i = 0; i < 1000; i++)
+        {
+            names.try_emplace("name-" + std::to_string(i), new int(i));
+        }
+        assert(*names.find(std::string_view("name-999"))->second == 999 && *names.find("banana")->second == 2);
+    }
+
+    {
+        m_std::map<int, std::string> m;
+        for (int i = 0; i < 100000; i++)
+        {
+            m.try_emplace(i, std::to_string(i));
+        }
+        assert(m.size() == 100000 && m.depth() <= 5);
+        assert(!m.try_emplace(500, "no").second && m.find(500)->second == "500");
+        int expected = 0;
+        for (auto it = m.lower_bound(99990); it != m.end(); ++it)
+        {
+            it->second = "x";
+            expected++;
+        }
+        assert(expected == 10 && m.find(99995)->second == "x");
+
+        // an ascending load fills the nodes instead of leaving them half empty
+        using int_map = m_std::map<int, int>;
+        int_map dense;
+        for (int i = 0; i < 100000; i++)
+        {
+            dense.insert(i, i);
+        }
+        std::size_t full_leaves = 100000 / int_map::leaf_capacity + 1;
+        assert(dense.memory_usage() < sizeof(dense) + full_leaves * sizeof(int_map::leaf_node) * 11 / 10);
+        static_assert(sizeof(int_map::leaf_node) == 512 && sizeof(int_map::inner_node) == 512, "a node is eight cache lines");
+        static_assert(alignof(int_map::leaf_node) == 64, "nodes start on a cache line");
+    }
+
     pair<std::string, int> p1("apple", 1);
     pair<std::string, int> p2("banana", 2);
     swap(p1, p2);
@@ -33,7 +364,7 @@ int main()
 
     auto _node = bst.find(5);
     if (_node != nullptr)
-        std::cout << "to delete: " << _node->value << std::endl;
+        std::cout << "to delete: " << _node->value() << std::endl;
     bst.erase(_node);
 
     bst.print();
@@ -0,0 +1,78 @@
+#include "m_mapped_vector.h"
+#include "m_vector.hpp"
+#include "Timer.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace m_std;
+
+// the lookup table every process start used to recompute
+inline std::uint64_t table_entry(std::uint64_t i)
+{
+    std::uint64_t x = i * 0x9E3779B97F4A7C15ull;
+    return x ^ (x >> 31);
+}
+
+int main(int argc, char** argv)
+{
+    // default 2^27 entries (1 GB); pass the entry count to scale
+    std::size_t n    = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (std::size_t(1) << 27);
+    std::string path = argc > 2 ? argv[2] : "mapped_vector_bench.bin";
+
+    double rebuild_ms;
+    {
+        Timer                 t;
+        vector<std::uint64_t> table;
+        table.reserve(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            table.push_back(table_entry(i));
+        }
+        t.stop();
+        rebuild_ms = t.getElapsedTime<microseconds>() / 1000.0;
+    }
+
+    double write_ms;
+    {
+        Timer                        t;
+        mapped_vector<std::uint64_t> table(path, mapped_open::truncate);
+        table.reserve(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            table.push_back(table_entry(i));
+        }
+        table.flush();
+        t.stop();
+        write_ms = t.getElapsedTime<microseconds>() / 1000.0;
+    }
+
+    double        reopen_us, first_touch_us;
+    std::uint64_t probe = 0;
+    {
+        Timer                        t;
+        mapped_vector<std::uint64_t> table(path, mapped_open::open_existing);
+        t.stop();
+        reopen_us = t.getElapsedTime<nanoseconds>() / 1000.0;
+
+        // a handful of random lookups fault in only the pages they hit
+        Timer touch;
+        for (std::size_t i = 0; i < 1000; i++)
+        {
+            probe ^= table[table_entry(i) % table.size()];
+        }
+        touch.stop();
+        first_touch_us = touch.getElapsedTime<nanoseconds>() / 1000.0;
+    }
+
+    std::printf("%zu entries (%.1f MB)\n", n, n * sizeof(std::uint64_t) / 1048576.0);
+    std::printf("rebuild into vector        %10.1f ms\n", rebuild_ms);
+    std::printf("build + flush mapped file  %10.1f ms\n", write_ms);
+    std::printf("reopen mapped_vector       %10.1f us\n", reopen_us);
+    std::printf("1000 lookups after reopen  %10.1f us  (probe %llx)\n", first_touch_us, (unsigned long long)probe);
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,99 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_mapped_vector.h"
+
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+using namespace m_std;
+
+struct Point
+{
+    double x, y;
+};
+
+int main()
+{
+    const std::string path = "mapped_vector_test.bin";
+    std::remove(path.c_str());
+
+    {
+        mapped_vector<Point> points(path);
+        assert(points.empty() && points.capacity() == 0);
+        for (int i = 0; i < 10000; i++)
+        {
+            points.push_back(Point{ double(i), double(-i) });
+        }
+        points.emplace_back(Point{ 0.5, 0.5 });
+        points.pop_back();
+        assert(points.size() == 10000 && points[9999].y == -9999.0);
+        points.flush();
+    }
+
+    // reopening maps the same bytes back
+    {
+        mapped_vector<Point> points(path, mapped_open::open_existing);
+        assert(points.size() == 10000 && points[1234].x == 1234.0);
+
+        double sum = 0;
+        for (const Point& p : points)
+        {
+            sum += p.x;
+        }
+        assert(sum == 9999.0 * 10000 / 2);
+
+        points.shrink_to_fit();
+        assert(points.capacity() == 10000);
+        points.resize(10002, Point{ 7, 7 });
+        assert(points[10001].x == 7 && points.capacity() >= 10002);
+
+        bool threw = false;
+        try
+        {
+            points[10002];
+        }
+        catch (const std::out_of_range&)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // the header guards against opening as another element type
+    {
+        bool threw = false;
+        try
+        {
+            mapped_vector<int> wrong(path);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // truncate starts over
+    {
+        mapped_vector<Point> points(path, mapped_open::truncate);
+        assert(points.empty());
+    }
+
+    std::remove(path.c_str());
+
+    bool threw = false;
+    try
+    {
+        mapped_vector<int> missing(path, mapped_open::open_existing);
+    }
+    catch (const std::system_error&)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "m_parallel.h"
+#include "m_vector.hpp"
+#include "Timer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace m_std;
+
+struct result
+{
+    double for_each_ms, transform_ms, reduce_ms, scan_ms, sort_ms;
+};
+
+result run(ThreadPool& pool, const vector<double>& input)
+{
+    std::size_t n = input.size();
+    vector<double> a(n), out(n);
+    result r {};
+
+    std::copy(input.begin(), input.end(), a.begin());
+    r.for_each_ms  = time_ms([&] { parallel::for_each(pool, a.begin(), a.end(), [](double& x) { x = std::sqrt(x) * std::log1p(x); }); });
+    r.transform_ms = time_ms([&] { parallel::transform(pool, a.begin(), a.end(), out.begin(), [](double x) { return std::exp(-x); }); });
+    volatile double sum = 0;
+    r.reduce_ms = time_ms([&] { sum = parallel::reduce(pool, out.begin(), out.end(), 0.0); });
+    r.scan_ms   = time_ms([&] { parallel::inclusive_scan(pool, out.begin(), out.end(), a.begin()); });
+    std::copy(input.begin(), input.end(), a.begin());
+    r.sort_ms = time_ms([&] { parallel::sort(pool, a.begin(), a.end()); });
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (std::size_t(1) << 24);
+
+    vector<double>                         input(n);
+    std::mt19937_64                        rng(42);
+    std::uniform_real_distribution<double> dist(0.0, 100.0);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        input[i] = dist(rng);
+    }
+
+    int              hardware = int(std::thread::hardware_concurrency());
+    std::vector<int> thread_counts = { 1, 2, 4 };
+    if (hardware > 4)
+    {
+        thread_counts.push_back(hardware);
+    }
+
+    std::printf("%zu doubles, %d hardware threads (ms, speedup vs 1 thread)\n", n, hardware);
+    std::printf("%8s %16s %16s %16s %16s %16s\n", "threads", "for_each", "transform", "reduce", "inclusive_scan", "sort");
+
+    result base {};
+    for (int threads : thread_counts)
+    {
+        ThreadPool pool(threads);
+        result     r = run(pool, input);
+        if (threads == 1)
+        {
+            base = r;
+        }
+        std::printf("%8d %9.1f (%4.1fx) %9.1f (%4.1fx) %9.1f (%4.1fx) %9.1f (%4.1fx) %9.1f (%4.1fx)\n", threads, r.for_each_ms,
+                    base.for_each_ms / r.for_each_ms, r.transform_ms, base.transform_ms / r.transform_ms, r.reduce_ms,
+                    base.reduce_ms / r.reduce_ms, r.scan_ms, base.scan_ms / r.scan_ms, r.sort_ms, base.sort_ms / r.sort_ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace m_std;
+
+int main()
+{
+    ThreadPool pool(4);
+
+    // task groups: nested forks, and the first exception comes back from wait()
+    {
+        std::atomic<int> ran{ 0 };
+        TaskGroup        outer(pool);
+        for (int i = 0; i < 8; i++)
+        {
+            outer.run([&pool, &ran] {
+                TaskGroup inner(pool);
+                for (int j = 0; j < 8; j++)
+                {
+                    inner.run([&ran] { ran++; });
+                }
+                inner.wait();
+            });
+        }
+        outer.wait();
+        assert(ran == 64);
+
+        TaskGroup failing(pool);
+        failing.run([] { throw std::runtime_error("task failed"); });
+        failing.run([] {});
+        bool threw = false;
+        try
+        {
+            failing.wait();
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // every algorithm against its serial std:: counterpart, below and above the cutoff
+    std::mt19937 rng(7);
+    for (std::size_t n : { std::size_t(0), std::size_t(1), std::size_t(1000), std::size_t(300000) })
+    {
+        std::vector<int> input(n);
+        for (auto& x : input)
+        {
+            x = int(rng() % 1000) - 500;
+        }
+
+        std::vector<int> v = input;
+        parallel::for_each(pool, v.data(), v.data() + n, [](int& x) { x *= 2; });
+        for (std::size_t i = 0; i < n; i++)
+        {
+            assert(v[i] == input[i] * 2);
+        }
+
+        std::vector<long long> wide(n);
+        parallel::transform(pool, input.data(), input.data() + n, wide.data(), [](int x) { return 3LL * x; });
+        parallel::transform(pool, wide.data(), wide.data() + n, input.data(), wide.data(), [](long long a, int b) { return a - b; });
+        for (std::size_t i = 0; i < n; i++)
+        {
+            assert(wide[i] == 2LL * input[i]);
+        }
+
+        long long sum = parallel::reduce(pool, input.data(), input.data() + n, 10LL);
+        assert(sum == std::accumulate(input.begin(), input.end(), 10LL));
+
+        // associative but not commutative: chunks must combine in order
+        std::vector<std::string> digits(std::min<std::size_t>(n, 40000));
+        for (std::size_t i = 0; i < digits.size(); i++)
+        {
+            digits[i] = std::to_string(i % 10);
+        }
+        std::string joined = parallel::reduce(pool, digits.data(), digits.data() + digits.size(), std::string("<"));
+        assert(joined == std::accumulate(digits.begin(), digits.end(), std::string("<")));
+
+        std::vector<long long> scanned(n), expected(n);
+        std::partial_sum(input.begin(), input.end(), expected.begin(), std::plus<long long>());
+        parallel::inclusive_scan(pool, input.data(), input.data() + n, scanned.data(), std::plus<long long>());
+        assert(scanned == expected);
+
+        // in place
+        std::vector<int> in_place = input, in_place_expected(n);
+        std::partial_sum(input.begin(), input.end(), in_place_expected.begin());
+        parallel::inclusive_scan(pool, in_place.data(), in_place.data() + n, in_place.data());
+        assert(in_place == in_place_expected);
+
+        std::vector<int> sorted = input;
+        parallel::sort(pool, sorted.data(), sorted.data() + n);
+        std::vector<int> sorted_expected = input;
+        std::sort(sorted_expected.begin(), sorted_expected.end());
+        assert(sorted == sorted_expected);
+
+        parallel::sort(pool, sorted.data(), sorted.data() + n, std::greater<>());
+        assert(std::is_sorted(sorted.begin(), sorted.end(), std::greater<>()));
+    }
+
+    // move-only-ish payloads survive the scratch buffer
+    {
+        std::vector<std::string> words(50000);
+        for (std::size_t i = 0; i < words.size(); i++)
+        {
+            words[i] = std::to_string((i * 7919) % words.size());
+        }
+        parallel::sort(pool, words.data(), words.data() + words.size());
+        assert(std::is_sorted(words.begin(), words.end()) && words.front() == "0");
+    }
+
+    // shared pool and whole-vector overloads
+    {
+        vector<double> v(100000, 0.5);
+        parallel::for_each(v, [](double& x) { x += 1; });
+        assert(parallel::reduce(v, 0.0) == 150000.0);
+        v[0] = 9;
+        parallel::sort(v);
+        assert(v[v.size() - 1] == 9);
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "m_AVLTree.h"
+#include "m_persistent_map.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace m_std;
+
+int main(int argc, char** argv)
+{
+    std::size_t n      = argc > 1 ? std::size_t(std::atoll(argv[1])) : 1000000;
+    std::size_t writes = argc > 2 ? std::size_t(std::atoll(argv[2])) : 200000;
+
+    std::mt19937     rng(5);
+    std::vector<int> keys(n), updates(writes);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        keys[i] = int(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (int& key : updates)
+    {
+        key = int(rng() % (2 * n));
+    }
+
+    persistent_map<int, int> map;
+    AVLTree<int, int>        tree;
+    double                   map_load_ms  = time_ms([&] {
+        for (int key : keys)
+        {
+            map.insert(key, key);
+        }
+    });
+    double                   tree_load_ms = time_ms([&] {
+        for (int key : keys)
+        {
+            tree.insert(key, key);
+        }
+    });
+
+    std::printf("%zu int keys\n", n);
+    std::printf("  load              persistent_map %7.1f ns/insert   AVLTree %7.1f ns/insert\n", map_load_ms * 1e6 / double(n),
+                tree_load_ms * 1e6 / double(n));
+
+    // a point-in-time view: one reference count, against copying every node
+    std::size_t snapshots   = 100000;
+    double      snapshot_ms = time_ms([&] {
+        for (std::size_t i = 0; i < snapshots; i++)
+        {
+            auto s = map.snapshot();
+            if (s.size() == 42)
+            {
+                std::printf(" ");
+            }
+        }
+    });
+    double copy_ms = time_ms([&] {
+        AVLTree<int, int> copy(tree);
+        if (copy.size() == 42)
+        {
+            std::printf(" ");
+        }
+    });
+    std::printf("  view              snapshot() %9.1f ns            AVLTree copy %9.1f ms\n", snapshot_ms * 1e6 / double(snapshots),
+                copy_ms);
+
+    // writes alone change nodes in place; with a live snapshot every write copies its path
+    auto write_all = [&](std::size_t from, std::size_t to) {
+        for (std::size_t i = from; i < to; i++)
+        {
+            map.insert_or_assign(updates[i], int(i));
+        }
+    };
+    double      alone_ms = time_ms([&] { write_all(0, writes / 2); });
+    auto        held     = map.snapshot();
+    double      held_ms  = time_ms([&] { write_all(writes / 2, writes); });
+    double      tree_ms  = time_ms([&] {
+        for (std::size_t i = 0; i < writes / 2; i++)
+        {
+            auto node = tree.find(updates[i]);
+            if (node != nullptr)
+            {
+                node->value() = int(i);
+            }
+            else
+            {
+                tree.insert(updates[i], int(i));
+            }
+        }
+    });
+    double per_write = 1e6 / double(writes / 2);
+    std::printf("  writes            no snapshot %6.1f ns   snapshot held %6.1f ns   AVLTree %6.1f ns   (per assign)\n",
+                alone_ms * per_write, held_ms * per_write, tree_ms * per_write);
+
+    // a scan of the held snapshot on another thread while this one keeps writing
+    long long   sum     = 0;
+    double      scan_ms = 0;
+    std::thread scanner([&] {
+        scan_ms = time_ms([&] {
+            for (const auto& kv : held)
+            {
+                sum += kv.second;
+            }
+        });
+    });
+    double concurrent_ms = time_ms([&] { write_all(0, writes / 2); });
+    scanner.join();
+    std::printf("  scan + writes     snapshot scan %7.1f ms (%zu keys) alongside %zu writes in %7.1f ms%s\n", scan_ms, held.size(), writes / 2,
+                concurrent_ms, sum == 42 ? " " : "");
+    return 0;
+}
@@ -0,0 +1,157 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_persistent_map.h"
+
+#include <atomic>
+#include <cassert>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace m_std;
+
+template <typename Snapshot, typename Reference>
+void check_same(const Snapshot& s, const Reference& reference)
+{
+    assert(s.size() == reference.size());
+    auto it = reference.begin();
+    for (const auto& kv : s)
+    {
+        assert(it != reference.end() && kv.first == it->first && kv.second == it->second);
+        ++it;
+    }
+    assert(it == reference.end());
+}
+
+int main()
+{
+    // every snapshot keeps the contents it was taken with while the map moves on
+    {
+        using map_type = persistent_map<int, std::string>;
+
+        std::mt19937                            rng(24);
+        map_type                                m;
+        std::map<int, std::string>              reference;
+        std::vector<map_type::snapshot_type>    snapshots;
+        std::vector<std::map<int, std::string>> expected;
+        for (int i = 0; i < 60000; i++)
+        {
+            int         key   = int(rng() % 5000);
+            std::string value = std::to_string(i);
+            switch (rng() % 4)
+            {
+            case 0:
+                assert(m.erase(key) == (reference.erase(key) == 1));
+                break;
+            case 1:
+                assert(m.insert_or_assign(key, value) == (reference.count(key) == 0));
+                reference[key] = value;
+                break;
+            default:
+                assert(m.insert(key, value) == reference.emplace(key, value).second);
+            }
+            if (i % 3000 == 0)
+            {
+                snapshots.push_back(m.snapshot());
+                expected.push_back(reference);
+            }
+            // drop an old one now and then, so the map gets its nodes back to itself
+            if (i % 7000 == 0 && snapshots.size() > 3)
+            {
+                snapshots.erase(snapshots.begin() + 1);
+                expected.erase(expected.begin() + 1);
+            }
+        }
+        assert(m.size() == reference.size());
+        check_same(m.snapshot(), reference);
+        for (std::size_t i = 0; i < snapshots.size(); i++)
+        {
+            check_same(snapshots[i], expected[i]);
+            for (int key = -1; key < 5001; key += 7)
+            {
+                const std::string* found = snapshots[i].find(key);
+                assert((found != nullptr) == (expected[i].count(key) == 1));
+                assert(found == nullptr || *found == expected[i][key]);
+            }
+        }
+
+        // copies share everything until one side writes
+        map_type copy(m);
+        copy.insert_or_assign(-5, "copy");
+        assert(copy.contains(-5) && !m.contains(-5) && copy.size() == m.size() + 1);
+        std::string value;
+        assert(copy.find(-5, value) && value == "copy");
+
+        map_type::snapshot_type before = m.snapshot();
+        m.clear();
+        assert(m.empty() && m.snapshot().begin() == m.snapshot().end());
+        check_same(before, reference);
+        m = copy;
+        assert(m.size() == reference.size() + 1);
+    }
+
+    // readers scan snapshots on their own threads while a writer keeps going. the writer
+    // keeps value == 3 * key and moves a counter key, so a snapshot is consistent if every
+    // value matches its key and the counter never goes back
+    {
+        persistent_map<int, int> m;
+        for (int key = 0; key < 20000; key++)
+        {
+            m.insert(key, 3 * key);
+        }
+        m.insert(-1, 0);
+
+        std::atomic<bool>        done{ false };
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 3; r++)
+        {
+            readers.emplace_back([&m, &done] {
+                int last = 0;
+                while (!done.load())
+                {
+                    auto        s     = m.snapshot();
+                    std::size_t count = 0;
+                    int         prev  = -2;
+                    for (const auto& kv : s)
+                    {
+                        assert(kv.first > prev);
+                        assert(kv.first == -1 || kv.second == 3 * kv.first);
+                        prev = kv.first;
+                        count++;
+                    }
+                    assert(count == s.size());
+                    int counter = *s.find(-1);
+                    assert(counter >= last);
+                    last = counter;
+                }
+            });
+        }
+
+        std::mt19937 rng(124);
+        for (int i = 1; i <= 40000; i++)
+        {
+            int key = int(rng() % 30000);
+            if (rng() % 2 == 0)
+            {
+                m.erase(key);
+            }
+            else
+            {
+                m.insert_or_assign(key, 3 * key);
+            }
+            m.insert_or_assign(-1, i);
+        }
+        done = true;
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+        int counter = 0;
+        assert(m.find(-1, counter) && counter == 40000);
+    }
+
+    return 0;
+}
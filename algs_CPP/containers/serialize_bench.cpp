@@ -0,0 +1,55 @@
+#include "m_AVLTree.h"
+#include "m_serialize.h"
+#include "m_vector.hpp"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace m_std;
+
+int main(int argc, char** argv)
+{
+    int         n    = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    std::string path = "serialize_bench.bin";
+
+    AVLTree<int, int> tree;
+    for (int i = 0; i < n; i++)
+    {
+        tree.insert(int((i * 2654435761u) % unsigned(n)), i);
+    }
+
+    // what loading meant before: walk the tree and insert every pair into a new one
+    double reinsert_ms = time_ms([&] {
+        AVLTree<int, int> copy;
+        for (const auto& kv : tree)
+        {
+            copy.insert(kv.first, kv.second);
+        }
+    });
+
+    double save_ms = time_ms([&] { save_snapshot(path, tree); });
+    double load_ms = time_ms([&] {
+        AVLTree<int, int> restored;
+        load_snapshot(path, restored);
+    });
+
+    std::printf("AVLTree<int, int>, %d pairs\n", n);
+    std::printf("re-insert every pair   %9.1f ms\n", reinsert_ms);
+    std::printf("save snapshot          %9.1f ms\n", save_ms);
+    std::printf("load snapshot (O(n))   %9.1f ms\n", load_ms);
+
+    vector<double> v(std::size_t(n) * 8, 1.5);
+    double         vector_save_ms = time_ms([&] { save_snapshot(path, v); });
+    double         vector_load_ms = time_ms([&] {
+        vector<double> restored;
+        load_snapshot(path, restored);
+    });
+    double mb = v.size() * sizeof(double) / 1048576.0;
+    std::printf("vector<double>, %.0f MB: save %.1f ms (%.0f MB/s), load %.1f ms (%.0f MB/s)\n", mb, vector_save_ms,
+                mb / vector_save_ms * 1000, vector_load_ms, mb / vector_load_ms * 1000);
+
+    std::remove(path.c_str());
+    return 0;
+}
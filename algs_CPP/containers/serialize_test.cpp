@@ -0,0 +1,187 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_serialize.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace m_std;
+
+// a valid AVL tree: ordered, heights right, balanced
+template <typename Node>
+int check_subtree(const Node* node)
+{
+    if (node == nullptr)
+    {
+        return -1;
+    }
+    int left  = check_subtree(node->left());
+    int right = check_subtree(node->right());
+    assert(node->height == 1 + (left > right ? left : right));
+    assert(left - right <= 1 && right - left <= 1);
+    assert(!node->left() || node->left()->parent() == node);
+    assert(!node->right() || node->right()->parent() == node);
+    return node->height;
+}
+
+template <typename Tree>
+auto root_of(const Tree& tree)
+{
+    auto node = tree.begin().node();
+    while (node && node->parent())
+    {
+        node = node->parent();
+    }
+    return node;
+}
+
+template <typename Stream, typename Container>
+bool throws_on_load(Stream& in, Container& c)
+{
+    try
+    {
+        binary_reader r(in);
+        deserialize(r, c);
+    }
+    catch (const std::runtime_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main()
+{
+    // raw vector: one block each way
+    {
+        vector<int> v;
+        for (int i = 0; i < 100000; i++)
+        {
+            v.push_back(i * 3);
+        }
+
+        std::stringstream buffer;
+        {
+            binary_writer w(buffer, 4096);
+            serialize(w, v);
+            w.flush();
+        }
+
+        vector<int>   restored(5, 1);
+        binary_reader r(buffer, 4096);
+        deserialize(r, restored);
+        assert(restored.size() == v.size() && restored[99999] == 99999 * 3);
+
+        // wrong element layout, and a cut-off stream
+        std::stringstream again(buffer.str());
+        vector<double>    as_double;
+        assert(throws_on_load(again, as_double));
+
+        std::stringstream cut(buffer.str().substr(0, 1000));
+        assert(throws_on_load(cut, restored));
+
+        // a corrupt count is caught before anything is allocated for it
+        std::string   corrupt = buffer.str();
+        std::uint64_t huge    = std::uint64_t(1) << 40;
+        std::memcpy(&corrupt[16], &huge, sizeof(huge));
+        std::stringstream bad_count(corrupt);
+        assert(throws_on_load(bad_count, restored));
+    }
+
+    // strings go through their serializer
+    {
+        vector<std::string> words;
+        words.push_back("");
+        words.push_back("tree");
+        words.push_back(std::string(100000, 'x'));
+
+        std::stringstream buffer;
+        {
+            binary_writer w(buffer, 64);
+            serialize(w, words);
+        }
+
+        vector<std::string> restored;
+        binary_reader       r(buffer, 64);
+        deserialize(r, restored);
+        assert(restored.size() == 3 && restored[0].empty() && restored[1] == "tree" && restored[2].size() == 100000);
+
+        // serialized types keep their size in the header too
+        std::stringstream              again(buffer.str());
+        vector<pair<std::string, int>> as_pairs;
+        assert(throws_on_load(again, as_pairs));
+
+        // a string length past the end fails as its bytes run out
+        std::string   corrupt = buffer.str();
+        std::uint64_t huge    = std::uint64_t(1) << 40;
+        std::memcpy(&corrupt[24], &huge, sizeof(huge)); // the first string's length
+        std::stringstream bad_length(corrupt);
+        assert(throws_on_load(bad_length, restored));
+    }
+
+    // trees come back balanced, from sorted input and without compares
+    {
+        AVLTree<std::string, int> tree;
+        for (int i = 0; i < 1000; i++)
+        {
+            tree.insert("key" + std::to_string(i), i);
+        }
+
+        std::stringstream buffer;
+        {
+            binary_writer w(buffer);
+            serialize(w, tree);
+        }
+
+        AVLTree<std::string, int> restored;
+        restored.insert("stale", -1);
+        binary_reader r(buffer);
+        deserialize(r, restored);
+        assert(restored.size() == 1000 && restored.find("stale") == nullptr);
+        assert(restored.find("key500") != nullptr && restored.find("key500")->value() == 500);
+        check_subtree(root_of(restored));
+
+        auto it = restored.begin();
+        for (const auto& kv : tree)
+        {
+            assert(it->first == kv.first && it->second == kv.second);
+            ++it;
+        }
+        assert(it == restored.end());
+
+        // a vector snapshot is not a tree snapshot
+        std::stringstream other;
+        {
+            vector<int>   v(3, 7);
+            binary_writer w(other);
+            serialize(w, v);
+        }
+        AVLTree<int, int> wrong;
+        assert(throws_on_load(other, wrong));
+    }
+
+    // files, and the shape of a restored tree
+    {
+        AVLTree<int, double> tree;
+        for (int i = 0; i < 5000; i++)
+        {
+            tree.insert((i * 7919) % 5000, i * 0.5);
+        }
+        save_snapshot("serialize_test.bin", tree);
+
+        AVLTree<int, double> restored;
+        load_snapshot("serialize_test.bin", restored);
+        std::remove("serialize_test.bin");
+
+        assert(restored.size() == 5000 && restored.height() == 12); // 2^12 <= 5000 < 2^13
+        check_subtree(root_of(restored));
+    }
+
+    return 0;
+}
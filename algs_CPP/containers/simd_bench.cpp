@@ -0,0 +1,97 @@
+#include "m_simd.h"
+#include "m_vector.hpp"
+#include "Timer.h"
+
+#include <cstdint>
+#include <cstdio>
+
+using namespace m_std;
+
+constexpr std::size_t kSize    = std::size_t(1) << 24;
+constexpr int         kRepeats = 20;
+
+volatile double g_sink; // keeps the results alive
+
+// the plain iterator loops the kernels replace
+template <typename T>
+struct plain
+{
+    static T sum(aligned_vector<T>& a)
+    {
+        T s = T();
+        for (auto it = a.begin(); it != a.end(); ++it) s += *it;
+        return s;
+    }
+    static T dot(aligned_vector<T>& a, aligned_vector<T>& b)
+    {
+        T    s  = T();
+        auto jt = b.begin();
+        for (auto it = a.begin(); it != a.end(); ++it, ++jt) s += *it * *jt;
+        return s;
+    }
+    static std::size_t count(aligned_vector<T>& a, T v)
+    {
+        std::size_t c = 0;
+        for (auto it = a.begin(); it != a.end(); ++it) c += (*it == v);
+        return c;
+    }
+    static T max(aligned_vector<T>& a)
+    {
+        T m = a[0];
+        for (auto it = a.begin(); it != a.end(); ++it) m = *it > m ? *it : m;
+        return m;
+    }
+    static void add(aligned_vector<T>& a, aligned_vector<T>& b, aligned_vector<T>& out)
+    {
+        auto jt = b.begin(), ot = out.begin();
+        for (auto it = a.begin(); it != a.end(); ++it, ++jt, ++ot) *ot = *it + *jt;
+    }
+};
+
+template <typename T>
+void run(const char* type_name)
+{
+    aligned_vector<T> a(kSize), b(kSize), out(kSize);
+    for (std::size_t i = 0; i < kSize; i++)
+    {
+        a[i] = T(i % 1000);
+        b[i] = T(i % 7);
+    }
+
+    std::printf("\n%s, %zu elements (ms per pass)\n", type_name, kSize);
+    std::printf("%-8s %8s %8s %8s %8s %8s\n", "", "sum", "dot", "count", "max", "add");
+    std::printf("%-8s %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+                "loop",
+                time_ms([&] { g_sink = plain<T>::sum(a); }, kRepeats),
+                time_ms([&] { g_sink = plain<T>::dot(a, b); }, kRepeats),
+                time_ms([&] { g_sink = double(plain<T>::count(a, T(999))); }, kRepeats),
+                time_ms([&] { g_sink = plain<T>::max(a); }, kRepeats),
+                time_ms([&] { plain<T>::add(a, b, out); }, kRepeats));
+
+    const simd::isa levels[] = { simd::isa::sse2, simd::isa::avx2, simd::isa::avx512 };
+    for (simd::isa level : levels)
+    {
+        if (level > simd::detected_isa())
+        {
+            break;
+        }
+        simd::force_isa(level);
+        std::printf("%-8s %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+                    simd::isa_name(level),
+                    time_ms([&] { g_sink = simd::sum(a); }, kRepeats),
+                    time_ms([&] { g_sink = simd::dot(a, b); }, kRepeats),
+                    time_ms([&] { g_sink = double(simd::count(a, T(999))); }, kRepeats),
+                    time_ms([&] { g_sink = simd::max(a); }, kRepeats),
+                    time_ms([&] { simd::transform(a, b, out, simd::plus()); }, kRepeats));
+    }
+    simd::force_isa(simd::detected_isa());
+}
+
+int main()
+{
+    std::printf("detected: %s\n", simd::isa_name(simd::detected_isa()));
+    run<float>("float");
+    run<double>("double");
+    run<std::int32_t>("int32");
+    return 0;
+}
@@ -0,0 +1,94 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_simd.h"
+#include "m_vector.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+using namespace m_std;
+
+// every instruction set must agree with the scalar loop, including the ragged tails
+template <typename T>
+void check_kernels(std::size_t n)
+{
+    aligned_vector<T> a(n), b(n), out(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        a[i] = T((i * 7) % 23) - T(5);
+        b[i] = T(i % 5);
+    }
+
+    assert(simd::count(a.data(), n, T(3)) == simd::detail::scalar::count(a.data(), n, T(3)));
+    assert(simd::find(a.data(), n, T(17)) == simd::detail::scalar::find(a.data(), n, T(17)));
+    assert(simd::find(a.data(), n, T(1000)) == n);
+    assert(simd::sum(a.data(), n) == simd::detail::scalar::sum(a.data(), n)); // small integers: exact in float too
+    assert(simd::dot(a, b) == simd::detail::scalar::dot(a.data(), b.data(), n));
+    if (n > 0)
+    {
+        assert(simd::min(a) == simd::detail::scalar::min_value(a.data(), n));
+        assert(simd::max(a) == simd::detail::scalar::max_value(a.data(), n));
+    }
+
+    simd::transform(a, b, out, simd::multiplies());
+    for (std::size_t i = 0; i < n; i++)
+    {
+        assert(out[i] == a[i] * b[i]);
+    }
+    simd::transform(a, b, out, simd::minus());
+    for (std::size_t i = 0; i < n; i++)
+    {
+        assert(out[i] == a[i] - b[i]);
+    }
+
+    // any other callable takes the plain loop
+    simd::transform(a, b, out, [](T x, T y) { return x > y ? x : y; });
+    for (std::size_t i = 0; i < n; i++)
+    {
+        assert(out[i] == (a[i] > b[i] ? a[i] : b[i]));
+    }
+
+    simd::fill(out, T(9));
+    assert(simd::count(out, T(9)) == n);
+
+    // sorted, with runs of equal values
+    for (std::size_t i = 0; i < n; i++)
+    {
+        a[i] = T(i / 3) - T(40);
+    }
+    for (T value : { T(-50), T(-40), T(-3), T(0), T(7), T(400) })
+    {
+        std::size_t expected = 0;
+        while (expected < n && a[expected] < value)
+        {
+            expected++;
+        }
+        assert(simd::lower_bound(a.data(), n, value) == expected);
+    }
+}
+
+int main()
+{
+    std::cout << "detected: " << simd::isa_name(simd::detected_isa()) << std::endl;
+
+    aligned_vector<float, 64> v(100);
+    assert(reinterpret_cast<std::uintptr_t>(v.data()) % 64 == 0);
+
+    const simd::isa levels[] = { simd::isa::scalar, simd::isa::sse2, simd::isa::avx2, simd::isa::avx512 };
+    for (simd::isa level : levels)
+    {
+        simd::force_isa(level);
+        for (std::size_t n : { 0, 1, 3, 15, 16, 17, 63, 64, 65, 1000 })
+        {
+            check_kernels<float>(n);
+            check_kernels<double>(n);
+            check_kernels<std::int32_t>(n);
+            check_kernels<std::int64_t>(n); // no vector ops, scalar path
+        }
+        std::cout << simd::isa_name(simd::active_isa()) << " ok" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "m_small_vector.h"
+#include "m_vector.hpp"
+#include "Timer.h"
+
+#include <cstdio>
+
+using namespace m_std;
+
+// heap allocator that counts how often it is hit
+static std::size_t g_allocations = 0;
+
+template <typename T>
+struct counting_allocator : allocator<T>
+{
+    counting_allocator() = default;
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept
+    {
+    }
+
+    template <typename U>
+    struct rebind
+    {
+        using other = counting_allocator<U>;
+    };
+
+    T* allocate(std::size_t n)
+    {
+        g_allocations++;
+        return allocator<T>::allocate(n);
+    }
+
+    T* reallocate(T* p, std::size_t old_n, std::size_t new_n)
+    {
+        g_allocations++;
+        return allocator<T>::reallocate(p, old_n, new_n);
+    }
+};
+
+// most vectors in the workload hold fewer than 8 elements
+constexpr int kVectors = 2000000;
+
+template <typename Vec>
+void run(const char* name)
+{
+    g_allocations = 0;
+    long long checksum = 0;
+
+    Timer t;
+    for (int v = 0; v < kVectors; v++)
+    {
+        Vec vec;
+        int len = (v % 16 == 0) ? 20 : v % 8; // one in 16 spills
+        for (int i = 0; i < len; i++)
+        {
+            vec.push_back(i);
+        }
+        checksum += vec.size();
+    }
+    t.stop();
+
+    std::printf("%-22s %8.2f ms  %9zu allocations  (checksum %lld)\n",
+                name,
+                t.getElapsedTime<microseconds>() / 1000.0,
+                g_allocations,
+                checksum);
+}
+
+int main()
+{
+    run<vector<int, counting_allocator<int>>>("vector<int>");
+    run<small_vector<int, 8, counting_allocator<int>>>("small_vector<int, 8>");
+    return 0;
+}
@@ -0,0 +1,53 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_pair.h"
+#include "m_simd.h"
+#include "m_soa_vector.h"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+
+using namespace m_std;
+
+int main()
+{
+    soa_vector<pair<int, std::string>> records;
+    records.reserve(16);
+    records.push_back(pair<int, std::string>(3, "three"));
+    records.emplace_back(1, "one");
+    records.emplace_back(4, std::string(10, 'x'));
+
+    // proxy reference: a pair of references into the two columns
+    auto r = records[1];
+    r.second += "!";
+    assert(records[1].second == "one!");
+    assert(records.begin()->first == 3);
+
+    // keys are one contiguous column
+    auto keys = records.column<0>();
+    assert(keys.size() == 3 && keys[2] == 4);
+    assert(simd::sum(keys) == 8 && simd::max(keys) == 4);
+
+    int key_sum = 0;
+    for (auto it = records.begin(); it != records.end(); ++it)
+    {
+        key_sum += (*it).first;
+        std::cout << (*it).first << " " << it->second << std::endl;
+    }
+    assert(key_sum == 8);
+
+    const auto& const_records = records;
+    assert(const_records.column<1>()[0] == "three" && (const_records.end() - const_records.begin()) == 3);
+
+    // the full random access set: n + it and every comparison
+    auto first = records.begin(), last = records.end();
+    assert(2 + first == first + 2 && (1 + first)->first == records[1].first);
+    assert(first < last && last > first && first <= first && first >= first && last >= first && !(last <= first));
+
+    records.pop_back();
+    assert(records.size() == 2 && records.column<1>().size() == 2);
+
+    return 0;
+}
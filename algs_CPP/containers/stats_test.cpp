@@ -0,0 +1,107 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_AVLTree.h"
+#include "m_vector.hpp"
+
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <utility>
+
+using namespace m_std;
+
+int main()
+{
+    // the default policy costs nothing
+    static_assert(sizeof(vector<int>) == sizeof(vector<int, allocator<int>, container_stats>) - sizeof(container_stats),
+                  "no_stats must not add to the vector");
+    static_assert(sizeof(AVLTree<int, int, std::less<int>, no_augment, heap_nodes>) == 3 * sizeof(void*), "no_stats must not add to the tree");
+
+    {
+        using counted_vector = vector<int, allocator<int>, container_stats>;
+
+        counted_vector v;
+        for (int i = 0; i < 100; i++)
+        {
+            v.push_back(i);
+        }
+        // 4 -> 8 -> 16 -> 32 -> 64 -> 128
+        assert(v.stats().reallocations == 5);
+        assert(v.stats().bytes_live == 128 * sizeof(int));
+        assert(v.memory_usage() == sizeof(v) + 128 * sizeof(int));
+
+        counted_vector copy(v);
+        assert(copy.stats().copies == 1 && copy.stats().allocations == 1);
+        counted_vector moved(std::move(copy));
+        assert(moved.stats().moves == 1 && moved.stats().allocations == 0);
+        moved = v;
+        assert(moved.stats().copies == 1);
+
+        std::ostringstream report;
+        v.stats().print(report);
+        assert(report.str().find("reallocations 5") != std::string::npos);
+    }
+
+    {
+        AVLTree<int, int, std::less<int>, no_augment, heap_nodes, container_stats> tree;
+        for (int i = 0; i < 1023; i++)
+        {
+            tree.insert(i, i); // ascending keys rotate all the way
+        }
+        assert(tree.size() == 1023 && tree.stats().nodes == 1023);
+        assert(tree.height() == 9 && tree.stats().height == 9);
+        assert(tree.stats().rotations > 0);
+        assert(tree.stats().bytes_live == 1023 * sizeof(AVLNode<int, int>));
+        assert(tree.memory_usage() == sizeof(tree) + 1023 * sizeof(AVLNode<int, int>));
+
+        AVLTree<int, int, std::less<int>, no_augment, heap_nodes, container_stats> copy(tree);
+        assert(copy.size() == 1023 && copy.height() == 9 && copy.stats().copies == 1);
+
+        for (int i = 0; i < 1023; i++)
+        {
+            tree.erase(tree.find(i));
+        }
+        assert(tree.empty() && tree.height() == -1 && tree.stats().bytes_live == 0);
+        assert(copy.find(500) != nullptr && copy.find(500)->value() == 500);
+    }
+
+    {
+        // pooled nodes: erased nodes are reused, clear hands the slabs back
+        AVLTree<int, std::string, std::less<int>, no_augment, pooled_nodes, container_stats> tree;
+        for (int i = 0; i < 5000; i++)
+        {
+            tree.insert(i, std::string(40, char('a' + i % 26)));
+        }
+        std::size_t _reserved = tree.memory_usage();
+        assert(_reserved >= sizeof(tree) + 5000 * sizeof(AVLNode<int, std::string>));
+
+        for (int i = 0; i < 5000; i += 2)
+        {
+            tree.erase(tree.find(i));
+        }
+        for (int i = 0; i < 5000; i += 2)
+        {
+            tree.insert(i, std::string(40, 'z'));
+        }
+        assert(tree.size() == 5000 && tree.memory_usage() == _reserved);
+        assert(tree.find(4998)->value() == std::string(40, 'z'));
+        tree.clear();
+        assert(tree.empty() && tree.stats().bytes_live == 0 && tree.memory_usage() == sizeof(tree));
+        for (int i = 0; i < 5000; i++)
+        {
+            tree.insert(i, std::string(40, char('a' + i % 26)));
+        }
+
+        AVLTree<int, std::string, std::less<int>, no_augment, pooled_nodes, container_stats> moved(std::move(tree));
+        assert(moved.size() == 5000 && tree.empty());
+        assert(moved.find(4999)->value() == std::string(40, char('a' + 4999 % 26)));
+
+        moved.clear();
+        assert(moved.empty() && moved.memory_usage() == sizeof(moved));
+        moved.insert(7, "seven");
+        assert(moved.size() == 1 && moved.find(7)->value() == "seven");
+    }
+
+    return 0;
+}
@@ -1,8 +1,66 @@
+// tests rely on assert, keep it in release builds
+#undef NDEBUG
+
+#include "m_mmap_allocator.h"
+#include "m_small_vector.h"
 #include "m_vector.hpp"
 
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <sstream>
 #include <string>
 
 using namespace m_std;
+
+// move may throw, so growth has to copy to keep the strong guarantee
+struct CopyOnGrow
+{
+    int copies = 0;
+
+    CopyOnGrow() = default;
+    CopyOnGrow(const CopyOnGrow& other) :
+        copies(other.copies + 1) { }
+    CopyOnGrow(CopyOnGrow&& other) noexcept(false) :
+        copies(other.copies) { }
+};
+
+// move-only with a move that throws on the countdown; live counts the objects around
+struct ThrowingMove
+{
+    static int live;
+    static int moves_left;
+
+    int value;
+
+    explicit ThrowingMove(int v) :
+        value(v) { live++; }
+    ThrowingMove(ThrowingMove&& other) noexcept(false) :
+        value(other.value)
+    {
+        if (moves_left-- == 0)
+        {
+            throw 1;
+        }
+        live++;
+    }
+    ThrowingMove(const ThrowingMove&) = delete;
+    ThrowingMove& operator=(ThrowingMove&& other)
+    {
+        value = other.value;
+        return *this;
+    }
+    ~ThrowingMove() { live--; }
+};
+
+int ThrowingMove::live       = 0;
+int ThrowingMove::moves_left = -1;
+
+struct Point
+{
+    double x, y;
+};
+
 int main()
 {
     vector<std::string> v_str;
@@ -28,6 +86,189 @@ int main()
     v_str2 = v_str3;
     v_str2 = std::move(v_str3);
 
+    // trivially copyable: growth and copy are plain byte copies
+    vector<Point> v_pts;
+    for (int i = 0; i < 1000; i++)
+    {
+        v_pts.push_back({ double(i), -double(i) });
+    }
+    vector<Point> v_pts2 = v_pts;
+    assert(v_pts2.size() == 1000 && v_pts2[999].x == 999.0 && v_pts2[999].y == -999.0);
+
+    vector<CopyOnGrow> v_grow;
+    for (int i = 0; i < 5; i++)
+    {
+        v_grow.push_back(CopyOnGrow());
+    }
+    assert(v_grow[0].copies == 1); // went through one regrow from capacity 4 to 8
+
+    // bulk APIs: one allocation per batch
+    vector<int> v_int;
+    v_int.reserve(100);
+    int batch[] = { 1, 2, 3, 4, 5 };
+    v_int.append(batch, batch + 5);
+    v_int.insert(v_int.begin() + 1, batch, batch + 2); // 1 1 2 2 3 4 5
+    assert(v_int.capacity() == 100 && v_int.size() == 7 && v_int[1] == 1 && v_int[3] == 2);
+    v_int.erase(v_int.begin(), v_int.begin() + 3); // 2 3 4 5
+    assert(v_int.size() == 4 && v_int[0] == 2);
+    v_int.shrink_to_fit();
+    assert(v_int.capacity() == 4);
+    v_int.resize(6, v_int[0]); // 2 3 4 5 2 2
+    assert(v_int.size() == 6 && v_int[5] == 2);
+
+    std::string words[] = { "a", "b", "c" };
+    vector<std::string> v_words(words, words + 3);
+    v_words.reserve(16); // exercise the in-place shifting paths
+    v_words.insert(v_words.begin() + 1, words, words + 3); // a a b c b c
+    v_words.insert(v_words.begin(), v_words[5]);           // c a a b c b c
+    assert(v_words.size() == 7 && v_words[0] == "c" && v_words[2] == "a" && v_words[6] == "c");
+    v_words.erase(v_words.begin() + 1, v_words.end() - 1); // c c
+    assert(v_words.size() == 2 && v_words[1] == "c");
+    v_words.assign(words, words + 2);
+    assert(v_words.size() == 2 && v_words[1] == "b");
+
+    // a throwing move while an insert regrows: nothing leaks, nothing is destroyed twice.
+    // the new element, then the two before the gap, then the two after move
+    for (int fail_at = 0; fail_at < 5; fail_at++)
+    {
+        {
+            vector<ThrowingMove> v_throw;
+            for (int i = 0; i < 4; i++)
+            {
+                v_throw.emplace_back(i);
+            }
+            assert(v_throw.size() == v_throw.capacity());
+            ThrowingMove extra[] = { ThrowingMove(9) };
+
+            ThrowingMove::moves_left = fail_at;
+            bool thrown              = false;
+            try
+            {
+                v_throw.insert(v_throw.begin() + 2, std::make_move_iterator(extra), std::make_move_iterator(extra + 1));
+            }
+            catch (int)
+            {
+                thrown = true;
+            }
+            ThrowingMove::moves_left = -1;
+            assert(thrown && v_throw.size() == 4 && ThrowingMove::live == 5);
+        }
+        assert(ThrowingMove::live == 0);
+    }
+
+    // small_vector: inline until it outgrows N, then behaves like vector
+    small_vector<std::string, 4> sv;
+    for (int i = 0; i < 4; i++)
+    {
+        sv.push_back(std::to_string(i));
+    }
+    assert(sv.is_inline() && sv.capacity() == 4);
+    sv.emplace_back(sv[0]); // aliasing argument across the spill
+    assert(!sv.is_inline() && sv.size() == 5 && sv[4] == "0");
+
+    small_vector<std::string, 4> sv_moved = std::move(sv); // heap buffer changes hands
+    assert(sv.empty() && sv.is_inline() && sv_moved.size() == 5);
+
+    small_vector<int, 8> sv_small;
+    sv_small.push_back(7);
+    small_vector<int, 8> sv_small2 = std::move(sv_small); // inline elements are relocated
+    assert(sv_small2.is_inline() && sv_small2[0] == 7);
+
+    // reserve / insert / erase take vector's arguments
+    small_vector<std::string, 4> sv_edit;
+    sv_edit.reserve(2);
+    assert(sv_edit.is_inline());
+    sv_edit.push_back("a");
+    sv_edit.push_back("d");
+    std::string bc[] = { "b", "c" };
+    sv_edit.insert(sv_edit.begin() + 1, bc, bc + 2);
+    sv_edit.insert(sv_edit.begin(), sv_edit[3]); // aliasing value across the spill
+    assert(!sv_edit.is_inline() && sv_edit.size() == 5);
+    assert(sv_edit[0] == "d" && sv_edit[1] == "a" && sv_edit[2] == "b" && sv_edit[3] == "c" && sv_edit[4] == "d");
+    sv_edit.erase(sv_edit.begin(), sv_edit.begin() + 2);
+    sv_edit.erase(sv_edit.end() - 1);
+    assert(sv_edit.size() == 2 && sv_edit[0] == "b" && sv_edit[1] == "c");
+    sv_edit.reserve(100);
+    assert(sv_edit.capacity() == 100 && sv_edit[1] == "c");
+
+    // the const side reads and iterates like vector's
+    const small_vector<std::string, 4>& sv_const = sv_edit;
+    std::string                         sv_joined;
+    for (const std::string& s : sv_const)
+    {
+        sv_joined += s;
+    }
+    assert(sv_joined == "bc" && sv_const[0] == "b" && sv_const.data() == &sv_const[0]);
+    small_vector<std::string, 4>::const_iterator sv_cit = sv_const.begin();
+    assert(sv_const.end() - sv_cit == 2);
+
+    sv_edit.resize(6, sv_edit[0]); // aliasing value
+    assert(sv_edit.size() == 6 && sv_edit[5] == "b");
+    sv_edit.resize(1);
+    assert(sv_edit.size() == 1 && sv_edit[0] == "b");
+    sv_edit.resize(3);
+    assert(sv_edit[2].empty());
+    sv_edit.clear();
+    assert(sv_edit.empty() && sv_edit.capacity() == 100);
+
+    small_vector<int, 8> sv_ints;
+    std::istringstream   sv_in("3 4 5");
+    sv_ints.push_back(1);
+    sv_ints.push_back(6);
+    sv_ints.insert(sv_ints.begin() + 1, std::istream_iterator<int>(sv_in), std::istream_iterator<int>()); // single pass
+    sv_ints.erase(sv_ints.begin() + 2);
+    assert(sv_ints.size() == 4 && sv_ints[0] == 1 && sv_ints[1] == 3 && sv_ints[2] == 5 && sv_ints[3] == 6);
+
+    // huge_vector: page mappings that grow by remapping
+    huge_vector<long long> v_huge;
+    for (long long i = 0; i < 1000000; i++)
+    {
+        v_huge.push_back(i);
+    }
+    assert(v_huge.size() == 1000000 && v_huge[0] == 0 && v_huge[999999] == 999999);
+    v_huge.shrink_to_fit();
+    assert(v_huge[123456] == 123456);
+
+    // arena: vectors bump-allocate, everything goes back in one shot
+    arena a;
+    {
+        vector<std::string, arena_allocator<std::string>> v_arena{ arena_allocator<std::string>(a) };
+        for (int i = 0; i < 100; i++)
+        {
+            v_arena.push_back(std::to_string(i));
+        }
+        assert(v_arena.size() == 100 && v_arena[99] == "99");
+
+        // unequal arenas: move assignment falls back to element-wise move
+        arena                                             b;
+        vector<std::string, arena_allocator<std::string>> v_other{ arena_allocator<std::string>(b) };
+        v_other = std::move(v_arena);
+        assert(v_other.size() == 100 && v_other[42] == "42");
+    }
+    a.release();
+
+    // reset keeps the largest block, but growth past it starts over from the initial size
+    arena a_reset(1024);
+    a_reset.allocate(1000);
+    a_reset.allocate(1000);
+    a_reset.allocate(3000); // blocks of 1024, 2048, 4096
+    a_reset.reset();
+    a_reset.allocate(4000);
+    void* a_spill = a_reset.allocate(500); // the kept block is full, a new one is added
+    assert(!a_reset.try_resize_last(a_spill, 500, 2000) && a_reset.try_resize_last(a_spill, 500, 1000));
+
+    // pool: small vectors recycle fixed-size blocks
+    fixed_pool pool(64);
+    for (int round = 0; round < 3; round++)
+    {
+        vector<int, pool_allocator<int>> v_pool{ pool_allocator<int>(pool) };
+        for (int i = 0; i < 40; i++) // outgrows the 64 byte block, falls back to the heap
+        {
+            v_pool.push_back(i);
+        }
+        assert(v_pool[39] == 39);
+    }
+
     // std::cin.get();
 
     return 0;
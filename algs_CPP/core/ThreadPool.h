@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace m_std
+{
+
+// fixed set of worker threads, one deque each. a worker pushes and pops its own deque
+// at the back (newest first, so a fork-join split keeps its data hot) and, when that
+// runs dry, steals the oldest task from the front of another deque, which is usually
+// the biggest piece of work left. tasks submitted from outside are spread round-robin.
+//
+// a bare submitted task must not throw; use a TaskGroup to get exceptions back.
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency()) :
+        m_stop(false), m_queued(0), m_nextQueue(0)
+    {
+        threads = std::max<std::size_t>(threads, 1);
+        for (std::size_t i = 0; i < threads; i++)
+        {
+            m_queues.emplace_back(new WorkQueue());
+        }
+        for (std::size_t i = 0; i < threads; i++)
+        {
+            m_threads.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // finishes everything already queued, then joins
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> _guard(m_sleepLock);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& _thread : m_threads)
+        {
+            _thread.join();
+        }
+    }
+
+    // shared pool with one worker per hardware thread
+    static ThreadPool& instance()
+    {
+        static ThreadPool _pool;
+        return _pool;
+    }
+
+    std::size_t threadCount() const { return m_threads.size(); }
+
+    void submit(Task task)
+    {
+        std::size_t _index = currentWorker();
+        if (_index == no_worker)
+        {
+            _index = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        }
+
+        // counted under the queue lock, so no pop can decrement before this increment
+        {
+            std::lock_guard<std::mutex> _guard(m_queues[_index]->lock);
+            m_queues[_index]->tasks.push_back(std::move(task));
+            m_queued.fetch_add(1, std::memory_order_release);
+        }
+
+        // taking the lock orders this against a worker that is about to sleep
+        {
+            std::lock_guard<std::mutex> _guard(m_sleepLock);
+        }
+        m_wake.notify_one();
+    }
+
+    // run one queued task on the calling thread, if there is any. lets a thread that
+    // waits for its own tasks help instead of blocking
+    bool runPendingTask()
+    {
+        Task _task;
+        if (!takeTask(currentWorker(), _task))
+        {
+            return false;
+        }
+        _task();
+        return true;
+    }
+
+private:
+    struct WorkQueue
+    {
+        std::mutex       lock;
+        std::deque<Task> tasks;
+    };
+
+    static constexpr std::size_t no_worker = std::size_t(-1);
+
+    struct WorkerIdentity
+    {
+        const ThreadPool* pool  = nullptr;
+        std::size_t       index = no_worker;
+    };
+
+    static WorkerIdentity& identity()
+    {
+        static thread_local WorkerIdentity _identity;
+        return _identity;
+    }
+
+    std::size_t currentWorker() const
+    {
+        const WorkerIdentity& _identity = identity();
+        return _identity.pool == this ? _identity.index : no_worker;
+    }
+
+    // own deque from the back, then everybody else's from the front
+    bool takeTask(std::size_t self, Task& task)
+    {
+        if (m_queued.load(std::memory_order_acquire) == 0)
+        {
+            return false;
+        }
+
+        if (self != no_worker && popBack(*m_queues[self], task))
+        {
+            return true;
+        }
+
+        std::size_t _start = self == no_worker ? 0 : self + 1;
+        for (std::size_t i = 0; i < m_queues.size(); i++)
+        {
+            std::size_t _victim = (_start + i) % m_queues.size();
+            if (_victim != self && popFront(*m_queues[_victim], task))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool popBack(WorkQueue& queue, Task& task)
+    {
+        std::lock_guard<std::mutex> _guard(queue.lock);
+        if (queue.tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool popFront(WorkQueue& queue, Task& task)
+    {
+        std::lock_guard<std::mutex> _guard(queue.lock);
+        if (queue.tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void workerLoop(std::size_t index)
+    {
+        identity() = WorkerIdentity{ this, index };
+
+        while (true)
+        {
+            Task _task;
+            if (takeTask(index, _task))
+            {
+                _task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> _lock(m_sleepLock);
+            m_wake.wait(_lock, [this] { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+            if (m_stop && m_queued.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread>                m_threads;
+
+    std::mutex              m_sleepLock;
+    std::condition_variable m_wake;
+    bool                    m_stop;
+
+    std::atomic<std::size_t> m_queued;
+    std::atomic<std::size_t> m_nextQueue;
+};
+
+// a batch of tasks that are waited for together. wait() runs queued work while it
+// waits, so a task can fork a group of its own without tying up a worker, and it
+// rethrows the first exception any task threw.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::instance()) :
+        m_pool(pool), m_pending(0)
+    {
+    }
+
+    TaskGroup(const TaskGroup&)            = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // tasks may still point into the enclosing frame
+    ~TaskGroup()
+    {
+        helpUntilDone();
+    }
+
+    template <typename Fn>
+    void run(Fn&& fn)
+    {
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        m_pool.submit([this, _fn = std::forward<Fn>(fn)]() mutable {
+            try
+            {
+                _fn();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> _guard(m_errorLock);
+                if (!m_error)
+                {
+                    m_error = std::current_exception();
+                }
+            }
+            // last touch of this group, the waiter may return right after
+            m_pending.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    void wait()
+    {
+        helpUntilDone();
+        if (m_error)
+        {
+            std::exception_ptr _error = std::move(m_error);
+            m_error                   = nullptr;
+            std::rethrow_exception(_error);
+        }
+    }
+
+    ThreadPool& pool() const { return m_pool; }
+
+private:
+    void helpUntilDone()
+    {
+        while (m_pending.load(std::memory_order_acquire) != 0)
+        {
+            if (!m_pool.runPendingTask())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    ThreadPool&              m_pool;
+    std::atomic<std::size_t> m_pending;
+    std::mutex               m_errorLock;
+    std::exception_ptr       m_error;
+};
+
+} // namespace m_std
@@ -33,4 +33,17 @@ private:
     time_point<steady_clock> m_start;
 
     duration<double> m_duration;
-};
\ No newline at end of file
+};
+
+// wall time of fn in milliseconds, averaged over repeats calls
+template <typename Fn>
+double time_ms(Fn&& fn, int repeats = 1)
+{
+    Timer t;
+    for (int r = 0; r < repeats; r++)
+    {
+        fn();
+    }
+    t.stop();
+    return t.getElapsedTime<microseconds>() / 1000.0 / repeats;
+}